@@ -1,11 +1,18 @@
 #include "art.hpp"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <exception>
 #include <iostream>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <utility>
 #include <vector>
 
 #include "common.hpp"
+#include "epoch.hpp"
 #include "leaf.hpp"
 #include "logger.hpp"
 #include "node.hpp"
@@ -13,25 +20,95 @@
 #include "node256.hpp"
 #include "node4.hpp"
 #include "node48.hpp"
+#include "parallel.hpp"
 #include "prefix.hpp"
+#include "snapshot.hpp"
 #include "string_type.hpp"
+#include "value_arena.hpp"
 
 namespace duckart {
 
 // ART
-ART::ART() : root(std::make_unique<Node>()) {
+ART::ART(bool concurrent, std::shared_ptr<BlockDirectory> directory)
+    : root(std::make_unique<Node>()), concurrent(concurrent) {
+    if (!directory) {
+        directory = std::make_shared<BlockDirectory>();
+    }
     allocators.push_back(
-        std::make_unique<FixedSizeAllocator>(sizeof(Leaf), 512));
+        std::make_unique<FixedSizeAllocator>(sizeof(Leaf), 512, directory));
     allocators.push_back(
-        std::make_unique<FixedSizeAllocator>(sizeof(Node4), 512));
+        std::make_unique<FixedSizeAllocator>(sizeof(Node4), 512, directory));
     allocators.push_back(
-        std::make_unique<FixedSizeAllocator>(sizeof(Node16), 512));
+        std::make_unique<FixedSizeAllocator>(sizeof(Node16), 512, directory));
     allocators.push_back(
-        std::make_unique<FixedSizeAllocator>(sizeof(Node48), 512));
+        std::make_unique<FixedSizeAllocator>(sizeof(Node48), 512, directory));
     allocators.push_back(
-        std::make_unique<FixedSizeAllocator>(sizeof(Node256), 512));
+        std::make_unique<FixedSizeAllocator>(sizeof(Node256), 512, directory));
     allocators.push_back(
-        std::make_unique<FixedSizeAllocator>(sizeof(Prefix), 512));
+        std::make_unique<FixedSizeAllocator>(sizeof(Prefix), 512, directory));
+    for (uint8_t size_class = 1; size_class < PREFIX_SEGMENT_CLASSES; size_class++) {
+        allocators.push_back(
+            std::make_unique<FixedSizeAllocator>(PREFIX_SEGMENT_SIZES[size_class], 512, directory));
+    }
+    for (auto& allocator : allocators) {
+        allocator->SetConcurrent(concurrent);
+        allocator->SetThreadCache(concurrent);
+    }
+    value_arena = std::make_unique<ValueArena>(directory);
+    value_arena->SetConcurrent(concurrent);
+    if (concurrent) {
+        epochs = std::make_unique<EpochManager>([this](const Node& node) { FreeRetired(node); });
+    }
+}
+
+ART::~ART() {
+    ReclaimRetired();
+    // the allocators release their blocks with the tree, but not the bytes of the values that
+    // are larger than the arena slabs, which the leaves own
+    auto& leaf_allocator = GetAllocator(NType::LEAF);
+    leaf_allocator.FlushThreadCaches();
+    for (auto blockId : leaf_allocator.GetBlockIds()) {
+        leaf_allocator.ForEachSlot(GetDirectory()->Get(blockId), [&](char* slot) {
+            auto& value = reinterpret_cast<Leaf*>(slot)->value;
+            if (ValueArena::IsOwned(value)) {
+                value_arena->Release(value);
+            }
+        });
+    }
+}
+
+const std::shared_ptr<BlockDirectory>& ART::GetDirectory() const { return allocators[0]->GetDirectory(); }
+
+FixedSizeAllocator& ART::GetSlotAllocator(const Node& node) const {
+    if (node.getTag() == NType::PREFIX) {
+        return GetPrefixAllocator(GetAllocator(NType::PREFIX).Get<const Prefix>(node)->size_class);
+    }
+    return GetAllocator(node.getTag());
+}
+
+//===--------------------------------------------------------------------===//
+// Retired nodes
+//===--------------------------------------------------------------------===//
+void ART::Retire(const Node& node) { epochs->Retire(node); }
+
+void ART::ReclaimRetired() {
+    if (epochs) {
+        epochs->ReclaimAll();
+    }
+}
+
+void ART::FreeRetired(const Node& node) {
+    if (node.getTag() == NType::LEAF) {
+        auto& leaf = Node::RefMutable<Leaf>(*this, node, NType::LEAF);
+        auto prefix = leaf.prefix;
+        while (prefix.getTag() == NType::PREFIX) {
+            auto next = Node::RefMutable<Prefix>(*this, prefix, NType::PREFIX).ptr;
+            GetSlotAllocator(prefix).Free(prefix);
+            prefix = next;
+        }
+        value_arena->Release(leaf.value);
+    }
+    GetSlotAllocator(node).Free(node);
 }
 
 // https://github.com/armon/libart/blob/master/src/art.c#L549
@@ -40,38 +117,33 @@ ART::ART() : root(std::make_unique<Node>()) {
 // newest
 // https://github.com/duckdb/duckdb/blob/main/src/execution/index/art/art.cpp#L607
 bool ART::Insert(Node& node, const ARTKey& key, const Node& leaf, idx_t depth) {
+    if (depth == 0) {
+        CheckWritable();
+    }
     // node is currently empty, create a leaf here with the key
     if (node.getTag() == NType::NODE_DUMMY) {
         LOG_DEBUG("node is currently empty...");
         D_ASSERT(depth <= key.len);
 
-        auto& leaf_node =
-            Node::RefMutable<Leaf>(*this, leaf, NType::LEAF);
-
         // copy key to prefix of Leaf
-        Node prefix;
-        reference<Node> ref_prefix(prefix);
-        Prefix::New(*this, ref_prefix, key, depth, key.len - depth);
-        leaf_node.prefix = prefix;
-
-        node = leaf;
+        node = AttachLeaf(leaf, key, depth);
         return true;
     }
 
     auto node_type = node.getTag();
 
     // If at a leaf
-    if (node_type == NType::LEAF) {
-        auto& leaf_node =
-            Node::RefMutable<Leaf>(*this, node, NType::LEAF);
-        auto& leaf_node_new =
-            Node::RefMutable<Leaf>(*this, leaf, NType::LEAF);
+    if (Leaf::IsLeaf(node)) {
+        auto leaf_depth = depth;
 
-        // record first Perfix of perfix chain
-        reference<Node> l_first = leaf_node.prefix;
+        // record first Perfix of perfix chain, an inlined leaf is its own prefix
+        reference<Node> l_first = node;
+        if (Leaf::HasValue(node)) {
+            l_first = Node::RefMutable<Leaf>(*this, node, NType::LEAF).prefix;
+        }
 
         // find out mismatch position
-        reference<Node> l_prefix = leaf_node.prefix;
+        reference<Node> l_prefix = l_first;
         auto mis_match_pos =
             Prefix::TraverseMutable(*this, l_prefix, key, depth);
 
@@ -79,9 +151,26 @@ bool ART::Insert(Node& node, const ARTKey& key, const Node& leaf, idx_t depth) {
         if (mis_match_pos == INVALID_INDEX) {
             LOG_DEBUG("leaf is match...");
 
-            // update value
-            leaf_node.value = leaf_node_new.value;
-            return true;
+            if (Leaf::HasValue(node) && Leaf::HasValue(leaf)) {
+                auto& leaf_node =
+                    Node::RefMutable<Leaf>(*this, node, NType::LEAF);
+                auto& leaf_node_new =
+                    Node::RefMutable<Leaf>(*this, leaf, NType::LEAF);
+
+                // update value (in place, if it has the same size class), the ART owns
+                // the new leaf, so free it unless it is the leaf that is already in the tree
+                value_arena->Assign(leaf_node.value, leaf_node_new.value);
+                if (!node.SameSlot(leaf)) {
+                    Node new_leaf = leaf;
+                    Node::Free(*this, new_leaf);
+                }
+                return true;
+            }
+
+            // an inlined leaf or a row id set is involved, so replace the old leaf with the new one
+            Node::Free(*this, node);
+            node = Node();
+            return Insert(node, key, leaf, leaf_depth);
         }
 
         // if not match , we must split the leaf into a node4
@@ -92,30 +181,21 @@ bool ART::Insert(Node& node, const ARTKey& key, const Node& leaf, idx_t depth) {
             Node4::New(*this, ref_node4);
             auto& n4 = Node::RefMutable<Node4>(*this, ref_node4, NType::NODE_4);
 
-            //(1) add first Leaf to Node4
-            Node l_child;          
-            auto l_prefix_byte =
-                Prefix::GetByte(*this, l_prefix, mis_match_pos);
-            Prefix::Split(*this, l_prefix, l_child, mis_match_pos);        
-
+            //(1) add first Leaf to Node4. The leaf keeps its prefix, whose segment holds
+            // the rest of its key, and only drops the bytes that the Node4 now covers. The
+            // Node4 takes these bytes from the key, so no prefix is split or copied
+            auto l_prefix_byte = Prefix::GetByte(*this, l_prefix, mis_match_pos);
+            Prefix::New(*this, n4.inline_prefix, n4.prefix, key, leaf_depth, depth - leaf_depth);
+            Prefix::Trim(*this, l_first.get(), depth - leaf_depth + 1);
             Node4::InsertChild(*this, node4, l_prefix_byte, node);
-            // set first half  of Prefix chain  to prefix of Node4
-            n4.prefix = l_first;
-            // set second half Prefix chain to leaf
-            // leaf_node.prefix = l_child;         
-            node.SetPrefix(*this, l_child);
-      
+
             //(2)add second Leaf to Node4
             auto r_prefix_byte = key[depth];
-
-            Node r_prefix;
-            reference<Node> ref_prefix(r_prefix);
-            Prefix::New(*this, ref_prefix, key, depth + 1, key.len - depth - 1);
-            leaf_node_new.prefix = r_prefix;
-            Node4::InsertChild(*this, node4, r_prefix_byte, leaf);                  
+            Node4::InsertChild(*this, node4, r_prefix_byte,
+                               AttachLeaf(leaf, key, depth + 1));
 
             // swap pointer
-            Node::Swap(node, node4);  
+            Node::Swap(node, node4);
 
             return true;
         }
@@ -139,6 +219,23 @@ bool ART::InsertIntoNode(Node& node, const ARTKey& key, const Node& leaf,
     LOG_DEBUG("Insert Into Node...");
     D_ASSERT(depth < key.len);
 
+    // a short prefix is in the node header, split it there if the key does not match it
+    auto inline_mismatch_pos = Prefix::Traverse(node.GetInlinePrefix(*this), key, depth);
+    if (inline_mismatch_pos != INVALID_INDEX) {
+        LOG_DEBUG("part match or not match inline prefix ...");
+        auto& inlined = GetInlinePrefixMutable(node);
+        Node node4;
+        auto& n4 = Node4::New(*this, node4);
+        auto prefix_byte = inlined.data[inline_mismatch_pos];
+        Prefix::Split(inlined, n4.inline_prefix, inline_mismatch_pos);
+
+        // swap pointer between old Node and Node4, then add old node and child
+        Node::Swap(node, node4);
+        Node4::InsertChild(*this, node, prefix_byte, node4);
+        Node4::InsertChild(*this, node, key[depth], AttachLeaf(leaf, key, depth + 1));
+        return true;
+    }
+
     // get Prefix chain of Node
     Node p_node;
     reference<Node> ref_prefix_node(p_node);
@@ -146,17 +243,12 @@ bool ART::InsertIntoNode(Node& node, const ARTKey& key, const Node& leaf,
 
     // record first Perfix of perfix chain
     reference<Node> l_first = ref_prefix_node;
-    auto temp_depth = depth;
 
     // if node have prefix
     if (ref_prefix_node.get().getTag() != NType::NODE_DUMMY) {
         auto mis_match_pos =
             Prefix::TraverseMutable(*this, ref_prefix_node, key, depth);
 
-        auto len = depth - temp_depth;
-        auto& prefix =
-            Node::RefMutable<Prefix>(*this, ref_prefix_node, NType::PREFIX);
-
         // if key contain prefix of Node
         if (mis_match_pos == INVALID_INDEX) {
             LOG_DEBUG("key contain prefix of Node ...");
@@ -165,22 +257,16 @@ bool ART::InsertIntoNode(Node& node, const ARTKey& key, const Node& leaf,
             // if child exists
             if (child.getTag() != NType::NODE_DUMMY) {
                 // return Insert(child, key, leaf, depth + 1);
+                auto old_child = child;
                 auto isOK = Insert(child, key, leaf, depth + 1);
-                if (isOK) {
+                if (isOK && child.Get() != old_child.Get()) {
                     node.ReplaceChild(*this, prefix_byte,
                                       child);  // add in v0.84
                 }
                 return isOK;
             } else {
-                Node prefix_node;
-                reference<Node> ref_prefix(prefix_node);
-                Prefix::New(*this, ref_prefix, key, depth + 1,
-                            key.len - depth - 1);
-
-                auto& leaf_node =
-                    Node::RefMutable<Leaf>(*this, leaf, NType::LEAF);
-                leaf_node.prefix = ref_prefix;
-                Node::InsertChild(*this, node, prefix_byte, leaf);
+                Node::InsertChild(*this, node, prefix_byte,
+                                  AttachLeaf(leaf, key, depth + 1));
                 return true;
             }
 
@@ -198,9 +284,11 @@ bool ART::InsertIntoNode(Node& node, const ARTKey& key, const Node& leaf,
                 Prefix::GetByte(*this, ref_prefix_node, mis_match_pos);
             Prefix::Split(*this, ref_prefix_node, second_part, mis_match_pos);
 
-            // set  prefix of new Node4
+            // set  prefix of new Node4, both parts of the chain might fit into the headers now
             n4.prefix = l_first;
             node.SetPrefix(*this, second_part);
+            Prefix::Pack(*this, n4.inline_prefix, n4.prefix);
+            node.PackPrefix(*this);
 
             // swap pointer between old Node and Node4
             Node::Swap(node, node4);
@@ -209,16 +297,9 @@ bool ART::InsertIntoNode(Node& node, const ARTKey& key, const Node& leaf,
             Node4::InsertChild(*this, node, prefix_byte, node4);
 
             // add child
-            auto& leaf_node_new =
-                Node::RefMutable<Leaf>(*this, leaf, NType::LEAF);
-            auto c_prefix_byte = key[depth];       
-
-            Node c_prefix;
-            reference<Node> ref_c_prefix(c_prefix);
-            Prefix::New(*this, ref_c_prefix, key, depth + 1,
-                        key.len - depth - 1);
-            leaf_node_new.prefix = ref_c_prefix;
-            Node4::InsertChild(*this, node, c_prefix_byte, leaf);
+            auto c_prefix_byte = key[depth];
+            Node4::InsertChild(*this, node, c_prefix_byte,
+                               AttachLeaf(leaf, key, depth + 1));
 
             return true;
         }
@@ -229,22 +310,17 @@ bool ART::InsertIntoNode(Node& node, const ARTKey& key, const Node& leaf,
         auto child = node.GetChild(*this, prefix_byte);
         // if child exists
         if (child.getTag() != NType::NODE_DUMMY) {
+            // only a replaced child changes the node, so that its block stays clean otherwise
+            auto old_child = child;
             auto isOK = Insert(child, key, leaf, depth + 1);
-            if (isOK) {
+            if (isOK && child.Get() != old_child.Get()) {
                 node.ReplaceChild(*this, prefix_byte, child);  // add in v0.84
             }
             return isOK;
         } else {
             // No child, insert new leaf
-            Node prefix_node;
-            reference<Node> ref_prefix(prefix_node);
-            Prefix::New(*this, ref_prefix, key, depth + 1, key.len - depth - 1);
-
-            auto& leaf_node =
-                Node::RefMutable<Leaf>(*this, leaf, NType::LEAF);
-            leaf_node.prefix = ref_prefix;
-         
-            Node::InsertChild(*this, node, prefix_byte, leaf);
+            Node::InsertChild(*this, node, prefix_byte,
+                              AttachLeaf(leaf, key, depth + 1));
 
             return true;
         }
@@ -252,33 +328,60 @@ bool ART::InsertIntoNode(Node& node, const ARTKey& key, const Node& leaf,
 
     return false;
 }
+Node ART::AttachLeaf(const Node& leaf, const ARTKey& key, idx_t depth) {
+    Node prefix;
+    reference<Node> ref_prefix(prefix);
+    Prefix::New(*this, ref_prefix, key, depth, key.len - depth);
+
+    if (Leaf::HasValue(leaf)) {
+        Node::RefMutable<Leaf>(*this, leaf, NType::LEAF).prefix = prefix;
+        return leaf;
+    }
+
+    // the key ends here, the parent points to the inlined leaf itself
+    if (prefix.getTag() != NType::PREFIX) {
+        return leaf;
+    }
+    // otherwise, the last prefix of the chain points to the inlined leaf
+    reference<Node> tail(prefix);
+    while (tail.get().getTag() == NType::PREFIX) {
+        tail = Node::RefMutable<Prefix>(*this, tail, NType::PREFIX).ptr;
+    }
+    tail.get() = leaf;
+    return prefix;
+}
+
 Node ART::Search(Node& node, const ARTKey& key, idx_t depth) {
     if (node.getTag() == NType::NODE_DUMMY) {
         // Empty node, key not found
         return Node();
     }
 
-    if (node.getTag() == NType::LEAF) {
-        // At a leaf node, check if the key matches
-        auto& leaf = Node::RefMutable<Leaf>(*this, node, NType::LEAF);
-
-        // Check if the key matches the prefix
-        reference<Node> prefix = leaf.prefix;
-        auto mis_match_pos = Prefix::TraverseMutable(*this, prefix, key, depth);
+    if (Leaf::IsLeaf(node)) {
+        // At a leaf node, check if the key matches the prefix, the chain ahead of an
+        // inlined leaf ends in the inlined leaf
+        reference<const Node> prefix = node;
+        if (Leaf::HasValue(node)) {
+            prefix = Node::Ref<const Leaf>(*this, node, NType::LEAF).prefix;
+        }
+        auto mis_match_pos = Prefix::Traverse(*this, prefix, key, depth);
         // if match
         if (mis_match_pos == INVALID_INDEX) {
-            return node;
+            return Leaf::HasValue(node) ? node : prefix.get();
         }
         return Node();  // Key not found
     }
 
-    // Check the node's prefix
+    // Check the node's prefix, in its header or in its prefix chain
+    if (Prefix::Traverse(node.GetInlinePrefix(*this), key, depth) != INVALID_INDEX) {
+        return Node();
+    }
     Node p_node;
-    reference<Node> prefix_node(p_node);
+    reference<const Node> prefix_node(p_node);
     p_node = node.GetPrefix(*this);
     if (prefix_node.get().getTag() != NType::NODE_DUMMY) {
         auto mismatch_pos =
-            Prefix::TraverseMutable(*this, prefix_node, key, depth);
+            Prefix::Traverse(*this, prefix_node, key, depth);
         if (mismatch_pos != INVALID_INDEX) {
             // Prefix mismatch, key not found
             return Node();
@@ -304,20 +407,902 @@ Node ART::Search(Node& node, const ARTKey& key, idx_t depth) {
     return Search(child, key, depth + 1);
 }
 
+//===--------------------------------------------------------------------===//
+// Lookup
+//===--------------------------------------------------------------------===//
+const Value* ART::Lookup(const ARTKey& key) const {
+    auto leaf = LookupLeaf(key);
+    if (!Leaf::HasValue(leaf)) {
+        return nullptr;
+    }
+    return &GetAllocator(NType::LEAF).Get<const Leaf>(leaf)->value;
+}
+
+bool ART::LookupRowId(const ARTKey& key, idx_t& row_id) const {
+    auto leaf = LookupLeaf(key);
+    if (leaf.getTag() != NType::LEAF_INLINED || leaf.IsCleared()) {
+        return false;
+    }
+    row_id = Leaf::GetRowId(leaf);
+    return true;
+}
+
+Node ART::LookupLeaf(const ARTKey& key) const {
+    auto node = *root;
+    idx_t depth = 0;
+
+    while (true) {
+        if (node.IsGate()) {
+            // the row id set of the key
+            return depth == key.len ? node : Node();
+        }
+        switch (node.getTag()) {
+            case NType::LEAF: {
+                auto leaf = GetAllocator(NType::LEAF).Get<const Leaf>(node);
+                if (!MatchPrefix(leaf->prefix, key, depth) || depth != key.len) {
+                    return Node();
+                }
+                return node;
+            }
+            case NType::PREFIX: {
+                // the key bytes ahead of an inlined leaf
+                auto p = GetAllocator(NType::PREFIX).Get<const Prefix>(node);
+                auto count = p->count;
+                if (depth + count > key.len ||
+                    std::memcmp(p->data, key.data + depth, count) != 0) {
+                    return Node();
+                }
+                depth += count;
+                node = p->ptr;
+                continue;
+            }
+            case NType::LEAF_INLINED:
+                if (node.IsCleared() || depth != key.len) {
+                    return Node();
+                }
+                return node;
+            case NType::NODE_4: {
+                auto n4 = GetAllocator(NType::NODE_4).Get<const Node4>(node);
+                if (!MatchPrefix(n4->inline_prefix, n4->prefix, key, depth) || depth >= key.len) {
+                    return Node();
+                }
+                node = n4->GetChild(key[depth]);
+                break;
+            }
+            case NType::NODE_16: {
+                auto n16 = GetAllocator(NType::NODE_16).Get<const Node16>(node);
+                if (!MatchPrefix(n16->inline_prefix, n16->prefix, key, depth) || depth >= key.len) {
+                    return Node();
+                }
+                node = n16->GetChild(key[depth]);
+                break;
+            }
+            case NType::NODE_48: {
+                auto n48 = GetAllocator(NType::NODE_48).Get<const Node48>(node);
+                if (!MatchPrefix(n48->inline_prefix, n48->prefix, key, depth) || depth >= key.len) {
+                    return Node();
+                }
+                node = n48->GetChild(key[depth]);
+                break;
+            }
+            case NType::NODE_256: {
+                auto n256 = GetAllocator(NType::NODE_256).Get<const Node256>(node);
+                if (!MatchPrefix(n256->inline_prefix, n256->prefix, key, depth) || depth >= key.len) {
+                    return Node();
+                }
+                node = n256->GetChild(key[depth]);
+                break;
+            }
+            default:
+                // empty tree, or no child for the key byte
+                return Node();
+        }
+        depth++;
+    }
+}
+
+//===--------------------------------------------------------------------===//
+// LookupBatch
+//===--------------------------------------------------------------------===//
+//! A lookup in flight in a batch. node is the next node to visit, which was prefetched.
+//! While the lookup matches the prefix chain of an inner node or a Leaf, owner is that node
+struct BatchLookup {
+    idx_t index;
+    Node node;
+    Node owner;
+    idx_t depth;
+    //! Set once the prefix chain of owner matched
+    bool matched;
+};
+
+//! Prefetches the cache lines of the node that a lookup at depth reads: the whole slot of
+//! small nodes, and the header and the child entry of the key byte of large nodes
+static inline void PrefetchNode(const ART& art, const Node& node, const ARTKey& key, const idx_t depth) {
+    auto type = node.getTag();
+    if (type == NType::LEAF_INLINED || type == NType::NODE_DUMMY) {
+        // inlined leaves live in the pointer, and an empty tree has no slot
+        return;
+    }
+    auto ptr = art.GetAllocator(NType::LEAF).Get<const char>(node);
+    switch (type) {
+        // slots that are not aligned to cache lines might span two
+        case NType::LEAF:
+            __builtin_prefetch(ptr);
+            __builtin_prefetch(ptr + sizeof(Leaf) - 1);
+            break;
+        case NType::PREFIX: {
+            // the size class of a segment is unknown ahead of the load, but the lookup compares
+            // at most the rest of the key, so prefetch as far as that reaches
+            auto end = MinValue<idx_t>(sizeof(Prefix) - PREFIX_SIZE + key.len - depth,
+                                       PREFIX_SEGMENT_SIZES[PREFIX_SEGMENT_CLASSES - 1]);
+            end = MaxValue<idx_t>(end, sizeof(Prefix));
+            for (idx_t offset = 0; offset < end; offset += 64) {
+                __builtin_prefetch(ptr + offset);
+            }
+            __builtin_prefetch(ptr + end - 1);
+            break;
+        }
+        case NType::NODE_4:
+            __builtin_prefetch(ptr);
+            __builtin_prefetch(ptr + sizeof(Node4) - 1);
+            break;
+        case NType::NODE_16:
+            for (idx_t offset = 0; offset < sizeof(Node16); offset += 64) {
+                __builtin_prefetch(ptr + offset);
+            }
+            break;
+        case NType::NODE_48:
+            __builtin_prefetch(ptr);
+            if (depth < key.len) {
+                __builtin_prefetch(&reinterpret_cast<const Node48*>(ptr)->child_index[key[depth]]);
+            }
+            break;
+        case NType::NODE_256:
+            __builtin_prefetch(ptr);
+            if (depth < key.len) {
+                __builtin_prefetch(&reinterpret_cast<const Node256*>(ptr)->children[key[depth]]);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+//! Compares the inline prefix of an inner node with the key at depth, and advances depth
+//! past it
+static inline bool MatchInlinePrefix(const InlinePrefix& inlined, const ARTKey& key, idx_t& depth) {
+    if (depth + inlined.count > key.len || std::memcmp(inlined.data, key.data + depth, inlined.count) != 0) {
+        return false;
+    }
+    depth += inlined.count;
+    return true;
+}
+
+//! Returns the node that the lookup visits after the inner node: its prefix chain, or the
+//! child of the key byte once the chain matched
+template <class NODE>
+static inline Node VisitInner(const ART& art, BatchLookup& lookup, const ARTKey& key) {
+    auto n = art.GetAllocator(lookup.node.getTag()).Get<const NODE>(lookup.node);
+    if (!lookup.matched) {
+        if (n->prefix.getTag() == NType::PREFIX) {
+            lookup.owner = lookup.node;
+            return n->prefix;
+        }
+        // a short prefix is in the header, which is in the cache already
+        if (!MatchInlinePrefix(n->inline_prefix, key, lookup.depth)) {
+            return Node();
+        }
+    }
+    lookup.matched = false;
+    if (lookup.depth >= key.len) {
+        return Node();
+    }
+    return n->GetChild(key[lookup.depth++]);
+}
+
+//! Visits the prefetched node of the lookup, and the nodes behind it that are not in other
+//! cache lines. Returns true once the lookup resolved the leaf of its key (as LookupLeaf),
+//! otherwise prefetches the next node
+static bool StepLookup(const ART& art, BatchLookup& lookup, const ARTKey& key, Node& leaf) {
+    auto& node = lookup.node;
+    auto& depth = lookup.depth;
+    while (true) {
+        if (node.IsGate()) {
+            leaf = depth == key.len ? node : Node();
+            return true;
+        }
+        Node child;
+        switch (node.getTag()) {
+            case NType::LEAF: {
+                auto l = art.GetAllocator(NType::LEAF).Get<const Leaf>(node);
+                if (!lookup.matched && l->prefix.getTag() == NType::PREFIX) {
+                    lookup.owner = node;
+                    node = l->prefix;
+                    PrefetchNode(art, node, key, depth);
+                    return false;
+                }
+                leaf = depth == key.len ? node : Node();
+                return true;
+            }
+            case NType::PREFIX: {
+                auto p = art.GetAllocator(NType::PREFIX).Get<const Prefix>(node);
+                auto count = p->count;
+                if (depth + count > key.len || std::memcmp(p->data, key.data + depth, count) != 0) {
+                    leaf = Node();
+                    return true;
+                }
+                depth += count;
+                if (p->ptr.getTag() != NType::PREFIX && lookup.owner.getTag() != NType::NODE_DUMMY) {
+                    // back to the node of the chain, which is still in the cache
+                    node = lookup.owner;
+                    lookup.owner = Node();
+                    lookup.matched = true;
+                    continue;
+                }
+                child = p->ptr;
+                break;
+            }
+            case NType::LEAF_INLINED:
+                leaf = !node.IsCleared() && depth == key.len ? node : Node();
+                return true;
+            case NType::NODE_4:
+                child = VisitInner<Node4>(art, lookup, key);
+                break;
+            case NType::NODE_16:
+                child = VisitInner<Node16>(art, lookup, key);
+                break;
+            case NType::NODE_48:
+                child = VisitInner<Node48>(art, lookup, key);
+                break;
+            case NType::NODE_256:
+                child = VisitInner<Node256>(art, lookup, key);
+                break;
+            default:
+                // empty tree, or no child for the key byte
+                leaf = Node();
+                return true;
+        }
+
+        node = child;
+        if (node.getTag() != NType::LEAF_INLINED && !node.IsCleared() && node.getTag() != NType::NODE_DUMMY) {
+            PrefetchNode(art, node, key, depth);
+            return false;
+        }
+    }
+}
+
+//! Resolves the leaves of count keys (as LookupLeaf) in groups of LOOKUP_GROUP_SIZE keys,
+//! following group prefetching: every round visits each unresolved lookup of the group once,
+//! and a lookup prefetches its next node before the others take their turn. The rounds
+//! keep the lookups of a group at the same level, so that the branches on the node types
+//! stay predictable. Calls sink(i, leaf) per key
+template <class SINK>
+static void LookupLeafBatch(const ART& art, const ARTKey* keys, const idx_t count, SINK&& sink) {
+    BatchLookup lookups[ART::LOOKUP_GROUP_SIZE];
+    for (idx_t base = 0; base < count; base += ART::LOOKUP_GROUP_SIZE) {
+        auto group = MinValue(ART::LOOKUP_GROUP_SIZE, count - base);
+        for (idx_t i = 0; i < group; i++) {
+            lookups[i] = {base + i, *art.root, Node(), 0, false};
+        }
+        PrefetchNode(art, *art.root, keys[base], 0);
+
+        // the unresolved lookups are the first active ones
+        auto active = group;
+        while (active) {
+            for (idx_t i = 0; i < active;) {
+                auto& lookup = lookups[i];
+                Node leaf;
+                if (!StepLookup(art, lookup, keys[lookup.index], leaf)) {
+                    i++;
+                    continue;
+                }
+                sink(lookup.index, leaf);
+                lookup = lookups[--active];
+            }
+        }
+    }
+}
+
+void ART::LookupBatch(const ARTKey* keys, const idx_t count, const Value** values) const {
+    LookupLeafBatch(*this, keys, count, [&](idx_t i, const Node& leaf) {
+        values[i] = Leaf::HasValue(leaf) ? &GetAllocator(NType::LEAF).Get<const Leaf>(leaf)->value : nullptr;
+    });
+}
+
+idx_t ART::LookupRowIdBatch(const ARTKey* keys, const idx_t count, idx_t* row_ids) const {
+    idx_t found = 0;
+    LookupLeafBatch(*this, keys, count, [&](idx_t i, const Node& leaf) {
+        if (leaf.getTag() != NType::LEAF_INLINED || leaf.IsCleared()) {
+            row_ids[i] = INVALID_INDEX;
+            return;
+        }
+        row_ids[i] = Leaf::GetRowId(leaf);
+        found++;
+    });
+    return found;
+}
+
+//! Returns the child of the inner node at byte, or Node()
+static inline Node GetInnerChild(const ART& art, const Node& node, const uint8_t byte) {
+    switch (node.getTag()) {
+        case NType::NODE_4:
+            return art.GetAllocator(NType::NODE_4).Get<const Node4>(node)->GetChild(byte);
+        case NType::NODE_16:
+            return art.GetAllocator(NType::NODE_16).Get<const Node16>(node)->GetChild(byte);
+        case NType::NODE_48:
+            return art.GetAllocator(NType::NODE_48).Get<const Node48>(node)->GetChild(byte);
+        default:
+            return art.GetAllocator(NType::NODE_256).Get<const Node256>(node)->GetChild(byte);
+    }
+}
+
+CoroTask ART::LookupTask(const ARTKey& key, Node& leaf) const {
+    auto node = *root;
+    idx_t depth = 0;
+    leaf = Node();
+
+    while (true) {
+        if (node.IsGate()) {
+            // the row id set of the key
+            if (depth == key.len) {
+                leaf = node;
+            }
+            co_return;
+        }
+        switch (node.getTag()) {
+            case NType::LEAF_INLINED:
+                if (!node.IsCleared() && depth == key.len) {
+                    leaf = node;
+                }
+                co_return;
+            case NType::PREFIX: {
+                // the key bytes ahead of an inlined leaf
+                auto p = GetAllocator(NType::PREFIX).Get<const Prefix>(node);
+                auto count = p->count;
+                if (depth + count > key.len || std::memcmp(p->data, key.data + depth, count) != 0) {
+                    co_return;
+                }
+                depth += count;
+                node = p->ptr;
+                break;
+            }
+            case NType::LEAF:
+            case NType::NODE_4:
+            case NType::NODE_16:
+            case NType::NODE_48:
+            case NType::NODE_256: {
+                // the prefix of the node, in its header or in a chain with one prefetch per prefix
+                if (!MatchInlinePrefix(node.GetInlinePrefix(*this), key, depth)) {
+                    co_return;
+                }
+                auto prefix = node.GetPrefix(*this);
+                while (prefix.getTag() == NType::PREFIX) {
+                    PrefetchNode(*this, prefix, key, depth);
+                    co_await std::suspend_always {};
+                    auto p = GetAllocator(NType::PREFIX).Get<const Prefix>(prefix);
+                    auto count = p->count;
+                    if (depth + count > key.len || std::memcmp(p->data, key.data + depth, count) != 0) {
+                        co_return;
+                    }
+                    depth += count;
+                    prefix = p->ptr;
+                }
+                if (node.getTag() == NType::LEAF) {
+                    if (depth == key.len) {
+                        leaf = node;
+                    }
+                    co_return;
+                }
+                if (depth >= key.len) {
+                    co_return;
+                }
+                node = GetInnerChild(*this, node, key[depth]);
+                depth++;
+                break;
+            }
+            default:
+                // empty tree, or no child for the key byte
+                co_return;
+        }
+
+        if (node.getTag() != NType::LEAF_INLINED && !node.IsCleared() && node.getTag() != NType::NODE_DUMMY) {
+            PrefetchNode(*this, node, key, depth);
+            co_await std::suspend_always {};
+        }
+    }
+}
+
+idx_t ART::LookupRowIdCoro(const ARTKey* keys, const idx_t count, idx_t* row_ids) const {
+    Node leaves[LOOKUP_GROUP_SIZE];
+    idx_t found = 0;
+    CoroScheduler scheduler(LOOKUP_GROUP_SIZE);
+    for (idx_t base = 0; base < count; base += LOOKUP_GROUP_SIZE) {
+        auto group = MinValue(LOOKUP_GROUP_SIZE, count - base);
+        scheduler.Run([&](idx_t slot, CoroTask& task) {
+            if (slot >= group) {
+                return false;
+            }
+            if (!task.Valid()) {
+                task = LookupTask(keys[base + slot], leaves[slot]);
+                return true;
+            }
+            auto& leaf = leaves[slot];
+            if (leaf.getTag() != NType::LEAF_INLINED || leaf.IsCleared()) {
+                row_ids[base + slot] = INVALID_INDEX;
+            } else {
+                row_ids[base + slot] = Leaf::GetRowId(leaf);
+                found++;
+            }
+            return false;
+        });
+    }
+    return found;
+}
+
+bool ART::MatchPrefix(const InlinePrefix& inlined, Node prefix, const ARTKey& key, idx_t& depth) const {
+    if (inlined.count) {
+        return MatchInlinePrefix(inlined, key, depth);
+    }
+    return MatchPrefix(prefix, key, depth);
+}
+
+bool ART::MatchPrefix(Node prefix, const ARTKey& key, idx_t& depth) const {
+    while (prefix.getTag() == NType::PREFIX) {
+        auto p = GetAllocator(NType::PREFIX).Get<const Prefix>(prefix);
+        auto count = p->count;
+        if (depth + count > key.len ||
+            std::memcmp(p->data, key.data + depth, count) != 0) {
+            return false;
+        }
+        depth += count;
+        prefix = p->ptr;
+    }
+    return true;
+}
+
+//===--------------------------------------------------------------------===//
+// BulkLoad
+//===--------------------------------------------------------------------===//
+void ART::BulkLoad(const std::vector<ARTKey>& keys, const std::vector<Value>& values) {
+    CheckWritable();
+    if (keys.size() != values.size()) {
+        throw InternalException("BulkLoad requires one value per key.");
+    }
+    if (!root->IsCleared() && root->getTag() != NType::NODE_DUMMY) {
+        throw InternalException("BulkLoad requires an empty tree.");
+    }
+    for (idx_t i = 1; i < keys.size(); i++) {
+        if (!(keys[i] > keys[i - 1])) {
+            throw InternalException("BulkLoad requires sorted and unique keys.");
+        }
+    }
+    if (keys.empty()) {
+        return;
+    }
+    Construct(*root, keys.data(), values.data(), nullptr, keys.size(), 0);
+}
+
+void ART::ParallelBuild(const std::vector<ARTKey>& keys, const std::vector<Value>& values,
+                        idx_t thread_count) {
+    CheckWritable();
+    if (keys.size() != values.size()) {
+        throw InternalException("ParallelBuild requires one value per key.");
+    }
+    if (!root->IsCleared() && root->getTag() != NType::NODE_DUMMY) {
+        throw InternalException("ParallelBuild requires an empty tree.");
+    }
+    if (thread_count == 0) {
+        thread_count = MaxValue<idx_t>(std::thread::hardware_concurrency(), 1);
+    }
+    auto count = keys.size();
+    if (count < 2) {
+        return BulkLoad(keys, values);
+    }
+
+    // split the keys into one chunk per thread for the partitioning passes
+    auto chunk_size = (count + thread_count - 1) / thread_count;
+    auto chunk_count = (count + chunk_size - 1) / chunk_size;
+
+    // the smallest and the largest key share the prefix of all keys
+    std::vector<std::pair<idx_t, idx_t>> chunk_bounds(chunk_count);
+    ParallelFor(thread_count, chunk_count, [&](idx_t chunk) {
+        auto start = chunk * chunk_size;
+        auto end = MinValue(start + chunk_size, count);
+        idx_t min = start, max = start;
+        for (idx_t i = start + 1; i < end; i++) {
+            if (keys[min] > keys[i]) {
+                min = i;
+            } else if (keys[i] > keys[max]) {
+                max = i;
+            }
+        }
+        chunk_bounds[chunk] = {min, max};
+    });
+    idx_t min = chunk_bounds[0].first, max = chunk_bounds[0].second;
+    for (auto& bounds : chunk_bounds) {
+        min = keys[min] > keys[bounds.first] ? bounds.first : min;
+        max = keys[bounds.second] > keys[max] ? bounds.second : max;
+    }
+    auto& first = keys[min];
+    auto& last = keys[max];
+    idx_t depth = 0;
+    while (depth < first.len && depth < last.len && first[depth] == last[depth]) {
+        depth++;
+    }
+    if (depth == first.len) {
+        throw InternalException("ParallelBuild requires unique keys, none of which is a prefix of another key.");
+    }
+
+    // radix-partition the keys on the first byte behind the shared prefix: count the bytes
+    // per chunk, then every chunk scatters its keys to its own range of each partition
+    std::vector<std::array<idx_t, NODE_256_CAPACITY>> histograms(chunk_count);
+    ParallelFor(thread_count, chunk_count, [&](idx_t chunk) {
+        auto& histogram = histograms[chunk];
+        histogram.fill(0);
+        auto end = MinValue((chunk + 1) * chunk_size, count);
+        for (idx_t i = chunk * chunk_size; i < end; i++) {
+            histogram[keys[i][depth]]++;
+        }
+    });
+
+    std::array<idx_t, NODE_256_CAPACITY + 1> partition_offsets;
+    idx_t offset = 0;
+    for (idx_t byte = 0; byte < NODE_256_CAPACITY; byte++) {
+        partition_offsets[byte] = offset;
+        for (auto& histogram : histograms) {
+            auto chunk_keys = histogram[byte];
+            histogram[byte] = offset;
+            offset += chunk_keys;
+        }
+    }
+    partition_offsets[NODE_256_CAPACITY] = offset;
+
+    std::vector<idx_t> sel(count);
+    ParallelFor(thread_count, chunk_count, [&](idx_t chunk) {
+        auto& positions = histograms[chunk];
+        auto end = MinValue((chunk + 1) * chunk_size, count);
+        for (idx_t i = chunk * chunk_size; i < end; i++) {
+            sel[positions[keys[i][depth]]++] = i;
+        }
+    });
+
+    // sort the partitions, the largest partitions first to balance the threads
+    std::vector<uint8_t> partitions;
+    for (idx_t byte = 0; byte < NODE_256_CAPACITY; byte++) {
+        if (partition_offsets[byte + 1] > partition_offsets[byte]) {
+            partitions.push_back(static_cast<uint8_t>(byte));
+        }
+    }
+    auto partition_size = [&](uint8_t byte) { return partition_offsets[byte + 1] - partition_offsets[byte]; };
+    std::vector<uint8_t> schedule(partitions);
+    std::stable_sort(schedule.begin(), schedule.end(),
+                     [&](uint8_t l, uint8_t r) { return partition_size(l) > partition_size(r); });
+
+    ParallelFor(thread_count, schedule.size(), [&](idx_t task_idx) {
+        auto byte = schedule[task_idx];
+        auto begin = sel.begin() + partition_offsets[byte];
+        auto end = sel.begin() + partition_offsets[byte + 1];
+
+        // sort on the (big-endian) next eight key bytes, and only compare the keys on ties,
+        // which avoids most random accesses to the keys
+        std::vector<std::pair<uint64_t, idx_t>> entries;
+        entries.reserve(end - begin);
+        for (auto it = begin; it < end; it++) {
+            auto& key = keys[*it];
+            uint64_t key_prefix = 0;
+            for (idx_t i = depth + 1; i < depth + 9; i++) {
+                key_prefix = (key_prefix << 8) | (i < key.len ? key[i] : 0);
+            }
+            entries.emplace_back(key_prefix, *it);
+        }
+        std::sort(entries.begin(), entries.end(), [&](const std::pair<uint64_t, idx_t>& l,
+                                                      const std::pair<uint64_t, idx_t>& r) {
+            if (l.first != r.first) {
+                return l.first < r.first;
+            }
+            return keys[r.second] > keys[l.second];
+        });
+        for (idx_t i = 0; i < entries.size(); i++) {
+            begin[i] = entries[i].second;
+            if (i > 0 && entries[i].first == entries[i - 1].first &&
+                !(keys[entries[i].second] > keys[entries[i - 1].second])) {
+                throw InternalException("ParallelBuild requires unique keys, none of which is a prefix of another key.");
+            }
+        }
+    });
+
+    // build the subtree of every partition in the private allocators of its thread, and
+    // adopt the allocators afterwards, so the threads never share an allocator. The private
+    // allocators share the block directory of the tree, so the pointers of the subtrees keep
+    // their block ids
+    thread_count = MinValue<idx_t>(thread_count, schedule.size());
+    std::vector<std::unique_ptr<ART>> thread_arts;
+    for (idx_t i = 0; i < thread_count; i++) {
+        thread_arts.push_back(std::make_unique<ART>(false, GetDirectory()));
+    }
+    std::vector<Node> subtrees(NODE_256_CAPACITY);
+    std::atomic<idx_t> next_task(0);
+    ParallelFor(thread_count, thread_count, [&](idx_t thread_idx) {
+        auto& art = *thread_arts[thread_idx];
+        for (auto task_idx = next_task++; task_idx < schedule.size(); task_idx = next_task++) {
+            auto byte = schedule[task_idx];
+            art.Construct(subtrees[byte], keys.data(), values.data(), sel.data() + partition_offsets[byte],
+                          partition_size(byte), depth + 1);
+        }
+    });
+    for (auto& art : thread_arts) {
+        for (idx_t i = 0; i < allocators.size(); i++) {
+            allocators[i]->Adopt(*art->allocators[i]);
+        }
+        value_arena->Adopt(*art->value_arena);
+    }
+
+    // attach the subtrees below the root, which holds the shared prefix
+    auto type = GetNodeType(partitions.size());
+    Node::New(*this, *root, type);
+    Prefix::New(*this, GetInlinePrefixMutable(*root), GetPrefixMutable(*root), first, 0, depth);
+    for (idx_t pos = 0; pos < partitions.size(); pos++) {
+        auto byte = partitions[pos];
+        *AppendChild(*root, pos, byte) = subtrees[byte];
+    }
+}
+
+NType ART::GetNodeType(const idx_t fan_out) {
+    return fan_out <= NODE_4_CAPACITY    ? NType::NODE_4
+           : fan_out <= NODE_16_CAPACITY ? NType::NODE_16
+           : fan_out <= NODE_48_CAPACITY ? NType::NODE_48
+                                         : NType::NODE_256;
+}
+
+Node& ART::GetPrefixMutable(const Node& node) const {
+    switch (node.getTag()) {
+        case NType::NODE_4:
+            return Node::RefMutable<Node4>(*this, node, NType::NODE_4).prefix;
+        case NType::NODE_16:
+            return Node::RefMutable<Node16>(*this, node, NType::NODE_16).prefix;
+        case NType::NODE_48:
+            return Node::RefMutable<Node48>(*this, node, NType::NODE_48).prefix;
+        case NType::NODE_256:
+            return Node::RefMutable<Node256>(*this, node, NType::NODE_256).prefix;
+        default:
+            throw InternalException("Invalid node type for GetPrefixMutable.");
+    }
+}
+
+InlinePrefix& ART::GetInlinePrefixMutable(const Node& node) const {
+    switch (node.getTag()) {
+        case NType::NODE_4:
+            return Node::RefMutable<Node4>(*this, node, NType::NODE_4).inline_prefix;
+        case NType::NODE_16:
+            return Node::RefMutable<Node16>(*this, node, NType::NODE_16).inline_prefix;
+        case NType::NODE_48:
+            return Node::RefMutable<Node48>(*this, node, NType::NODE_48).inline_prefix;
+        case NType::NODE_256:
+            return Node::RefMutable<Node256>(*this, node, NType::NODE_256).inline_prefix;
+        default:
+            throw InternalException("Invalid node type for GetInlinePrefixMutable.");
+    }
+}
+
+Node* ART::AppendChild(const Node& node, const idx_t pos, const uint8_t byte) const {
+    switch (node.getTag()) {
+        case NType::NODE_4: {
+            auto& n4 = Node::RefMutable<Node4>(*this, node, NType::NODE_4);
+            n4.key[pos] = byte;
+            n4.count++;
+            return &n4.children[pos];
+        }
+        case NType::NODE_16: {
+            auto& n16 = Node::RefMutable<Node16>(*this, node, NType::NODE_16);
+            n16.key[pos] = byte;
+            n16.count++;
+            return &n16.children[pos];
+        }
+        case NType::NODE_48: {
+            auto& n48 = Node::RefMutable<Node48>(*this, node, NType::NODE_48);
+            n48.child_index[byte] = static_cast<uint8_t>(pos);
+            n48.count++;
+            return &n48.children[pos];
+        }
+        case NType::NODE_256: {
+            auto& n256 = Node::RefMutable<Node256>(*this, node, NType::NODE_256);
+            n256.count++;
+            return &n256.children[byte];
+        }
+        default:
+            throw InternalException("Invalid node type for AppendChild.");
+    }
+}
+
+void ART::Construct(Node& node, const ARTKey* keys, const Value* values, const idx_t* sel, idx_t count,
+                    idx_t depth) {
+    // the keys (or the keys at the positions in sel) are sorted
+    auto key_at = [&](idx_t i) -> const ARTKey& { return keys[sel ? sel[i] : i]; };
+    auto& first = key_at(0);
+    auto& last = key_at(count - 1);
+
+    if (count == 1) {
+        auto& leaf = Leaf::New(*this, node, values[sel ? sel[0] : 0]);
+        reference<Node> prefix(leaf.prefix);
+        Prefix::New(*this, prefix, first, depth, first.len - depth);
+        return;
+    }
+
+    // as the keys are sorted, the first and the last key share the prefix of all keys
+    auto prefix_end = depth;
+    while (prefix_end < first.len && prefix_end < last.len && first[prefix_end] == last[prefix_end]) {
+        prefix_end++;
+    }
+    if (prefix_end == first.len) {
+        throw InternalException("BulkLoad does not support keys that are a prefix of another key.");
+    }
+
+    // the keys with the same byte behind the prefix form a run, find the end of each run
+    // with a binary search, such that a node costs O(fan-out * log(count)) comparisons
+    auto run_end = [&](idx_t start) {
+        auto byte = key_at(start)[prefix_end];
+        idx_t lo = start + 1, hi = count;
+        while (lo < hi) {
+            auto mid = lo + (hi - lo) / 2;
+            if (key_at(mid)[prefix_end] > byte) {
+                hi = mid;
+            } else {
+                lo = mid + 1;
+            }
+        }
+        return lo;
+    };
+
+    // count the runs to pick the node type
+    idx_t fan_out = 0;
+    for (idx_t start = 0; start < count; start = run_end(start)) {
+        fan_out++;
+    }
+    Node::New(*this, node, GetNodeType(fan_out));
+    Prefix::New(*this, GetInlinePrefixMutable(node), GetPrefixMutable(node), first, depth, prefix_end - depth);
+
+    // build the child of every run, and place it directly
+    idx_t start = 0;
+    for (idx_t pos = 0; start < count; pos++) {
+        auto end = run_end(start);
+        auto child = AppendChild(node, pos, key_at(start)[prefix_end]);
+        if (sel) {
+            Construct(*child, keys, values, sel + start, end - start, prefix_end + 1);
+        } else {
+            Construct(*child, keys + start, values + start, nullptr, end - start, prefix_end + 1);
+        }
+        start = end;
+    }
+}
+
+//===--------------------------------------------------------------------===//
+// Vacuum
+//===--------------------------------------------------------------------===//
+bool ART::Vacuum(idx_t max_nodes) {
+    CheckWritable();
+    if (!vacuum_active) {
+        bool needs_vacuum = false;
+        for (auto& allocator : allocators) {
+            needs_vacuum = allocator->InitializeVacuum() || needs_vacuum;
+        }
+        if (!needs_vacuum) {
+            return true;
+        }
+        vacuum_active = true;
+        vacuum_cursor.clear();
+    }
+
+    auto budget = max_nodes;
+    if (!VacuumNode(*root, 0, true, budget)) {
+        return false;
+    }
+
+    // the whole tree has been visited, all live slots left the vacuumed blocks
+    for (auto& allocator : allocators) {
+        allocator->FinalizeVacuum();
+    }
+    vacuum_active = false;
+    vacuum_cursor.clear();
+    return true;
+}
+
+void ART::VacuumPointer(Node& node) {
+    auto& allocator = GetSlotAllocator(node);
+    if (allocator.NeedsVacuum(node)) {
+        node = allocator.VacuumPointer(node);
+    }
+}
+
+bool ART::VacuumNode(Node& node, idx_t level, bool resume, idx_t& budget) {
+    if (node.IsCleared() || node.getTag() == NType::NODE_DUMMY) {
+        return true;
+    }
+    if (budget == 0) {
+        return false;
+    }
+    budget--;
+
+    // an inlined leaf has no slot, only the prefix chain ahead of it moves, and the nested
+    // tree of a row id set behind it
+    if (Leaf::IsInlined(node)) {
+        reference<Node> ref_prefix(node);
+        while (ref_prefix.get().getTag() == NType::PREFIX) {
+            VacuumPointer(ref_prefix);
+            ref_prefix = Node::RefMutable<Prefix>(*this, ref_prefix, NType::PREFIX).ptr;
+        }
+        if (!ref_prefix.get().IsGate()) {
+            return true;
+        }
+        Node nested = ref_prefix;
+        nested.SetGate(false);
+        auto done = VacuumNode(nested, level, resume, budget);
+        nested.SetGate(true);
+        ref_prefix.get() = nested;
+        return done;
+    }
+
+    // move the node itself, then its prefix chain
+    VacuumPointer(node);
+    auto prefix = node.GetPrefix(*this);
+    reference<Node> ref_prefix(prefix);
+    while (ref_prefix.get().getTag() == NType::PREFIX) {
+        VacuumPointer(ref_prefix);
+        ref_prefix = Node::RefMutable<Prefix>(*this, ref_prefix, NType::PREFIX).ptr;
+    }
+    node.SetPrefix(*this, prefix);
+
+    if (node.getTag() == NType::LEAF) {
+        return true;
+    }
+
+    // continue with the children, resuming at the byte of the cursor
+    resume = resume && level < vacuum_cursor.size();
+    uint8_t byte = resume ? vacuum_cursor[level] : 0;
+    auto child = node.GetNextChildMutable(*this, byte);
+    while (child) {
+        auto resume_child = resume && byte == vacuum_cursor[level];
+        if (!resume_child) {
+            vacuum_cursor.resize(level);
+            vacuum_cursor.push_back(byte);
+        }
+        if (!VacuumNode(*child, level + 1, resume_child, budget)) {
+            return false;
+        }
+        resume = false;
+        if (byte == NODE_256_CAPACITY - 1) {
+            break;
+        }
+        byte++;
+        child = node.GetNextChildMutable(*this, byte);
+    }
+    vacuum_cursor.resize(level);
+    return true;
+}
+
 bool ART::Delete(Node& node, const ARTKey& key, idx_t depth) {
+    if (depth == 0) {
+        CheckWritable();
+    }
     if (node.getTag() == NType::NODE_DUMMY) {
         // Empty node, key not found
         return false;
     }
 
-    if (node.getTag() == NType::LEAF) {
+    if (Leaf::IsLeaf(node)) {
         // At a leaf node, check if the key matches
-        auto& leaf = Node::RefMutable<Leaf>(*this, node, NType::LEAF);
+        reference<const Node> prefix = node;
+        if (Leaf::HasValue(node)) {
+            prefix = Node::Ref<const Leaf>(*this, node, NType::LEAF).prefix;
+        }
 
-        reference<Node> prefix = leaf.prefix;      
-        auto mis_match_pos = Prefix::TraverseMutable(*this, prefix, key, depth);       
+        // the parent frees the leaf in DeleteChild, a leaf at the root has no parent
+        auto is_root = depth == 0;
+        auto mis_match_pos = Prefix::Traverse(*this, prefix, key, depth);       
         // if match
         if (mis_match_pos == INVALID_INDEX) {
+            if (is_root) {
+                Node::Free(*this, node);
+            }
             node = Node();
             return true;
         }
@@ -325,12 +1310,15 @@ bool ART::Delete(Node& node, const ARTKey& key, idx_t depth) {
         return false;  // Key doesn't match
     }
 
-    // Check the node's prefix
+    // Check the node's prefix, in its header or in its prefix chain
+    if (Prefix::Traverse(node.GetInlinePrefix(*this), key, depth) != INVALID_INDEX) {
+        return false;
+    }
     Node p_node;
-    reference<Node> prefix_node(p_node);
+    reference<const Node> prefix_node(p_node);
     p_node = node.GetPrefix(*this);
     if (prefix_node.get().getTag() != NType::NODE_DUMMY) {           
-        auto mismatch_pos =    Prefix::TraverseMutable(*this, prefix_node, key, depth);        
+        auto mismatch_pos =    Prefix::Traverse(*this, prefix_node, key, depth);        
         if (mismatch_pos != INVALID_INDEX) {
             // Prefix mismatch, key not found
             return false;
@@ -353,13 +1341,14 @@ bool ART::Delete(Node& node, const ARTKey& key, idx_t depth) {
     }
 
     // Recursively delete in the child node
+    auto old_child = child;
     bool deleted = Delete(child, key, depth + 1);
 
     if (deleted) {
         // Remove the child if it's now empty
         if (child.getTag() == NType::NODE_DUMMY) {
             Node::DeleteChild(*this, node, next_byte);
-        } else {
+        } else if (child.Get() != old_child.Get()) {
             // Update the child node if it has changed
             node.ReplaceChild(*this, next_byte, child);
         }         
@@ -5,17 +5,13 @@ namespace duckart {
 
 template <>
 ARTKey ARTKey::CreateARTKey(string_t value) {
-    auto str_len = value.GetSize();
+    ARTKey key(GetKeyLength(value));
+    std::memcpy(key.data, value.GetData(), value.GetSize());
 
-    auto len = str_len + 1;
-    auto data = new data_t[len];
-    std::memcpy(data, value.GetData(), str_len);
-    
      // keys must not be prefixes of other keys https://db.in.tum.de/~leis/papers/ART.pdf  
      // https://github.com/duckdb/duckdb/blob/main/src/execution/index/art/art_key.cpp#L46  
-    data[str_len] = '\0';
-
-    return ARTKey(data, len);
+    key.data[value.GetSize()] = '\0';
+    return key;
 }
 
 template <>
@@ -40,6 +36,33 @@ void ARTKey::CreateARTKey(ARTKey& key, string_t value) {
     key = ARTKey::CreateARTKey<string_t>(value);
 }
 
+template <>
+ARTKey ARTKey::CreateARTKey(data_ptr_t buffer, string_t value) {
+    std::memcpy(buffer, value.GetData(), value.GetSize());
+    buffer[value.GetSize()] = '\0';
+    return View(buffer, GetKeyLength(value));
+}
+
+template <>
+ARTKey ARTKey::CreateARTKey(data_ptr_t buffer, const char* value) {
+    return ARTKey::CreateARTKey<string_t>(buffer, string_t(value));
+}
+
+bool ARTKey::operator>(const ARTKey &k) const {
+	for (uint32_t i = 0; i < MinValue<uint32_t>(len, k.len); i++) {
+		if (data[i] > k.data[i]) {
+			return true;
+		} else if (data[i] < k.data[i]) {
+			return false;
+		}
+	}
+	return len > k.len;
+}
+
+bool ARTKey::operator>=(const ARTKey &k) const {
+	return !(k > *this);
+}
+
 bool ARTKey::operator==(const ARTKey &k) const {
 	if (len != k.len) {
 		return false;
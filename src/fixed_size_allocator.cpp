@@ -1,5 +1,15 @@
 #include "fixed_size_allocator.hpp"
 
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+
 #include "prefix.hpp"
 #include "leaf.hpp"
 #include "node.hpp"
@@ -11,26 +21,561 @@
 
 namespace duckart {
 
-template <typename T>
-T* FixedSizeAllocator::Get(const Node& ptr) const {
-    return reinterpret_cast<T*>(ptr.getPointer());
+//! Smallest block, also the granularity in which memory is returned to the OS
+static constexpr size_t MIN_BLOCK_SIZE = 4096;
+//! Vacuum only if at least this percentage of the blocks can be freed
+static constexpr idx_t VACUUM_THRESHOLD = 10;
+
+static size_t NextPowerOfTwo(size_t v) {
+    size_t result = 1;
+    while (result < v) {
+        result <<= 1;
+    }
+    return result;
+}
+
+// Blocks are aligned to their size, so that the owning block of a slot can be found by
+// masking its address. Memory comes straight from the OS: blocks are carved out of arenas of
+// ARENA_SIZE bytes, which are mapped once and aligned to their size, so that a tree of any size
+// takes a handful of mappings (the kernel limits their number, see vm.max_map_count). Released
+// blocks hand their pages back to the OS with MADV_DONTNEED, which reads them back as zeros,
+// and are reused for the next block of their size. Blocks larger than an arena are mapped on
+// their own. AllocateBlocks takes count blocks at once, e.g., the blocks of a snapshot, and
+// populates their pages up front, which is cheaper than a page fault per page. Each of them is
+// released on its own.
+static constexpr size_t ARENA_SIZE = size_t(64) << 20;
+
+#ifndef _WIN32
+//! The arenas of all allocators, by block size, allocated once and never destroyed, as static
+//! trees may release their blocks after the static destructors ran
+struct BlockArenas {
+    struct SizeClass {
+        //! The unused part of the latest arena
+        char* next = nullptr;
+        char* end = nullptr;
+        //! Released blocks, whose pages went back to the OS
+        std::vector<void*> free;
+    };
+    std::mutex lock;
+    //! By log2 of the block size
+    SizeClass classes[64];
+};
+
+static BlockArenas& GetBlockArenas() {
+    static auto arenas = new BlockArenas();
+    return *arenas;
+}
+
+static void Unmap(void* ptr, size_t size) {
+    if (munmap(ptr, size) != 0) {
+        throw InternalException(std::string("Could not unmap memory: ") + std::strerror(errno));
+    }
+}
+
+//! Maps size bytes, aligned to size, a power of two
+static char* MapAligned(size_t size) {
+    // over-allocate, then trim the unaligned head and the tail
+    auto raw = mmap(nullptr, 2 * size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    auto start = reinterpret_cast<uintptr_t>(raw);
+    auto aligned = (start + size - 1) & ~(uintptr_t(size) - 1);
+    if (aligned > start) {
+        Unmap(raw, aligned - start);
+    }
+    if (start + 2 * size > aligned + size) {
+        Unmap(reinterpret_cast<void*>(aligned + size), start + 2 * size - (aligned + size));
+    }
+    return reinterpret_cast<char*>(aligned);
+}
+#endif
+
+static void ReleaseBlock(void* ptr, size_t size) {
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    if (size > ARENA_SIZE) {
+        Unmap(ptr, size);
+        return;
+    }
+    if (madvise(ptr, size, MADV_DONTNEED) != 0) {
+        throw InternalException(std::string("Could not release a block: ") + std::strerror(errno));
+    }
+    auto& arenas = GetBlockArenas();
+    std::lock_guard<std::mutex> guard(arenas.lock);
+    arenas.classes[__builtin_ctzll(size)].free.push_back(ptr);
+#endif
+}
+
+static std::vector<void*> AllocateBlocks(size_t size, size_t count, bool populate) {
+    std::vector<void*> blocks;
+#ifdef _WIN32
+    for (idx_t i = 0; i < count; i++) {
+        auto ptr = _aligned_malloc(size, size);
+        if (!ptr) {
+            for (auto block : blocks) {
+                ReleaseBlock(block, size);
+            }
+            throw std::bad_alloc();
+        }
+        std::memset(ptr, 0, size);
+        blocks.push_back(ptr);
+    }
+#else
+    try {
+        if (size > ARENA_SIZE) {
+            for (idx_t i = 0; i < count; i++) {
+                blocks.push_back(MapAligned(size));
+            }
+        } else {
+            auto& arenas = GetBlockArenas();
+            std::lock_guard<std::mutex> guard(arenas.lock);
+            auto& size_class = arenas.classes[__builtin_ctzll(size)];
+            while (blocks.size() < count && !size_class.free.empty()) {
+                blocks.push_back(size_class.free.back());
+                size_class.free.pop_back();
+            }
+            while (blocks.size() < count) {
+                if (size_class.next == size_class.end) {
+                    size_class.next = MapAligned(ARENA_SIZE);
+                    size_class.end = size_class.next + ARENA_SIZE;
+                }
+                blocks.push_back(size_class.next);
+                size_class.next += size;
+            }
+        }
+#ifdef MADV_POPULATE_WRITE
+        // in runs of adjacent blocks. Older kernels reject the advice, and fault the pages in on
+        // first touch instead
+        for (idx_t i = 0, first = 0; populate && i < count; i++) {
+            if (i + 1 < count && static_cast<char*>(blocks[i + 1]) == static_cast<char*>(blocks[i]) + size) {
+                continue;
+            }
+            if (madvise(blocks[first], (i + 1 - first) * size, MADV_POPULATE_WRITE) != 0 && errno != EINVAL) {
+                throw std::bad_alloc();
+            }
+            first = i + 1;
+        }
+#endif
+    } catch (...) {
+        for (auto block : blocks) {
+            ReleaseBlock(block, size);
+        }
+        throw;
+    }
+#endif
+    return blocks;
+}
+
+static void* AllocateBlock(size_t size) { return AllocateBlocks(size, 1, false)[0]; }
+
+//! The free thread indexes below count, allocated once and never destroyed, as threads may
+//! exit after the static destructors ran
+struct ThreadIndexes {
+    std::mutex lock;
+    std::set<idx_t> free;
+    idx_t count = 0;
+};
+
+static ThreadIndexes& GetThreadIndexes() {
+    static auto indexes = new ThreadIndexes();
+    return *indexes;
+}
+
+idx_t ThreadIndex::Acquire() {
+    auto& indexes = GetThreadIndexes();
+    std::lock_guard<std::mutex> guard(indexes.lock);
+    if (!indexes.free.empty()) {
+        auto index = *indexes.free.begin();
+        indexes.free.erase(indexes.free.begin());
+        return index;
+    }
+    if (indexes.count == MAX_THREADS) {
+        throw InternalException("Too many threads use the allocators.");
+    }
+    return indexes.count++;
+}
+
+void ThreadIndex::Release(idx_t index) {
+    auto& indexes = GetThreadIndexes();
+    std::lock_guard<std::mutex> guard(indexes.lock);
+    indexes.free.insert(index);
+}
+
+BlockDirectory::~BlockDirectory() {
+    for (idx_t i = 0; i < MAX_CHUNKS; i++) {
+        delete[] chunks[i].load();
+        delete[] dirty[i].load();
+    }
+}
+
+void BlockDirectory::addChunk(idx_t blockId) {
+    auto chunk = blockId >> CHUNK_BITS;
+    if (!chunks[chunk].load(std::memory_order_relaxed)) {
+        dirty[chunk].store(new std::atomic<uint64_t>[CHUNK_SIZE * PAGE_WORDS](), std::memory_order_release);
+        chunks[chunk].store(new std::atomic<BlockHeader*>[CHUNK_SIZE](), std::memory_order_release);
+    }
+}
+
+void BlockDirectory::Register(BlockHeader* header) {
+    std::lock_guard<std::mutex> guard(lock);
+    idx_t blockId;
+    if (!freeIds.empty()) {
+        blockId = freeIds.back();
+        freeIds.pop_back();
+    } else {
+        blockId = idCount++;
+        if (blockId > IndexPointer::MAX_BLOCK_ID || (blockId >> CHUNK_BITS) >= MAX_CHUNKS) {
+            throw InternalException("The block directory is full.");
+        }
+        addChunk(blockId);
+    }
+    header->blockId = blockId;
+    MarkDirty(blockId);
+    chunks[blockId >> CHUNK_BITS].load(std::memory_order_relaxed)[blockId & (CHUNK_SIZE - 1)].store(
+        header, std::memory_order_release);
+}
+
+void BlockDirectory::RegisterAt(BlockHeader* header, idx_t blockId) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (blockId > IndexPointer::MAX_BLOCK_ID || (blockId >> CHUNK_BITS) >= MAX_CHUNKS) {
+        throw InternalException("The block directory is full.");
+    }
+    if (blockId < idCount) {
+        auto it = std::find(freeIds.begin(), freeIds.end(), blockId);
+        if (it == freeIds.end()) {
+            throw InternalException("The block id is already registered.");
+        }
+        freeIds.erase(it);
+    } else {
+        // the skipped ids are free, and Register might hand out any of them
+        for (auto id = idCount; id < blockId; id++) {
+            freeIds.push_back(id);
+        }
+        for (auto chunk = idCount >> CHUNK_BITS; chunk <= (blockId >> CHUNK_BITS); chunk++) {
+            addChunk(chunk << CHUNK_BITS);
+        }
+        idCount = blockId + 1;
+    }
+    MarkDirty(blockId);
+    chunks[blockId >> CHUNK_BITS].load(std::memory_order_relaxed)[blockId & (CHUNK_SIZE - 1)].store(
+        header, std::memory_order_release);
+}
+
+void BlockDirectory::Unregister(idx_t blockId) {
+    std::lock_guard<std::mutex> guard(lock);
+    chunks[blockId >> CHUNK_BITS].load(std::memory_order_relaxed)[blockId & (CHUNK_SIZE - 1)].store(
+        nullptr, std::memory_order_relaxed);
+    freeIds.push_back(blockId);
+}
+
+idx_t BlockDirectory::GetIdCount() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return idCount;
+}
+
+FixedSizeAllocator::FixedSizeAllocator(size_t elementSize, size_t blockCapacity,
+                                       std::shared_ptr<BlockDirectory> directory)
+    : directory(directory ? std::move(directory) : std::make_shared<BlockDirectory>()),
+      elementSize(elementSize),
+      used(0) {
+    D_ASSERT(elementSize >= sizeof(void*) && elementSize % sizeof(void*) == 0);
+
+    // the block layout is [header | bitmap | slots], the block size is the next power of
+    // two that holds blockCapacity slots, any space left over is filled with more slots
+    auto layoutSize = [elementSize](size_t capacity) {
+        auto words = (capacity + 63) / 64;
+        auto offset = (sizeof(BlockHeader) + words * sizeof(uint64_t) + 63) & ~size_t(63);
+        return offset + capacity * elementSize;
+    };
+    blockSize = std::max(NextPowerOfTwo(layoutSize(blockCapacity)), MIN_BLOCK_SIZE);
+    while (layoutSize(blockCapacity + 1) <= blockSize) {
+        blockCapacity++;
+    }
+    this->blockCapacity = blockCapacity;
+    bitmapWords = (blockCapacity + 63) / 64;
+    dataOffset = layoutSize(blockCapacity) - blockCapacity * elementSize;
+    D_ASSERT(blockSize - 1 <= IndexPointer::MAX_OFFSET);
+    pageShift = __builtin_ctzll(BlockDirectory::PAGE_SIZE);
+    while ((blockSize >> pageShift) > BlockDirectory::MAX_PAGES) {
+        pageShift++;
+    }
+
+    addBlock();
 }
 
+FixedSizeAllocator::~FixedSizeAllocator() {
+    freeThreadCaches();
+    for (auto blockId : blocks) {
+        auto header = directory->Get(blockId);
+        directory->Unregister(blockId);
+        ReleaseBlock(header, blockSize);
+    }
+}
+
+void FixedSizeAllocator::addBlock() {
+    auto header = static_cast<BlockHeader*>(AllocateBlock(blockSize));
+    header->used = 0;
+    header->freeHint = 0;
+    header->vacuum = 0;
+
+    // mark the padding bits of the last bitmap word as occupied
+    auto bitmap = header->GetBitmap();
+    std::memset(bitmap, 0, bitmapWords * sizeof(uint64_t));
+    if (blockCapacity % 64) {
+        bitmap[bitmapWords - 1] = ~uint64_t(0) << (blockCapacity % 64);
+    }
+    // register the block once it is initialized, readers resolve its id without lock
+    directory->Register(header);
+    blocks.insert(header->blockId);
+    blocksWithFreeSpace.insert(header->blockId);
+}
+
+void FixedSizeAllocator::releaseBlock(idx_t blockId) {
+    auto header = directory->Get(blockId);
+    D_ASSERT(header && header->used == 0);
+    blocksWithFreeSpace.erase(blockId);
+    vacuumBlocks.erase(blockId);
+    blocks.erase(blockId);
+    directory->Unregister(blockId);
+    ReleaseBlock(header, blockSize);
+}
+
+void FixedSizeAllocator::Reset() {
+    if (IsVacuuming()) {
+        throw InternalException("Cannot reset an allocator during a vacuum.");
+    }
+    FlushThreadCaches();
+    freeThreadCaches();
+    for (auto blockId : blocks) {
+        auto header = directory->Get(blockId);
+        directory->Unregister(blockId);
+        ReleaseBlock(header, blockSize);
+    }
+    blocks.clear();
+    blocksWithFreeSpace.clear();
+    used = 0;
+}
+
+std::vector<BlockHeader*> FixedSizeAllocator::LoadBlocks(const std::vector<idx_t>& blockIds) {
+    std::vector<BlockHeader*> headers;
+    if (blockIds.empty()) {
+        return headers;
+    }
+    for (auto block : AllocateBlocks(blockSize, blockIds.size(), true)) {
+        headers.push_back(static_cast<BlockHeader*>(block));
+    }
+    for (idx_t i = 0; i < blockIds.size(); i++) {
+        try {
+            directory->RegisterAt(headers[i], blockIds[i]);
+        } catch (...) {
+            for (auto j = i; j < blockIds.size(); j++) {
+                ReleaseBlock(headers[j], blockSize);
+            }
+            throw;
+        }
+        blocks.insert(blockIds[i]);
+    }
+    return headers;
+}
 
-// Explicit template instantiation
-template Prefix* FixedSizeAllocator::Get<Prefix>(const Node& ptr) const;
-template Node4* FixedSizeAllocator::Get<Node4>(const Node& ptr) const;
-template Node16* FixedSizeAllocator::Get<Node16>(const Node& ptr) const;
-template Node48* FixedSizeAllocator::Get<Node48>(const Node& ptr) const;
-template Node256* FixedSizeAllocator::Get<Node256>(const Node& ptr) const;
-template Leaf* FixedSizeAllocator::Get<Leaf>(const Node& ptr) const;
+void FixedSizeAllocator::FinalizeLoad() {
+    used = 0;
+    blocksWithFreeSpace.clear();
+    for (auto blockId : blocks) {
+        auto header = directory->Get(blockId);
+        if (header->blockId != blockId || header->used > blockCapacity || header->vacuum) {
+            throw InternalException("The block does not belong to this allocator.");
+        }
+        header->freeHint = 0;
+        if (header->used < blockCapacity) {
+            blocksWithFreeSpace.insert(blockId);
+        }
+        used += header->used;
+    }
+    if (blocksWithFreeSpace.empty()) {
+        addBlock();
+    }
+}
+
+std::vector<idx_t> FixedSizeAllocator::GetDirtyBlockIds() const {
+    std::vector<idx_t> result;
+    for (auto blockId : blocks) {
+        if (directory->IsDirty(blockId)) {
+            result.push_back(blockId);
+        }
+    }
+    return result;
+}
+
+void FixedSizeAllocator::ClearDirty() {
+    for (auto blockId : blocks) {
+        directory->ClearDirty(blockId);
+    }
+}
 
-// Add const versions of the template instantiations
-template const Prefix* FixedSizeAllocator::Get<const Prefix>(const Node& ptr) const;
-template const Node4* FixedSizeAllocator::Get<const Node4>(const Node& ptr) const;
-template const Node16* FixedSizeAllocator::Get<const Node16>(const Node& ptr) const;
-template const Node48* FixedSizeAllocator::Get<const Node48>(const Node& ptr) const;
-template const Node256* FixedSizeAllocator::Get<const Node256>(const Node& ptr) const;
-template const Leaf* FixedSizeAllocator::Get<const Leaf>(const Node& ptr) const;
+void FixedSizeAllocator::SetThreadCache(bool enable) {
+    if (!enable) {
+        FlushThreadCaches();
+    }
+    cached = enable;
+}
+
+FixedSizeAllocator::ThreadCache& FixedSizeAllocator::addThreadCache(idx_t index) {
+    std::lock_guard<std::mutex> guard(lock);
+    auto& chunk = threadCaches[index / THREAD_CHUNK_SIZE];
+    if (!chunk.load(std::memory_order_relaxed)) {
+        chunk.store(new std::atomic<ThreadCache*>[THREAD_CHUNK_SIZE](), std::memory_order_release);
+    }
+    auto cache = new ThreadCache();
+    chunk.load(std::memory_order_relaxed)[index % THREAD_CHUNK_SIZE].store(cache, std::memory_order_relaxed);
+    return *cache;
+}
+
+void FixedSizeAllocator::freeThreadCaches() {
+    for (auto& chunk : threadCaches) {
+        auto caches = chunk.load(std::memory_order_relaxed);
+        if (!caches) {
+            continue;
+        }
+        for (idx_t i = 0; i < THREAD_CHUNK_SIZE; i++) {
+            delete caches[i].load(std::memory_order_relaxed);
+        }
+        delete[] caches;
+        chunk.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+void FixedSizeAllocator::refill(ThreadCache& cache) {
+    D_ASSERT(cache.count == 0);
+    std::lock_guard<std::mutex> guard(lock);
+    while (cache.count < THREAD_CACHE_BATCH) {
+        cache.slots[cache.count++] = newSlot();
+    }
+    cache.stats.refills++;
+}
+
+void FixedSizeAllocator::spill(ThreadCache& cache) {
+    // keep the most recently freed slots, they are the most likely ones to be in the CPU cache
+    std::lock_guard<std::mutex> guard(lock);
+    for (idx_t i = 0; i < THREAD_CACHE_BATCH; i++) {
+        freeSlot(cache.slots[i]);
+    }
+    cache.count -= THREAD_CACHE_BATCH;
+    std::memmove(cache.slots, cache.slots + THREAD_CACHE_BATCH, cache.count * sizeof(void*));
+    cache.stats.spills++;
+}
+
+void FixedSizeAllocator::FlushThreadCaches() {
+    std::lock_guard<std::mutex> guard(lock);
+    forEachThreadCache([&](ThreadCache& cache) {
+        while (cache.count > 0) {
+            freeSlot(cache.slots[--cache.count]);
+        }
+    });
+}
+
+ThreadCacheStats FixedSizeAllocator::GetThreadCacheStats() const {
+    ThreadCacheStats result;
+    std::lock_guard<std::mutex> guard(lock);
+    forEachThreadCache([&](const ThreadCache& cache) {
+        result.allocations += cache.stats.allocations;
+        result.allocation_hits += cache.stats.allocation_hits;
+        result.frees += cache.stats.frees;
+        result.free_hits += cache.stats.free_hits;
+        result.refills += cache.stats.refills;
+        result.spills += cache.stats.spills;
+    });
+    return result;
+}
+
+void FixedSizeAllocator::Adopt(FixedSizeAllocator& other) {
+    if (other.elementSize != elementSize || other.blockSize != blockSize) {
+        throw InternalException("Cannot adopt the blocks of an allocator with a different layout.");
+    }
+    if (other.directory != directory) {
+        throw InternalException("Cannot adopt the blocks of an allocator with a different block directory.");
+    }
+    if (IsVacuuming() || other.IsVacuuming()) {
+        throw InternalException("Cannot adopt blocks during a vacuum.");
+    }
+    FlushThreadCaches();
+    other.FlushThreadCaches();
+
+    // the blocks keep their ids, so the pointers into them stay valid
+    for (auto blockId : other.blocks) {
+        auto header = directory->Get(blockId);
+        if (header->used == 0) {
+            directory->Unregister(blockId);
+            ReleaseBlock(header, blockSize);
+            continue;
+        }
+        blocks.insert(blockId);
+        if (header->used < blockCapacity) {
+            blocksWithFreeSpace.insert(blockId);
+        }
+        used += header->used;
+    }
+
+    other.blocks.clear();
+    other.blocksWithFreeSpace.clear();
+    other.used = 0;
+}
+
+bool FixedSizeAllocator::InitializeVacuum() {
+    // the cached slots count as used, and they might live in the blocks to evacuate
+    FlushThreadCaches();
+    auto blockCount = GetBlockCount();
+    auto neededBlocks = (used + blockCapacity - 1) / blockCapacity;
+    if (blockCount <= neededBlocks) {
+        return false;
+    }
+    auto excessBlocks = blockCount - neededBlocks;
+    if (excessBlocks * 100 < blockCount * VACUUM_THRESHOLD) {
+        return false;
+    }
+
+    // the remaining blocks can hold all slots, so evacuate the sparsest ones
+    std::vector<std::pair<idx_t, idx_t>> usage;
+    for (auto blockId : blocks) {
+        auto header = directory->Get(blockId);
+        if (!header->vacuum) {
+            usage.emplace_back(header->used, blockId);
+        }
+    }
+    std::sort(usage.begin(), usage.end());
+    for (idx_t i = 0; i < excessBlocks && i < usage.size(); i++) {
+        auto blockId = usage[i].second;
+        auto header = directory->Get(blockId);
+        if (header->used == 0) {
+            releaseBlock(blockId);
+            continue;
+        }
+        header->vacuum = 1;
+        blocksWithFreeSpace.erase(blockId);
+        vacuumBlocks.insert(blockId);
+    }
+    return IsVacuuming();
+}
+
+void FixedSizeAllocator::FinalizeVacuum() {
+    for (auto blockId : vacuumBlocks) {
+        auto header = directory->Get(blockId);
+        header->vacuum = 0;
+        if (header->used < blockCapacity) {
+            blocksWithFreeSpace.insert(blockId);
+        }
+    }
+    vacuumBlocks.clear();
+}
+
+IndexPointer FixedSizeAllocator::VacuumPointer(const IndexPointer& ptr) {
+    D_ASSERT(NeedsVacuum(ptr));
+    auto newPtr = New(ptr.getTag());
+    std::memcpy(Get<void>(newPtr), Get<void>(ptr), elementSize);
+    Free(ptr);
+    return newPtr;
+}
 
 }  // namespace duckart
@@ -1,9 +1,12 @@
 #pragma once
 
+#include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "common.hpp"
+#include "coro.hpp"
 #include "fixed_size_allocator.hpp"
 #include "node.hpp"
 #include "artkey.hpp"
@@ -13,25 +16,238 @@ namespace duckart {
 
 class Node;
 class FixedSizeAllocator;
+class BlockDirectory;
+class Value;
+class EpochManager;
+class ValueArena;
+class SnapshotMapping;
+struct CheckpointState;
+struct InlinePrefix;
 
 class ART {
    public:
+    //! Largest number of row ids in the sorted array of a row id set
+    static constexpr idx_t ROW_ID_ARRAY_CAPACITY = 16;
+    //! Number of lookups in flight in LookupBatch, enough to cover the memory latency
+    static constexpr idx_t LOOKUP_GROUP_SIZE = 16;
+
+    //! Ordered iteration and range scans over the keys of the tree, see iterator.hpp
+    class Iterator;
+
     std::unique_ptr<Node> root;
     std::vector<std::unique_ptr<FixedSizeAllocator>> allocators;   
 
-    ART();
+    //! A concurrent tree serializes its allocators behind per-thread slot caches, and retires
+    //! freed nodes into the limbo lists of its EpochManager instead of freeing them, see
+    //! ConcurrentInsert. All allocators of the tree register their blocks in directory, or in a
+    //! directory of their own, which resolves the pointers of the tree (see IndexPointer)
+    explicit ART(bool concurrent = false, std::shared_ptr<BlockDirectory> directory = nullptr);
+    ~ART();
 
     FixedSizeAllocator& GetAllocator(NType type) const {
         auto index = static_cast<size_t>(type) - 1;
         return *allocators[index];
     }
+    //! The allocator of the prefix segments of a size class, see Prefix::NewSegment. The
+    //! larger classes follow the allocator of NType::PREFIX, which holds the smallest one
+    FixedSizeAllocator& GetPrefixAllocator(uint8_t size_class) const {
+        return *allocators[static_cast<size_t>(NType::PREFIX) - 1 + size_class];
+    }
+    //! The allocator that owns the slot of node, which for a prefix node depends on its size
+    //! class
+    FixedSizeAllocator& GetSlotAllocator(const Node& node) const;
+    //! The block directory shared by all allocators of the tree
+    const std::shared_ptr<BlockDirectory>& GetDirectory() const;
 
+   //! Inserts the leaf, a Leaf (see Leaf::New) or an inlined leaf (see Leaf::NewInlined),
+   //! which the tree owns from then on
    bool Insert(Node &node, const ARTKey &key, const Node &leaf, idx_t depth);
    bool InsertIntoNode(Node& node, const ARTKey& key, const Node& leaf, idx_t depth);
     
    bool Delete(Node &node, const ARTKey &key, idx_t depth);
     
    Node Search(Node &node,const ARTKey &key, idx_t depth); 
+
+   //! Read-only point lookup in the tree at root, walks the tree in a loop and compares
+   //! the prefixes in place. Returns the value of the key, or nullptr if it does not exist
+   const Value *Lookup(const ARTKey &key) const;
+   //! Like Lookup, for the keys of inlined leaves (see Leaf::NewInlined). Sets row_id to
+   //! the row id of the key, returns false if the key does not exist or has a Leaf
+   bool LookupRowId(const ARTKey &key, idx_t &row_id) const;
+   //! Lookup of count keys at once, e.g., the probe side of a join. Interleaves the walks of
+   //! LOOKUP_GROUP_SIZE keys and prefetches the next node of each, so that their cache misses
+   //! overlap. Sets values[i] to the value of keys[i], or nullptr
+   void LookupBatch(const ARTKey *keys, const idx_t count, const Value **values) const;
+   //! LookupRowId of count keys at once (see LookupBatch). Sets row_ids[i] to the row id of
+   //! keys[i], or INVALID_INDEX. Returns the number of found keys
+   idx_t LookupRowIdBatch(const ARTKey *keys, const idx_t count, idx_t *row_ids) const;
+   //! The walk of Lookup as a coroutine (see coro.hpp), which suspends after it prefetched
+   //! each node on the path, for a CoroScheduler that interleaves it with other tasks. Sets
+   //! leaf to the leaf of the key: a Leaf (see Leaf::HasValue), an inlined leaf or a row id
+   //! set, or Node() if the key does not exist. key and leaf must outlive the task
+   CoroTask LookupTask(const ARTKey &key, Node &leaf) const;
+   //! LookupRowIdBatch with LookupTasks on a CoroScheduler of LOOKUP_GROUP_SIZE slots
+   idx_t LookupRowIdCoro(const ARTKey *keys, const idx_t count, idx_t *row_ids) const;
+
+   //! Non-unique keys: every key owns a set of row ids, which grows from an inlined leaf to a
+   //! sorted array of up to ROW_ID_ARRAY_CAPACITY row ids, and then to a nested ART over the
+   //! row ids (see row_id_set.cpp). Keys with a value must not be mixed with these, and
+   //! concurrent trees do not support them.
+   //! Adds row_id to the row ids of the key, returns false if it was already there
+   bool AddRowId(const ARTKey &key, const idx_t row_id);
+   //! Removes row_id from the row ids of the key, and the key with its last row id. Returns
+   //! false if row_id was not there
+   bool RemoveRowId(const ARTKey &key, const idx_t row_id);
+   //! Calls callback for the row ids of the key in ascending order, until callback returns
+   //! false. Returns the number of visited row ids
+   idx_t ScanRowIds(const ARTKey &key, const std::function<bool(idx_t)> &callback) const;
+
+   //! Concurrent operations with optimistic lock coupling (see olc.hpp), which any number
+   //! of threads can run at the same time on a concurrent tree. Readers do not write to
+   //! shared memory, writers lock the node they modify, and also its parent if they
+   //! replace the node. Leaves are never modified once they are in the tree, a value update
+   //! replaces the leaf. The other operations must not run concurrently with these.
+   //! Inserts the key, or replaces its value. Returns true if the key is new
+   bool ConcurrentInsert(const ARTKey &key, const Value &value);
+   //! Deletes the key, returns true if it existed
+   bool ConcurrentDelete(const ARTKey &key);
+   //! Copies the value of the key into value, returns false if the key does not exist
+   bool ConcurrentLookup(const ARTKey &key, Value &value) const;
+
+   bool IsConcurrent() const { return concurrent; }
+   //! Defers freeing the node (slot) until no concurrent operation can still read it
+   void Retire(const Node &node);
+   //! Frees all retired nodes. Must not run concurrently with any operation on the tree
+   void ReclaimRetired();
+   //! Holds the leaf values that do not fit inline
+   ValueArena &GetValueArena() const { return *value_arena; }
+   //! The epoch manager of a concurrent tree, e.g., for its reclamation statistics
+   EpochManager &GetEpochManager() const {
+       D_ASSERT(concurrent);
+       return *epochs;
+   }
+
+   //! Builds the (empty) tree bottom-up from keys, which must be sorted and unique, and
+   //! their values. Every inner node is allocated once with the node type that fits its
+   //! fan-out, and every prefix chain is written once
+   void BulkLoad(const std::vector<ARTKey> &keys, const std::vector<Value> &values);
+   //! Builds the (empty) tree from unsorted, unique keys and their values on thread_count
+   //! threads (0: one per core). The keys are radix-partitioned on their first byte behind
+   //! the prefix shared by all keys, and every partition is sorted and built by BulkLoad
+   //! into thread-private allocators, which the tree adopts at the end
+   void ParallelBuild(const std::vector<ARTKey> &keys, const std::vector<Value> &values,
+                      idx_t thread_count = 0);
+
+   //! Writes the tree to a snapshot file at path (see snapshot.cpp): the root pointer and the
+   //! blocks of all allocators, which thread_count threads (0: one per core) write in runs of
+   //! about 1 MiB. Must not run concurrently with any other operation on the tree. Returns the
+   //! size of the file in bytes
+   idx_t Serialize(const std::string &path, idx_t thread_count = 0);
+   //! Loads the snapshot at path into the (empty) tree on thread_count threads. The blocks keep
+   //! their block ids, so the tree must not share its block directory with a tree that holds
+   //! blocks. Returns the size of the file in bytes
+   idx_t Deserialize(const std::string &path, idx_t thread_count = 0);
+   //! Maps the snapshot at path read-only into the (empty) tree, which then serves lookups,
+   //! iterators and row id scans straight from the mapped pages, without reading the file up
+   //! front. Processes that map the same file share its pages in the page cache. The tree must
+   //! not be modified afterwards. If populate is set, the whole file is read ahead. Returns the
+   //! size of the file in bytes
+   idx_t Map(const std::string &path, bool populate = false);
+   //! Returns true if the tree serves a mapped snapshot, see Map
+   bool IsMapped() const { return mapping != nullptr; }
+   //! Writes the blocks that changed since the last checkpoint to the checkpoint file at path,
+   //! and appends a root record that references them and the unchanged blocks of the previous
+   //! checkpoints (see snapshot.cpp). The first checkpoint of the tree to path writes all blocks.
+   //! The blocks are written copy-on-write, so the file always holds a complete tree, and the
+   //! I/O grows with the number of changed blocks, not with the size of the tree. Must not run
+   //! concurrently with any other operation on the tree. Returns the number of bytes written
+   idx_t Checkpoint(const std::string &path, idx_t thread_count = 0);
+   //! Loads the latest checkpoint in the file at path into the (empty) tree on thread_count
+   //! threads, after which Checkpoint to the same path continues the file. Returns the size of
+   //! the file in bytes
+   idx_t LoadCheckpoint(const std::string &path, idx_t thread_count = 0);
+
+   //! Compacts the tree at root into fewer allocator blocks, by moving nodes out of
+   //! sparsely used blocks and rewriting the pointers to them. Emptied blocks are
+   //! returned to the OS. Visits at most max_nodes nodes per call, and returns true
+   //! once the vacuum is complete, otherwise the next call resumes where this one stopped
+   bool Vacuum(idx_t max_nodes = INVALID_INDEX);
+
+   private:
+    //! Set if the tree supports concurrent operations
+    bool concurrent;
+    //! Lock word for the root pointer, the parent "node" of the root for lock coupling
+    mutable uint64_t root_version = 0;
+    //! Tracks the threads in the concurrent operations, and frees retired nodes once no
+    //! thread can read them anymore
+    std::unique_ptr<EpochManager> epochs;
+    std::unique_ptr<ValueArena> value_arena;
+    //! The snapshot that a read-only tree serves, see Map. Map sets the deleter, so that only
+    //! trees that map a snapshot link against its destructor in snapshot.cpp
+    std::unique_ptr<SnapshotMapping, void (*)(SnapshotMapping *)> mapping {nullptr, nullptr};
+    //! The checkpoint file that the tree writes to, see Checkpoint
+    std::unique_ptr<CheckpointState> checkpoint;
+
+    //! Throws if the tree serves a mapped snapshot, whose pages are read-only
+    void CheckWritable() const {
+        if (mapping) {
+            throw InternalException("Cannot modify a mapped tree.");
+        }
+    }
+
+    //! Single attempts of the concurrent operations, which set restart on a conflict
+    bool TryInsert(const ARTKey &key, const Node &leaf, bool &restart);
+    bool TryDelete(const ARTKey &key, bool &restart);
+    bool TryLookup(const ARTKey &key, Value &value, bool &restart) const;
+    //! Returns the version word of the inner node
+    uint64_t &GetVersion(const Node &node) const;
+    //! Frees a retired node, a leaf is retired with its prefix chain
+    void FreeRetired(const Node &node);
+    //! Sets the prefix of the (unpublished) leaf to the key bytes behind depth
+    void SetLeafPrefix(const Node &leaf, const ARTKey &key, idx_t depth);
+
+    //! Stores the key bytes behind depth with the new leaf, in the prefix of a Leaf, or in a
+    //! prefix chain ahead of an inlined leaf. Returns the node that the parent points to
+    Node AttachLeaf(const Node &leaf, const ARTKey &key, idx_t depth);
+    //! Walks the tree to the leaf of the key, returns the Leaf or the inlined leaf, or
+    //! Node() if the key does not exist
+    Node LookupLeaf(const ARTKey &key) const;
+    //! Returns the slot that holds the leaf of the key, or nullptr if the key does not exist
+    Node *LookupLeafMutable(const ARTKey &key);
+    //! Scans the row ids of an inlined leaf or a row id set, see ScanRowIds
+    idx_t ScanLeafRowIds(const Node &leaf, const std::function<bool(idx_t)> &callback) const;
+    //! Replaces the leaf with a row id set holding the count sorted row ids
+    void NewRowIdSet(Node &leaf, const idx_t *row_ids, const idx_t count);
+
+    //! Compares the prefix chain with the key at depth, and advances depth past it
+    bool MatchPrefix(Node prefix, const ARTKey &key, idx_t &depth) const;
+    //! Compares the prefix of an inner node (its inline prefix or its prefix chain) with the
+    //! key at depth, and advances depth past it
+    bool MatchPrefix(const InlinePrefix &inlined, Node prefix, const ARTKey &key, idx_t &depth) const;
+
+    //! Builds the subtree of the count sorted keys (sharing their first depth bytes) into
+    //! node. If sel is set, the keys and values are those at the positions in sel
+    void Construct(Node &node, const ARTKey *keys, const Value *values, const idx_t *sel, idx_t count,
+                   idx_t depth);
+    //! Returns the smallest inner node type that holds fan_out children
+    static NType GetNodeType(const idx_t fan_out);
+    //! Returns the prefix chain of the inner node
+    Node &GetPrefixMutable(const Node &node) const;
+    //! Returns the inline prefix of the inner node
+    InlinePrefix &GetInlinePrefixMutable(const Node &node) const;
+    //! Places a child at byte in the inner node, which is filled in order, with pos as the
+    //! position of the child among its children. Returns the child slot
+    Node *AppendChild(const Node &node, const idx_t pos, const uint8_t byte) const;
+
+    //! True while an incremental vacuum is in progress
+    bool vacuum_active = false;
+    //! The child bytes leading to the node at which the vacuum resumes
+    std::vector<uint8_t> vacuum_cursor;
+
+    //! Moves the node out of its block, if that block is being vacuumed
+    void VacuumPointer(Node &node);
+    //! Vacuums the node, its prefix and its subtree, returns false if the budget is exhausted
+    bool VacuumNode(Node &node, idx_t level, bool resume, idx_t &budget);
 };
 
 }  // namespace duckart
@@ -10,34 +10,43 @@
 
 namespace duckart {
 
+//! A key owns its bytes (new[]), or is a view of the bytes of a caller, e.g., a buffer on
+//! the stack (see StackARTKey) or one shared by a batch of keys. Copies of an owning key own
+//! their bytes, copies of a view are views of the same bytes
 class ARTKey {
    public:
-    ARTKey() : len(0), data(nullptr) {}
+    ARTKey() : len(0), data(nullptr), owned(false) {}
     ARTKey(const data_ptr_t &data, const uint32_t &len)
-        : len(len), data(new data_t[len]) {
+        : len(len), data(new data_t[len]), owned(true) {
         std::memcpy(this->data, data, len);
     }
-    ARTKey(const uint32_t &len) : len(len), data(new data_t[len]) {}
-    ~ARTKey() { delete[] data; }
+    ARTKey(const uint32_t &len) : len(len), data(new data_t[len]), owned(true) {}
+    ~ARTKey() {
+        if (owned) {
+            delete[] data;
+        }
+    }
 
     // Copy constructor
-    ARTKey(const ARTKey &other) : len(other.len), data(new data_t[other.len]) {
-        std::memcpy(data, other.data, len);
+    ARTKey(const ARTKey &other) : len(other.len), data(other.data), owned(other.owned) {
+        if (owned) {
+            data = new data_t[len];
+            std::memcpy(data, other.data, len);
+        }
     }
 
     // Move constructor
-    ARTKey(ARTKey &&other) noexcept : len(other.len), data(other.data) {
+    ARTKey(ARTKey &&other) noexcept : len(other.len), data(other.data), owned(other.owned) {
         other.data = nullptr;
         other.len = 0;
+        other.owned = false;
     }
 
     // Copy assignment operator
     ARTKey &operator=(const ARTKey &other) {
         if (this != &other) {
-            delete[] data;
-            len = other.len;
-            data = new data_t[len];
-            std::memcpy(data, other.data, len);
+            this->~ARTKey();
+            new (this) ARTKey(other);
         }
         return *this;
     }
@@ -45,31 +54,50 @@ class ARTKey {
     // Move assignment operator
     ARTKey &operator=(ARTKey &&other) noexcept {
         if (this != &other) {
-            delete[] data;
-            len = other.len;
-            data = other.data;
-            other.data = nullptr;
-            other.len = 0;
+            this->~ARTKey();
+            new (this) ARTKey(std::move(other));
         }
         return *this;
     }
 
+    //! Returns a key that does not own its bytes, the bytes must outlive the key
+    static inline ARTKey View(const data_ptr_t &data, const uint32_t &len) {
+        ARTKey key;
+        key.data = data;
+        key.len = len;
+        return key;
+    }
+
     uint32_t len;
     data_ptr_t data;
 
    public:
     template <class T>
     static inline ARTKey CreateARTKey(T element) {
-        auto data = ARTKey::CreateData<T>(element);
-        return ARTKey(data, sizeof(element));
+        ARTKey key(static_cast<uint32_t>(sizeof(element)));
+        Radix::EncodeData<T>(key.data, element);
+        return key;
     }
 
     template <class T>
     static inline void CreateARTKey(ARTKey &key, T element) {
-        key.data = ARTKey::CreateData<T>(element);
-        key.len = sizeof(element);
+        if (!key.owned || key.len != sizeof(element)) {
+            key = ARTKey(static_cast<uint32_t>(sizeof(element)));
+        }
+        Radix::EncodeData<T>(key.data, element);
     }
 
+    //! Encodes element into the sizeof(T) bytes at buffer, and returns a view of them
+    template <class T>
+    static inline ARTKey CreateARTKey(data_ptr_t buffer, T element) {
+        Radix::EncodeData<T>(buffer, element);
+        return View(buffer, sizeof(element));
+    }
+
+    //! Returns the length of the key of a string, i.e., the length of the buffer that
+    //! CreateARTKey(buffer, value) needs
+    static inline uint32_t GetKeyLength(const string_t &value) { return value.GetSize() + 1; }
+
 	void Print() const {
         std::cout << "ARTKey: length = " << len << ", data = ";
         for (uint32_t i = 0; i < len; ++i) {
@@ -89,15 +117,12 @@ class ARTKey {
         return data[depth] == other[depth];
     }
     inline bool Empty() const { return len == 0; }
+    inline bool IsView() const { return !owned && data; }
     void ConcatenateARTKey(ARTKey &concat_key);
 
    private:
-    template <class T>
-    static inline data_ptr_t CreateData(T value) {
-        auto data = new data_t[sizeof(value)];
-        Radix::EncodeData<T>(data, value);
-        return data;
-    }
+    //! Set if the key owns its bytes
+    bool owned;
 };
 
 template <>
@@ -106,5 +131,28 @@ template <>
 ARTKey ARTKey::CreateARTKey(const char *value);
 template <>
 void ARTKey::CreateARTKey( ARTKey &key, string_t value);
+template <>
+ARTKey ARTKey::CreateARTKey(data_ptr_t buffer, string_t value);
+template <>
+ARTKey ARTKey::CreateARTKey(data_ptr_t buffer, const char *value);
+
+//! A key of a fixed-width type in a buffer on the stack, so that building the key of a
+//! point lookup does not allocate:
+//!   StackARTKey<uint64_t> key(k);
+//!   art.Lookup(key);
+template <class T>
+class StackARTKey {
+   public:
+    explicit StackARTKey(T element) : key(ARTKey::CreateARTKey<T>(buffer, element)) {}
+    StackARTKey(const StackARTKey &) = delete;
+    StackARTKey &operator=(const StackARTKey &) = delete;
+
+    operator const ARTKey &() const { return key; }
+    const ARTKey &Get() const { return key; }
+
+   private:
+    data_t buffer[sizeof(T)];
+    ARTKey key;
+};
 
 }  // namespace duckart
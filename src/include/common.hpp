@@ -1,6 +1,7 @@
 #pragma once
 #include <cstdint>
 #include <cassert>
+#include <cstring>
 #include <functional> 
 #include <type_traits>
 
@@ -51,13 +52,21 @@ constexpr T MinValue(T a, T b) {
     return a < b ? a : b;
 }
 
+template <typename T>
+constexpr T MaxValue(T a, T b) {
+    return a > b ? a : b;
+}
+
 template <class T>
 struct MakeUnsigned {
 	using type = typename std::make_unsigned<T>::type;
 };
 
 //! node type
+//! An inlined leaf keeps its row id in the pointer bits and has no memory slot. It shares the
+//! tag with a cleared pointer, so the bits hold the row id plus one, see Leaf::NewInlined
 enum class NType : uint8_t {
+    LEAF_INLINED = 0,
     LEAF = 1,
     NODE_4 = 2,
     NODE_16 = 3,
@@ -77,7 +86,13 @@ static constexpr uint8_t NODE_16_CAPACITY = 16;
 static constexpr uint8_t NODE_48_CAPACITY = 48;
 static constexpr uint16_t NODE_256_CAPACITY = 256;
 //! Other constants
-static constexpr uint8_t PREFIX_SIZE = 15;
+static constexpr uint8_t PREFIX_SIZE = 14;
+//! Prefix nodes are segments of one of these slot sizes, the smallest is a Prefix with
+//! PREFIX_SIZE bytes, see Prefix::NewSegment
+static constexpr uint8_t PREFIX_SEGMENT_CLASSES = 6;
+static constexpr uint16_t PREFIX_SEGMENT_SIZES[PREFIX_SEGMENT_CLASSES] = {24, 64, 96, 128, 192, 256};
+//! Prefixes of inner nodes up to this length live in the node header, see InlinePrefix
+static constexpr uint8_t INLINE_PREFIX_SIZE = 10;
 static constexpr uint8_t EMPTY_MARKER = 48;  
 static constexpr idx_t INVALID_INDEX =  idx_t(-1);
 }
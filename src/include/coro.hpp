@@ -0,0 +1,162 @@
+#pragma once
+
+#include <array>
+#include <coroutine>
+#include <exception>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+
+namespace duckart {
+
+//! A coroutine that suspends after it prefetched the memory it reads next (co_await
+//! Prefetch{ptr}, or a prefetch followed by co_await std::suspend_always{}), so that a
+//! CoroScheduler can run other coroutines until the memory arrived. A task starts
+//! suspended, and owns its coroutine frame
+class CoroTask {
+   public:
+    struct promise_type {
+        CoroTask get_return_object() { return CoroTask(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { exception = std::current_exception(); }
+
+        //! Frames are recycled through per-thread free lists of FRAME_CLASS_SIZE size
+        //! classes, so that starting a task does not call malloc once a thread has warmed up
+        static void *operator new(size_t size) {
+            auto size_class = (size + FRAME_CLASS_SIZE - 1) / FRAME_CLASS_SIZE;
+            if (size_class >= FRAME_CLASS_COUNT) {
+                return ::operator new(size);
+            }
+            auto &free_list = FreeFrames()[size_class];
+            if (!free_list) {
+                return ::operator new(size_class * FRAME_CLASS_SIZE);
+            }
+            auto frame = free_list;
+            free_list = *reinterpret_cast<void **>(frame);
+            return frame;
+        }
+        static void operator delete(void *frame, size_t size) {
+            auto size_class = (size + FRAME_CLASS_SIZE - 1) / FRAME_CLASS_SIZE;
+            if (size_class >= FRAME_CLASS_COUNT) {
+                ::operator delete(frame);
+                return;
+            }
+            auto &free_list = FreeFrames()[size_class];
+            *reinterpret_cast<void **>(frame) = free_list;
+            free_list = frame;
+        }
+
+        std::exception_ptr exception;
+    };
+
+    CoroTask() = default;
+    CoroTask(const CoroTask &) = delete;
+    CoroTask &operator=(const CoroTask &) = delete;
+    CoroTask(CoroTask &&other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    CoroTask &operator=(CoroTask &&other) noexcept {
+        if (this != &other) {
+            Destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    ~CoroTask() { Destroy(); }
+
+    bool Valid() const { return static_cast<bool>(handle); }
+    bool Done() const { return handle.done(); }
+    //! Runs the coroutine until it suspends or returns, rethrows its exception
+    void Resume() {
+        D_ASSERT(Valid() && !Done());
+        handle.resume();
+        if (handle.done() && handle.promise().exception) {
+            std::rethrow_exception(handle.promise().exception);
+        }
+    }
+
+   private:
+    static constexpr size_t FRAME_CLASS_SIZE = 64;
+    static constexpr size_t FRAME_CLASS_COUNT = 16;
+
+    explicit CoroTask(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+    void Destroy() {
+        if (handle) {
+            handle.destroy();
+            handle = nullptr;
+        }
+    }
+
+    static std::array<void *, FRAME_CLASS_COUNT> &FreeFrames() {
+        thread_local FrameCache cache;
+        return cache.free_lists;
+    }
+
+    //! Returns the cached frames of a thread when it exits
+    struct FrameCache {
+        std::array<void *, FRAME_CLASS_COUNT> free_lists {};
+        ~FrameCache() {
+            for (auto frame : free_lists) {
+                while (frame) {
+                    auto next = *reinterpret_cast<void **>(frame);
+                    ::operator delete(frame);
+                    frame = next;
+                }
+            }
+        }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+//! Prefetches ptr and suspends the coroutine
+struct Prefetch {
+    const void *ptr;
+
+    bool await_ready() const noexcept {
+        __builtin_prefetch(ptr);
+        return false;
+    }
+    void await_suspend(std::coroutine_handle<>) const noexcept {}
+    void await_resume() const noexcept {}
+};
+
+//! Keeps up to width coroutines in flight, and resumes them round-robin: while one waits
+//! for the memory it prefetched, the others run. Index probes (see ART::LookupTask) and
+//! other memory-bound work can share a scheduler
+class CoroScheduler {
+   public:
+    explicit CoroScheduler(idx_t width) : tasks(width) { D_ASSERT(width > 0); }
+
+    //! Runs tasks until there are none left. next(slot, task) is called for every slot
+    //! whose task is invalid or finished (so that the caller can collect its result), and
+    //! assigns the next task to task and returns true, or returns false if there is none
+    template <class NEXT>
+    void Run(NEXT &&next) {
+        idx_t active = 0;
+        for (idx_t slot = 0; slot < tasks.size(); slot++) {
+            active += next(slot, tasks[slot]);
+        }
+
+        while (active) {
+            for (idx_t slot = 0; slot < tasks.size(); slot++) {
+                auto &task = tasks[slot];
+                if (!task.Valid()) {
+                    continue;
+                }
+                task.Resume();
+                if (task.Done() && !next(slot, task)) {
+                    task = CoroTask();
+                    active--;
+                }
+            }
+        }
+    }
+
+   private:
+    std::vector<CoroTask> tasks;
+};
+
+}  // namespace duckart
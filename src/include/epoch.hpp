@@ -0,0 +1,277 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "common.hpp"
+#include "fixed_size_allocator.hpp"
+#include "node.hpp"
+
+namespace duckart {
+
+// Epoch-based reclamation, following "Practical lock-freedom" by Fraser
+// (https://www.cl.cam.ac.uk/techreports/UCAM-CL-TR-579.pdf). Threads announce the global
+// epoch while they read the tree (EpochGuard). Unlinked nodes are retired into a limbo list
+// of the retiring thread, tagged with the global epoch. The global epoch only advances once
+// all active threads announced it, so after two advances no thread can still hold a
+// pointer to a node retired before them, and the node is freed.
+
+//! A retired node in a limbo list
+struct RetiredNode {
+    Node node;
+    //! The global epoch when the node was retired
+    uint64_t epoch;
+    //! The time when the node was retired, for the reclaim latency
+    std::chrono::steady_clock::time_point time;
+};
+
+//! Reclamation statistics, summed over all threads
+struct EpochStats {
+    //! Number of retired and of freed nodes
+    idx_t retired = 0;
+    idx_t reclaimed = 0;
+    //! Number of global epoch advances
+    idx_t advances = 0;
+    //! Total and maximum time spent in Retire (including the reclaiming it triggers)
+    double retire_ns = 0;
+    double max_retire_ns = 0;
+    //! Total and maximum time between retiring and freeing a node
+    double reclaim_delay_ns = 0;
+    double max_reclaim_delay_ns = 0;
+};
+
+class EpochManager {
+   public:
+    //! The epoch of a thread that is not in an EpochGuard
+    static constexpr uint64_t INACTIVE = UINT64_MAX;
+    //! Every RECLAIM_INTERVAL retired nodes, a thread tries to advance the global epoch and
+    //! frees the expired nodes of its limbo list
+    static constexpr idx_t RECLAIM_INTERVAL = 64;
+
+    //! free_node frees a retired node, it runs on the thread that reclaims the node
+    explicit EpochManager(std::function<void(const Node &)> free_node);
+    ~EpochManager();
+
+    EpochManager(const EpochManager &) = delete;
+    EpochManager &operator=(const EpochManager &) = delete;
+
+    //! Announces the current global epoch for the calling thread, guards may nest
+    void Enter();
+    void Leave();
+    //! Adds the node to the limbo list of the calling thread, which must be in an
+    //! EpochGuard, and the node must not be reachable anymore
+    void Retire(const Node &node);
+    //! Frees the nodes in all limbo lists. Must not run concurrently with any guard
+    void ReclaimAll();
+
+    //! Sums the statistics of all threads, while the tree is quiescent
+    EpochStats GetStats() const;
+    uint64_t GetEpoch() const { return global_epoch.load(std::memory_order_relaxed); }
+    //! Number of thread states, at most the number of threads that used the manager at the
+    //! same time
+    idx_t GetThreadCount() const;
+
+   private:
+    //! The epoch state of a thread, only the thread itself writes it (other than local_epoch,
+    //! which other threads read)
+    struct ThreadState {
+        std::atomic<uint64_t> local_epoch{INACTIVE};
+        idx_t depth = 0;
+        std::vector<RetiredNode> limbo;
+        EpochStats stats;
+    };
+
+    //! Returns the state of the calling thread, and creates it on the first call
+    ThreadState &GetThreadState();
+    ThreadState &AddThreadState(idx_t index);
+    //! Calls callback for every thread state, the caller holds threads_lock
+    template <typename F>
+    void ForEachThreadState(F &&callback) const;
+    //! Advances the global epoch if all active threads announced it
+    bool TryAdvance(ThreadState &state);
+    //! Frees the nodes of the limbo list that were retired two or more epochs ago
+    void Reclaim(ThreadState &state, bool all);
+
+    static constexpr idx_t THREAD_CHUNK_SIZE = 256;
+    static constexpr idx_t THREAD_CHUNKS = ThreadIndex::MAX_THREADS / THREAD_CHUNK_SIZE;
+
+    std::function<void(const Node &)> free_node;
+    std::atomic<uint64_t> global_epoch{0};
+    //! The thread states by ThreadIndex, in chunks that never move, like the thread caches of
+    //! FixedSizeAllocator. The next thread with the index of an exited thread takes over its
+    //! state, with the nodes left in its limbo list. Created under threads_lock
+    std::atomic<std::atomic<ThreadState *> *> thread_states[THREAD_CHUNKS]{};
+    mutable std::mutex threads_lock;
+};
+
+inline EpochManager::EpochManager(std::function<void(const Node &)> free_node) : free_node(std::move(free_node)) {}
+
+inline EpochManager::~EpochManager() {
+    // the owner reclaims all limbo lists before its nodes go away
+    for (auto &chunk : thread_states) {
+        auto states = chunk.load(std::memory_order_relaxed);
+        for (idx_t i = 0; states && i < THREAD_CHUNK_SIZE; i++) {
+            auto state = states[i].load(std::memory_order_relaxed);
+            D_ASSERT(!state || state->limbo.empty());
+            delete state;
+        }
+        delete[] states;
+    }
+}
+
+inline EpochManager::ThreadState &EpochManager::GetThreadState() {
+    auto index = ThreadIndex::Get();
+    auto chunk = thread_states[index / THREAD_CHUNK_SIZE].load(std::memory_order_acquire);
+    if (chunk) {
+        auto state = chunk[index % THREAD_CHUNK_SIZE].load(std::memory_order_relaxed);
+        if (state) {
+            return *state;
+        }
+    }
+    return AddThreadState(index);
+}
+
+inline EpochManager::ThreadState &EpochManager::AddThreadState(idx_t index) {
+    std::lock_guard<std::mutex> guard(threads_lock);
+    auto &chunk = thread_states[index / THREAD_CHUNK_SIZE];
+    if (!chunk.load(std::memory_order_relaxed)) {
+        chunk.store(new std::atomic<ThreadState *>[THREAD_CHUNK_SIZE](), std::memory_order_release);
+    }
+    auto state = new ThreadState();
+    chunk.load(std::memory_order_relaxed)[index % THREAD_CHUNK_SIZE].store(state, std::memory_order_release);
+    return *state;
+}
+
+template <typename F>
+void EpochManager::ForEachThreadState(F &&callback) const {
+    for (auto &chunk : thread_states) {
+        auto states = chunk.load(std::memory_order_acquire);
+        for (idx_t i = 0; states && i < THREAD_CHUNK_SIZE; i++) {
+            if (auto state = states[i].load(std::memory_order_acquire)) {
+                callback(*state);
+            }
+        }
+    }
+}
+
+inline void EpochManager::Enter() {
+    auto &state = GetThreadState();
+    if (state.depth++ > 0) {
+        return;
+    }
+    // the announced epoch might already be outdated, which only delays the next advance
+    state.local_epoch.store(global_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+    // the announcement must be visible before the thread reads any node
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+inline void EpochManager::Leave() {
+    auto &state = GetThreadState();
+    D_ASSERT(state.depth > 0);
+    if (--state.depth == 0) {
+        state.local_epoch.store(INACTIVE, std::memory_order_release);
+    }
+}
+
+inline void EpochManager::Retire(const Node &node) {
+    auto start = std::chrono::steady_clock::now();
+    auto &state = GetThreadState();
+    state.limbo.push_back({node, global_epoch.load(std::memory_order_seq_cst), start});
+    state.stats.retired++;
+
+    if (state.stats.retired % RECLAIM_INTERVAL == 0) {
+        TryAdvance(state);
+        Reclaim(state, false);
+    }
+
+    auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    state.stats.retire_ns += ns;
+    state.stats.max_retire_ns = MaxValue(state.stats.max_retire_ns, ns);
+}
+
+inline bool EpochManager::TryAdvance(ThreadState &state) {
+    auto epoch = global_epoch.load(std::memory_order_seq_cst);
+    {
+        std::lock_guard<std::mutex> guard(threads_lock);
+        auto behind = false;
+        ForEachThreadState([&](ThreadState &thread) {
+            auto local_epoch = thread.local_epoch.load(std::memory_order_seq_cst);
+            behind = behind || (local_epoch != INACTIVE && local_epoch != epoch);
+        });
+        if (behind) {
+            return false;
+        }
+    }
+    if (!global_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst)) {
+        return false;
+    }
+    state.stats.advances++;
+    return true;
+}
+
+inline void EpochManager::Reclaim(ThreadState &state, const bool all) {
+    // the limbo list is in retire order, so its epochs do not decrease
+    auto epoch = global_epoch.load(std::memory_order_seq_cst);
+    auto now = std::chrono::steady_clock::now();
+    idx_t count = 0;
+    while (count < state.limbo.size() && (all || state.limbo[count].epoch + 2 <= epoch)) {
+        auto &retired = state.limbo[count];
+        free_node(retired.node);
+        auto ns = std::chrono::duration<double, std::nano>(now - retired.time).count();
+        state.stats.reclaim_delay_ns += ns;
+        state.stats.max_reclaim_delay_ns = MaxValue(state.stats.max_reclaim_delay_ns, ns);
+        count++;
+    }
+    state.limbo.erase(state.limbo.begin(), state.limbo.begin() + count);
+    state.stats.reclaimed += count;
+}
+
+inline void EpochManager::ReclaimAll() {
+    std::lock_guard<std::mutex> guard(threads_lock);
+    ForEachThreadState([&](ThreadState &state) {
+        D_ASSERT(state.local_epoch.load() == INACTIVE);
+        Reclaim(state, true);
+    });
+}
+
+inline EpochStats EpochManager::GetStats() const {
+    EpochStats result;
+    std::lock_guard<std::mutex> guard(threads_lock);
+    ForEachThreadState([&](const ThreadState &state) {
+        auto &stats = state.stats;
+        result.retired += stats.retired;
+        result.reclaimed += stats.reclaimed;
+        result.advances += stats.advances;
+        result.retire_ns += stats.retire_ns;
+        result.max_retire_ns = MaxValue(result.max_retire_ns, stats.max_retire_ns);
+        result.reclaim_delay_ns += stats.reclaim_delay_ns;
+        result.max_reclaim_delay_ns = MaxValue(result.max_reclaim_delay_ns, stats.max_reclaim_delay_ns);
+    });
+    return result;
+}
+
+inline idx_t EpochManager::GetThreadCount() const {
+    idx_t count = 0;
+    std::lock_guard<std::mutex> guard(threads_lock);
+    ForEachThreadState([&](const ThreadState &) { count++; });
+    return count;
+}
+
+//! Keeps the calling thread in the current epoch for its lifetime
+class EpochGuard {
+   public:
+    explicit EpochGuard(EpochManager &epochs) : epochs(epochs) { epochs.Enter(); }
+    ~EpochGuard() { epochs.Leave(); }
+
+    EpochGuard(const EpochGuard &) = delete;
+    EpochGuard &operator=(const EpochGuard &) = delete;
+
+   private:
+    EpochManager &epochs;
+};
+
+}  // namespace duckart
@@ -27,3 +27,16 @@ public:
         return m_message.c_str();
     }
 };
+
+
+class IOException : public std::exception {
+private:
+    std::string m_message;
+
+public:
+    explicit IOException(const std::string& message) : m_message(message) {}
+
+    const char* what() const noexcept override {
+        return m_message.c_str();
+    }
+};
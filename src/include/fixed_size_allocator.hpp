@@ -1,68 +1,467 @@
 // https://arxiv.org/pdf/2210.16471
 #pragma once
 
+#include <atomic>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <string>
 #include <sstream>
 #include <iostream>
+#include <vector>
 
+#include "index_pointer.hpp"
 #include "node.hpp"
 
 namespace duckart {
 class Node;
 
-class FixedSizeAllocator {
+//! The BlockHeader sits at the start of every block of a FixedSizeAllocator. Blocks are
+//! aligned to their (power of two) size, so the owning block of any slot is found by
+//! masking the slot address. The occupancy bitmap (one bit per slot) follows the header.
+struct BlockHeader {
+    //! Id of the block in its BlockDirectory
+    idx_t blockId;
+    //! Number of occupied slots
+    idx_t used;
+    //! First bitmap word that might contain a free slot
+    idx_t freeHint;
+    //! Set while the block is being vacuumed, New does not hand out its slots
+    idx_t vacuum;
+
+    uint64_t* GetBitmap() { return reinterpret_cast<uint64_t*>(this + 1); }
+};
+
+//! Maps the block ids of IndexPointers to blocks. All allocators of a tree share one directory,
+//! so that any of them resolves any pointer of the tree, and a tree that adopts the blocks of
+//! another one keeps their ids (see ART::ParallelBuild). Ids are registered under a lock and
+//! resolved without one, the directory grows in chunks that never move. Next to every block,
+//! the directory keeps a dirty bit per page of the block, set if the page changed since the
+//! last checkpoint (see ART::Checkpoint)
+class BlockDirectory {
+public:
+    static constexpr idx_t CHUNK_BITS = 10;
+    static constexpr idx_t CHUNK_SIZE = idx_t(1) << CHUNK_BITS;
+    static constexpr idx_t MAX_CHUNKS = 4096;
+    //! The granularity of the dirty bits, blocks of more than MAX_PAGES such pages use larger
+    //! pages (see FixedSizeAllocator::GetPageSize)
+    static constexpr idx_t PAGE_SIZE = 4096;
+    //! Number of dirty bits of a block, one per page of the 2 MiB blocks of Node256
+    static constexpr idx_t MAX_PAGES = 512;
+    static constexpr idx_t PAGE_WORDS = MAX_PAGES / 64;
+
+    BlockDirectory() = default;
+    ~BlockDirectory();
+
+    //! Delete copy constructors, as the directory owns its chunks
+    BlockDirectory(const BlockDirectory&) = delete;
+    BlockDirectory& operator=(const BlockDirectory&) = delete;
+
+    //! Returns the block of the id, or nullptr if the id is not registered
+    BlockHeader* Get(idx_t blockId) const {
+        auto chunk = chunks[blockId >> CHUNK_BITS].load(std::memory_order_relaxed);
+        return chunk[blockId & (CHUNK_SIZE - 1)].load(std::memory_order_relaxed);
+    }
+    //! Assigns an id to the block and sets header->blockId, reuses the ids of released blocks
+    void Register(BlockHeader* header);
+    //! Registers the block under blockId, e.g., a block of a snapshot (see ART::Deserialize),
+    //! without writing to it. Throws if the id is taken. Registered blocks start out with all
+    //! pages dirty
+    void RegisterAt(BlockHeader* header, idx_t blockId);
+    //! Releases the id of a block that is about to be freed
+    void Unregister(idx_t blockId);
+    //! All registered ids are below this number
+    idx_t GetIdCount() const;
+
+    //! Marks the pages first to last of the registered block as changed since the last
+    //! checkpoint. The bits are read first, so that marking a dirty page again does not write
+    //! to the shared cache line
+    void MarkDirty(idx_t blockId, idx_t first, idx_t last) const {
+        D_ASSERT(first <= last && last < MAX_PAGES);
+        auto words = GetDirtyWords(blockId);
+        for (auto page = first; page <= last; page++) {
+            auto& word = words[page / 64];
+            auto bit = uint64_t(1) << (page % 64);
+            if (!(word.load(std::memory_order_relaxed) & bit)) {
+                word.fetch_or(bit, std::memory_order_relaxed);
+            }
+        }
+    }
+    //! Marks all pages of the registered block as changed
+    void MarkDirty(idx_t blockId) const {
+        auto words = GetDirtyWords(blockId);
+        for (idx_t i = 0; i < PAGE_WORDS; i++) {
+            words[i].store(~uint64_t(0), std::memory_order_relaxed);
+        }
+    }
+    bool IsDirty(idx_t blockId) const {
+        auto words = GetDirtyWords(blockId);
+        for (idx_t i = 0; i < PAGE_WORDS; i++) {
+            if (words[i].load(std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    bool IsDirty(idx_t blockId, idx_t page) const {
+        return GetDirtyWords(blockId)[page / 64].load(std::memory_order_relaxed) & (uint64_t(1) << (page % 64));
+    }
+    //! Clears the bits once the block is in a checkpoint, while the tree is quiescent
+    void ClearDirty(idx_t blockId) const {
+        auto words = GetDirtyWords(blockId);
+        for (idx_t i = 0; i < PAGE_WORDS; i++) {
+            words[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    mutable std::mutex lock;
+    std::vector<idx_t> freeIds;
+    idx_t idCount = 0;
+    std::atomic<std::atomic<BlockHeader*>*> chunks[MAX_CHUNKS] {};
+    //! The dirty bits, PAGE_WORDS words per block, in chunks parallel to those of the blocks
+    std::atomic<std::atomic<uint64_t>*> dirty[MAX_CHUNKS] {};
+
+    std::atomic<uint64_t>* GetDirtyWords(idx_t blockId) const {
+        return dirty[blockId >> CHUNK_BITS].load(std::memory_order_relaxed) + (blockId & (CHUNK_SIZE - 1)) * PAGE_WORDS;
+    }
+    //! Allocates the chunks of blockId, the caller holds the lock
+    void addChunk(idx_t blockId);
+};
+
+//! Small dense indexes of the live threads, under which the allocators keep the cache of each
+//! thread. A thread takes the smallest free index on its first call, and hands it back when it
+//! exits, so that the next thread takes over the caches of an exited one, and the number of
+//! caches is bounded by the number of threads that run at the same time
+class ThreadIndex {
 public:
-    FixedSizeAllocator(size_t elementSize, size_t blockCapacity = 256)
-        : elementSize(elementSize),
-          blockCapacity(blockCapacity),
-          used(0),
-          freeList(nullptr) {
-        addBlock();
+    static constexpr idx_t MAX_THREADS = 16384;
+
+    static idx_t Get() {
+        thread_local Holder holder;
+        return holder.index;
     }
 
+private:
+    struct Holder {
+        idx_t index;
+        Holder() : index(Acquire()) {}
+        ~Holder() { Release(index); }
+    };
+    static idx_t Acquire();
+    static void Release(idx_t index);
+};
+
+//! Statistics of the thread caches of an allocator, summed over all threads
+struct ThreadCacheStats {
+    //! New calls, and those served from the thread cache
+    idx_t allocations = 0;
+    idx_t allocation_hits = 0;
+    //! Free calls, and those absorbed by the thread cache
+    idx_t frees = 0;
+    idx_t free_hits = 0;
+    //! Batches moved from and to the shared blocks
+    idx_t refills = 0;
+    idx_t spills = 0;
+};
+
+class FixedSizeAllocator {
+public:
+    //! Maximum number of free slots in a thread cache
+    static constexpr idx_t THREAD_CACHE_CAPACITY = 64;
+    //! Number of slots that a thread cache takes from, or returns to, the shared blocks
+    static constexpr idx_t THREAD_CACHE_BATCH = 32;
+
+    //! The allocator registers its blocks in directory, or in a directory of its own
+    FixedSizeAllocator(size_t elementSize, size_t blockCapacity = 256,
+                       std::shared_ptr<BlockDirectory> directory = nullptr);
+    ~FixedSizeAllocator();
+
+    //! Delete copy constructors, as the allocator owns its blocks
+    FixedSizeAllocator(const FixedSizeAllocator&) = delete;
+    FixedSizeAllocator& operator=(const FixedSizeAllocator&) = delete;
+
     void* New() {
-        if (freeList) {
-            void* block = freeList;
-            freeList = *reinterpret_cast<void**>(freeList);
-            used++;
-            return block;
+        if (cached) {
+            auto& cache = GetThreadCache();
+            cache.stats.allocations++;
+            if (cache.count == 0) {
+                refill(cache);
+            } else {
+                cache.stats.allocation_hits++;
+            }
+            // the caller fills the slot, so its block differs from the last checkpoint
+            auto slot = cache.slots[--cache.count];
+            MarkDirty(slot);
+            return slot;
         }
-        if (used % blockCapacity == 0) {
-            addBlock();
+        std::unique_lock<std::mutex> guard(lock, std::defer_lock);
+        if (concurrent) {
+            guard.lock();
         }
-        size_t blockIndex = used / blockCapacity;
-        size_t indexInBlock = used % blockCapacity;
-        used++;
-        return &blocks[blockIndex][indexInBlock * elementSize];
+        return newSlot();
     }
+    //! Returns a pointer to a new slot, with the tag type
+    IndexPointer New(NType type) { return ToPointer(New(), type); }
 
+    //! Returns the slot to its block in O(1), blocks that become empty are handed back
+    //! to the OS as long as another block with free space remains
     void Free(void* ptr) {
-        for (size_t i = 0; i < blocks.size(); ++i) {
-            if (ptr >= blocks[i].get() && ptr < blocks[i].get() + blockCapacity * elementSize) {
-                *reinterpret_cast<void**>(ptr) = freeList;
-                freeList = ptr;
-                used--;
-                return;
+        // slots of vacuumed blocks must not be handed out again, so they bypass the cache
+        if (cached && !GetHeader(ptr)->vacuum) {
+            auto& cache = GetThreadCache();
+            cache.stats.frees++;
+            if (cache.count == THREAD_CACHE_CAPACITY) {
+                spill(cache);
+            } else {
+                cache.stats.free_hits++;
             }
+            cache.slots[cache.count++] = ptr;
+            return;
+        }
+        std::unique_lock<std::mutex> guard(lock, std::defer_lock);
+        if (concurrent) {
+            guard.lock();
         }
+        freeSlot(ptr);
     }
-	
-	   template <typename T>
-    T* Get(const Node& ptr) const ;
+    void Free(const IndexPointer& ptr) { Free(Get<void>(ptr)); }
 
+    //! Serializes New and Free, so that several threads can share the allocator
+    void SetConcurrent(bool concurrent) { this->concurrent = concurrent; }
+    //! Serves New and Free from a small per-thread stack of free slots (a magazine), which
+    //! refills from and spills to the shared blocks in batches of THREAD_CACHE_BATCH slots.
+    //! Disabling the caches flushes them
+    void SetThreadCache(bool enable);
+    //! Returns the slots of all thread caches to their blocks. Must not run concurrently
+    //! with New or Free
+    void FlushThreadCaches();
+    //! Sums the statistics of all thread caches, while the allocator is quiescent
+    ThreadCacheStats GetThreadCacheStats() const;
+
+    //! Selects the sparsest blocks for vacuuming, such that their slots fit into the free
+    //! slots of the remaining blocks. Returns false if vacuuming would not free enough blocks
+    bool InitializeVacuum();
+    //! Returns any blocks that still hold slots back to the pool
+    void FinalizeVacuum();
+    //! Returns true if the slot lives in a block that is being vacuumed
+    bool NeedsVacuum(const IndexPointer& ptr) const {
+        return directory->Get(ptr.GetBlockId())->vacuum;
+    }
+    //! Moves the slot out of its vacuumed block and returns its new location, with the tag of ptr
+    IndexPointer VacuumPointer(const IndexPointer& ptr);
+    bool IsVacuuming() const { return !vacuumBlocks.empty(); }
+
+    //! Takes over all blocks of other, which must have the same element size and share the
+    //! directory, without moving any slots. Pointers into other stay valid and are owned by
+    //! this allocator
+    void Adopt(FixedSizeAllocator& other);
+
+    //! Resolves a pointer to its slot through the block directory, so the allocator of any
+    //! node type of the tree resolves the pointers of all types
+    template <typename T>
+    T* Get(const IndexPointer& ptr) const {
+        return reinterpret_cast<T*>(reinterpret_cast<char*>(directory->Get(ptr.GetBlockId())) + ptr.GetOffset());
+    }
+    //! Returns the pointer of a slot of this allocator
+    IndexPointer ToPointer(const void* slot, NType type) const {
+        auto header = GetHeader(slot);
+        return IndexPointer(header->blockId, static_cast<const char*>(slot) - reinterpret_cast<const char*>(header),
+                            type);
+    }
+    const std::shared_ptr<BlockDirectory>& GetDirectory() const { return directory; }
+
+    //! Marks the pages of the slot as changed since the last checkpoint (see ART::Checkpoint).
+    //! New and Free mark the slots that they hand out or take back, and the block header,
+    //! Node::RefMutable the nodes that the tree modifies
+    void MarkDirty(const IndexPointer& ptr) const { markSlot(ptr.GetBlockId(), ptr.GetOffset()); }
+    void MarkDirty(const void* slot) const {
+        auto header = GetHeader(slot);
+        markSlot(header->blockId, static_cast<const char*>(slot) - reinterpret_cast<const char*>(header));
+    }
+    //! Ids of the blocks that changed since the last checkpoint, in ascending order
+    std::vector<idx_t> GetDirtyBlockIds() const;
+    //! Returns true if the page of the block changed since the last checkpoint
+    bool IsDirty(idx_t blockId, idx_t page) const { return directory->IsDirty(blockId, page); }
+    //! The unit of dirty tracking, and of checkpoint writes: BlockDirectory::PAGE_SIZE, or for
+    //! blocks with more than BlockDirectory::MAX_PAGES of those, the power of two that divides
+    //! the block into MAX_PAGES pages
+    size_t GetPageSize() const { return size_t(1) << pageShift; }
+    //! Clears the dirty bits of all blocks, once they are in a checkpoint
+    void ClearDirty();
+
+    //! Ids of the blocks of this allocator, in ascending order
+    std::vector<idx_t> GetBlockIds() const { return std::vector<idx_t>(blocks.begin(), blocks.end()); }
+    //! Calls callback for every occupied slot of block, which is a block of this allocator or
+    //! a copy of one
+    template <typename F>
+    void ForEachSlot(BlockHeader* block, F&& callback) const {
+        auto bitmap = block->GetBitmap();
+        for (idx_t word = 0; word < bitmapWords; word++) {
+            auto bits = bitmap[word];
+            if (word == bitmapWords - 1 && blockCapacity % 64) {
+                // the padding bits are always set
+                bits &= ~(~uint64_t(0) << (blockCapacity % 64));
+            }
+            while (bits) {
+                auto bit = static_cast<idx_t>(__builtin_ctzll(bits));
+                bits &= bits - 1;
+                callback(reinterpret_cast<char*>(block) + dataOffset + (word * 64 + bit) * elementSize);
+            }
+        }
+    }
+    //! Frees all slots and releases all blocks, e.g., before loading a snapshot. Must not run
+    //! concurrently with New or Free
+    void Reset();
+    //! Adds blocks with uninitialized contents under blockIds, which the caller fills with the
+    //! blocks of a snapshot. FinalizeLoad takes over the slots of the filled blocks
+    std::vector<BlockHeader*> LoadBlocks(const std::vector<idx_t>& blockIds);
+    void FinalizeLoad();
+    size_t GetElementSize() const { return elementSize; }
+
+    //! Number of occupied slots, which includes the free slots in thread caches
     size_t GetUsed() const { return used; }
     size_t GetCapacity() const { return blocks.size() * blockCapacity; }
+    //! Number of blocks currently held by the allocator
+    size_t GetBlockCount() const { return blocks.size(); }
+    //! Size (and alignment) of a block in bytes
+    size_t GetBlockSize() const { return blockSize; }
 
 private:
-    std::vector<std::unique_ptr<char[]>> blocks;
+    //! Resolves the block ids of all allocators of the tree
+    std::shared_ptr<BlockDirectory> directory;
+    //! Ids of the blocks of this allocator
+    std::set<idx_t> blocks;
+    //! Ids of the blocks that are not full, New fills the lowest block first
+    std::set<idx_t> blocksWithFreeSpace;
+    //! Ids of the blocks that are being vacuumed
+    std::set<idx_t> vacuumBlocks;
     size_t elementSize;
     size_t blockCapacity;
+    size_t blockSize;
+    size_t bitmapWords;
+    size_t dataOffset;
+    //! Log2 of GetPageSize
+    size_t pageShift;
     size_t used;
-    void* freeList;
+    //! Set if New and Free take the lock
+    bool concurrent = false;
+    //! Set if New and Free go through the thread caches
+    bool cached = false;
+    //! Guards the blocks, and the creation of thread caches
+    mutable std::mutex lock;
+
+    //! The free slots that a thread keeps for itself, only the thread that holds its index
+    //! accesses it
+    struct ThreadCache {
+        void* slots[THREAD_CACHE_CAPACITY];
+        idx_t count = 0;
+        ThreadCacheStats stats;
+    };
+    static constexpr idx_t THREAD_CHUNK_SIZE = 256;
+    static constexpr idx_t THREAD_CHUNKS = ThreadIndex::MAX_THREADS / THREAD_CHUNK_SIZE;
+    //! The thread caches by ThreadIndex, in chunks that never move
+    std::atomic<std::atomic<ThreadCache*>*> threadCaches[THREAD_CHUNKS] {};
+
+    BlockHeader* GetHeader(const void* ptr) const {
+        return reinterpret_cast<BlockHeader*>(reinterpret_cast<uintptr_t>(ptr) & ~(blockSize - 1));
+    }
+    //! Marks the pages of the slot at offset in the block as dirty
+    void markSlot(idx_t blockId, idx_t offset) const {
+        directory->MarkDirty(blockId, offset >> pageShift, (offset + elementSize - 1) >> pageShift);
+    }
+    //! Marks the slot at offset, and the header and bitmap, which New and Free update
+    void markSlotAndHeader(BlockHeader* header, idx_t offset) const {
+        directory->MarkDirty(header->blockId, 0, (dataOffset - 1) >> pageShift);
+        markSlot(header->blockId, offset);
+    }
 
-    void addBlock() {
-        blocks.push_back(std::make_unique<char[]>(elementSize * blockCapacity));
+    //! Returns the cache of the calling thread, and creates it on the first call
+    ThreadCache& GetThreadCache() {
+        auto index = ThreadIndex::Get();
+        auto chunk = threadCaches[index / THREAD_CHUNK_SIZE].load(std::memory_order_acquire);
+        if (chunk) {
+            auto cache = chunk[index % THREAD_CHUNK_SIZE].load(std::memory_order_relaxed);
+            if (cache) {
+                return *cache;
+            }
+        }
+        return addThreadCache(index);
     }
+    //! Calls callback for every thread cache
+    template <typename F>
+    void forEachThreadCache(F&& callback) const {
+        for (auto& chunk : threadCaches) {
+            auto caches = chunk.load(std::memory_order_acquire);
+            for (idx_t i = 0; caches && i < THREAD_CHUNK_SIZE; i++) {
+                if (auto cache = caches[i].load(std::memory_order_relaxed)) {
+                    callback(*cache);
+                }
+            }
+        }
+    }
+
+    //! Takes a slot from the blocks, the caller holds the lock if the allocator is concurrent
+    void* newSlot() {
+        if (blocksWithFreeSpace.empty()) {
+            addBlock();
+        }
+        auto header = directory->Get(*blocksWithFreeSpace.begin());
+        auto bitmap = header->GetBitmap();
+
+        // find the first free slot, the bitmap padding bits are always set
+        auto word = header->freeHint;
+        while (bitmap[word] == ~uint64_t(0)) {
+            word++;
+        }
+        D_ASSERT(word < bitmapWords);
+        auto bit = static_cast<idx_t>(__builtin_ctzll(~bitmap[word]));
+        bitmap[word] |= uint64_t(1) << bit;
+        header->freeHint = word;
+
+        header->used++;
+        used++;
+        auto offset = dataOffset + (word * 64 + bit) * elementSize;
+        markSlotAndHeader(header, offset);
+        if (header->used == blockCapacity) {
+            blocksWithFreeSpace.erase(header->blockId);
+        }
+        return reinterpret_cast<char*>(header) + offset;
+    }
+
+    //! Returns a slot to its block, the caller holds the lock if the allocator is concurrent
+    void freeSlot(void* ptr) {
+        auto header = GetHeader(ptr);
+        auto offset = static_cast<idx_t>(static_cast<char*>(ptr) - reinterpret_cast<char*>(header));
+        D_ASSERT(offset >= dataOffset && (offset - dataOffset) % elementSize == 0);
+        auto slot = (offset - dataOffset) / elementSize;
+
+        auto bitmap = header->GetBitmap();
+        auto word = slot / 64;
+        auto mask = uint64_t(1) << (slot % 64);
+        D_ASSERT(bitmap[word] & mask);
+        bitmap[word] &= ~mask;
+        if (word < header->freeHint) {
+            header->freeHint = word;
+        }
+
+        if (header->used == blockCapacity && !header->vacuum) {
+            blocksWithFreeSpace.insert(header->blockId);
+        }
+        header->used--;
+        used--;
+        markSlotAndHeader(header, offset);
+        if (header->used == 0 && (header->vacuum || blocksWithFreeSpace.size() > 1)) {
+            releaseBlock(header->blockId);
+        }
+    }
+
+    ThreadCache& addThreadCache(idx_t index);
+    //! Deletes the thread caches while the allocator is quiescent, the threads create new ones
+    void freeThreadCaches();
+    void refill(ThreadCache& cache);
+    void spill(ThreadCache& cache);
+    void addBlock();
+    void releaseBlock(idx_t blockId);
 };
 }  // namespace duckart
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "common.hpp"
+#include <utility>
+#include <string>
+#include <sstream>
+
+namespace duckart {
+
+//! A pointer to a slot of a FixedSizeAllocator: the id of its block and the byte offset of the
+//! slot in the block, resolved through the BlockDirectory of the tree (see
+//! FixedSizeAllocator::Get). The pointer does not depend on the address of the block, so it stays
+//! valid when a block moves, or is written to and read back from a file.
+//! Layout: [gate:1][block id:26][offset:29][type:8]. The type takes a byte, so that new node
+//! types fit next to the eight of NType. Nodes without memory slot keep a payload in the block id
+//! and offset bits instead (see SetPayload)
+class IndexPointer {
+   private:
+    uint64_t data;
+    static constexpr uint64_t TAG_BITS = 8;
+    static constexpr uint64_t TAG_MASK = 0xFF;
+    static constexpr uint64_t OFFSET_BITS = 29;
+    static constexpr uint64_t OFFSET_MASK = ((uint64_t(1) << OFFSET_BITS) - 1) << TAG_BITS;
+    static constexpr uint64_t BLOCK_SHIFT = TAG_BITS + OFFSET_BITS;
+    //! Marks a gate, the root of a nested tree
+    static constexpr uint64_t GATE_BIT = static_cast<uint64_t>(1) << 63;
+    static constexpr uint64_t PAYLOAD_MASK = ~(TAG_MASK | GATE_BIT);
+
+   public:
+    //! Largest payload that fits into the pointer bits
+    static constexpr uint64_t MAX_PAYLOAD = PAYLOAD_MASK >> TAG_BITS;
+    //! Largest block id, and largest offset of a slot in its block
+    static constexpr idx_t MAX_BLOCK_ID = (uint64_t(1) << (63 - BLOCK_SHIFT)) - 1;
+    static constexpr idx_t MAX_OFFSET = (uint64_t(1) << OFFSET_BITS) - 1;
+    //! Largest type tag
+    static constexpr uint64_t MAX_TAG = TAG_MASK;
+    static_assert(static_cast<uint64_t>(NType::NODE_DUMMY) <= MAX_TAG, "Every NType fits into the tag");
+
+    IndexPointer() : data(static_cast<uint64_t>(NType::NODE_DUMMY)) {}
+    IndexPointer(idx_t block_id, idx_t offset, NType tag) {
+        D_ASSERT(block_id <= MAX_BLOCK_ID && offset <= MAX_OFFSET);
+        data = (static_cast<uint64_t>(block_id) << BLOCK_SHIFT) | (static_cast<uint64_t>(offset) << TAG_BITS) |
+               static_cast<uint64_t>(tag);
+    }
+
+    idx_t GetBlockId() const { return static_cast<idx_t>((data & ~GATE_BIT) >> BLOCK_SHIFT); }
+    idx_t GetOffset() const { return static_cast<idx_t>((data & OFFSET_MASK) >> TAG_BITS); }
+
+    NType getTag() const { return static_cast<NType>(data & TAG_MASK); }
+
+    void setTag(NType tag) {
+        data = (data & ~TAG_MASK) | static_cast<uint64_t>(tag);
+    }
+
+    bool IsGate() const { return data & GATE_BIT; }
+
+    void SetGate(bool gate) { data = gate ? data | GATE_BIT : data & ~GATE_BIT; }
+
+    void Clear() {
+        data = 0;  // This sets both the pointer and tag to 0
+    }
+
+    bool IsCleared() const { return data == 0; }
+
+    //! Returns true if both point to the same slot, regardless of the tag and the gate bit
+    bool SameSlot(const IndexPointer &other) const {
+        return ((data ^ other.data) & PAYLOAD_MASK) == 0;
+    }
+
+    //! Stores payload in the pointer bits instead of a pointer, for nodes without memory slot
+    void SetPayload(uint64_t payload, NType tag) {
+        D_ASSERT(payload <= MAX_PAYLOAD);
+        data = (payload << TAG_BITS) | static_cast<uint64_t>(tag);
+    }
+
+    uint64_t GetPayload() const { return (data & PAYLOAD_MASK) >> TAG_BITS; }
+
+    //! The raw bits, e.g. to write the pointer to a file
+    uint64_t Get() const { return data; }
+    void Set(uint64_t bits) { data = bits; }
+
+      // Swap function
+    static void Swap(IndexPointer& lhs, IndexPointer& rhs) noexcept {
+        std::swap(lhs.data, rhs.data);
+    }
+
+    // ToString function to get string representation of the pointer and tag
+    std::string AddrToString() const {
+        std::ostringstream oss;
+        oss << "Pointer: {" << GetBlockId() << ":" << GetOffset()
+            << ", Tag: " << static_cast<uint64_t>(getTag()) <<"}";
+        return oss.str();
+    }
+};
+}  // namespace duckart
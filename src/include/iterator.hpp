@@ -0,0 +1,127 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "art.hpp"
+#include "artkey.hpp"
+#include "common.hpp"
+#include "node.hpp"
+#include "value.hpp"
+
+namespace duckart {
+
+//! The key bytes of the current position of an iterator, rebuilt from the prefix bytes and
+//! the child bytes on the path from the root to the leaf
+class IteratorKey {
+   public:
+    //! Pushes a byte onto the current key
+    inline void Push(const uint8_t byte) { key_bytes.push_back(byte); }
+    //! Truncates the current key to size bytes
+    inline void Truncate(const idx_t size) { key_bytes.resize(size); }
+    //! Returns the number of bytes of the current key
+    inline idx_t Size() const { return key_bytes.size(); }
+    //! Returns the bytes of the current key
+    inline const uint8_t *Data() const { return key_bytes.data(); }
+
+    inline uint8_t &operator[](idx_t idx) { return key_bytes[idx]; }
+    inline const uint8_t &operator[](idx_t idx) const { return key_bytes[idx]; }
+
+    //! Returns true if the current key is greater than key, or equal to it if equal is set
+    bool GreaterThan(const ARTKey &key, const bool equal) const;
+    //! Returns a copy of the current key
+    ARTKey ToARTKey() const;
+
+   private:
+    std::vector<uint8_t> key_bytes;
+};
+
+//! An entry of the iterator stack, an inner node on the path to the current leaf
+struct IteratorEntry {
+    IteratorEntry(const Node node, const idx_t depth, const uint8_t byte)
+        : node(node), depth(depth), byte(byte) {}
+
+    //! The inner node
+    Node node;
+    //! The key depth of the child byte, i.e., behind the prefix of the node
+    idx_t depth;
+    //! The byte of the child that the iterator descended into
+    uint8_t byte;
+};
+
+//! Walks the leaves of an ART in key order. The iterator does not allocate any nodes and
+//! does not modify the tree, but it is invalidated by any Insert, Delete or Vacuum
+class ART::Iterator {
+   public:
+    explicit Iterator(const ART &art) : art(art) {}
+
+    //! Positions the iterator at the smallest key, returns false if the tree is empty
+    bool First();
+    //! Positions the iterator at the largest key, returns false if the tree is empty
+    bool Last();
+    //! Positions the iterator at the smallest key that is greater than or equal to key,
+    //! returns false if there is no such key
+    bool LowerBound(const ARTKey &key);
+    //! Positions the iterator at the smallest key that is greater than key, returns false
+    //! if there is no such key
+    bool UpperBound(const ARTKey &key);
+    //! Moves the iterator to the next key, returns false if there is no next key
+    bool Next();
+    //! Moves the iterator to the previous key, returns false if there is no previous key
+    bool Prev();
+
+    //! Calls callback for every key in [lo, hi] in key order, until callback returns false.
+    //! Returns the number of visited keys
+    idx_t Scan(const ARTKey &lo, const ARTKey &hi,
+               const std::function<bool(const IteratorKey &, const Value &)> &callback);
+
+    //! Returns true if the iterator is positioned at a key
+    inline bool Valid() const {
+        return leaf.getTag() == NType::LEAF || leaf.IsGate() || (leaf.getTag() == NType::LEAF_INLINED && !leaf.IsCleared());
+    }
+    //! Returns the key at the current position
+    inline const IteratorKey &GetKey() const {
+        D_ASSERT(Valid());
+        return current_key;
+    }
+    //! Returns the value at the current position, which must be a Leaf
+    const Value &GetValue() const;
+    //! Returns the row id at the current position, which must be an inlined leaf
+    idx_t GetRowId() const;
+    //! Calls callback for the row ids at the current position in ascending order, until
+    //! callback returns false. Returns the number of visited row ids, see ART::ScanRowIds
+    idx_t ScanRowIds(const std::function<bool(idx_t)> &callback) const;
+
+   private:
+    //! The tree
+    const ART &art;
+    //! The key of the current leaf
+    IteratorKey current_key;
+    //! The inner nodes on the path from the root to the current leaf
+    std::vector<IteratorEntry> nodes;
+    //! The current Leaf, inlined leaf or row id set, or Node{} if the iterator is not positioned at a key
+    Node leaf;
+
+   private:
+    //! Resets the iterator to an invalid position
+    void Reset();
+    //! Pushes the prefix bytes of node onto the current key, returns the node that ends the
+    //! prefix chain
+    Node PushPrefix(const Node &node);
+    //! Descends from node to the leaf with the smallest key in its subtree
+    bool FindMinimum(Node node);
+    //! Descends from node to the leaf with the largest key in its subtree
+    bool FindMaximum(Node node);
+    //! Moves to the smallest leaf behind the subtree of the current stack top
+    bool NextFromStack();
+    //! Moves to the largest leaf before the subtree of the current stack top
+    bool PrevFromStack();
+    //! Compares the prefix of node with key at depth: negative if all keys of the subtree are
+    //! smaller than key, positive if they are greater, and zero if the prefix matches. In that
+    //! case, depth is advanced past the prefix
+    int ComparePrefix(const Node &node, const ARTKey &key, idx_t &depth) const;
+    //! Shared implementation of LowerBound and UpperBound
+    bool Seek(const ARTKey &key, const bool equal);
+};
+
+}  // namespace duckart
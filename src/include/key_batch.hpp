@@ -0,0 +1,73 @@
+#pragma once
+
+#include <vector>
+
+#include "artkey.hpp"
+#include "common.hpp"
+#include "simd.hpp"
+#include "string_type.hpp"
+
+namespace duckart {
+
+//! The keys of a batch of rows, encoded a column vector at a time into one buffer, the key
+//! arena of the batch. A composite key is the concatenation of the keys of its columns, in
+//! the order in which the columns are added. The keys are views of the buffer, which the
+//! batch reuses for the next batch after Reset:
+//!   ARTKeyBatch batch(count);
+//!   batch.AddColumn<int32_t>(ids);
+//!   batch.AddColumn(names);
+//!   auto &keys = batch.Encode();
+class ARTKeyBatch {
+   public:
+    explicit ARTKeyBatch(idx_t count) : count(count) {}
+
+    ARTKeyBatch(const ARTKeyBatch &) = delete;
+    ARTKeyBatch &operator=(const ARTKeyBatch &) = delete;
+
+    //! Adds a column of count fixed-width values, which must outlive Encode
+    template <class T>
+    void AddColumn(const T *values) {
+        columns.push_back({reinterpret_cast<const_data_ptr_t>(values), sizeof(T), EncodeColumn<T>});
+    }
+    //! Adds a column of count strings, which must outlive Encode
+    void AddColumn(const string_t *values) {
+        columns.push_back({reinterpret_cast<const_data_ptr_t>(values), 0, nullptr});
+    }
+
+    //! Encodes the columns into the keys of the rows
+    const std::vector<ARTKey> &Encode();
+
+    //! Drops the columns and keys, and keeps the buffers for a batch of count rows
+    void Reset(idx_t new_count) {
+        count = new_count;
+        columns.clear();
+        keys.clear();
+    }
+
+    idx_t Size() const { return count; }
+    const ARTKey &operator[](idx_t i) const { return keys[i]; }
+
+   private:
+    struct Column {
+        const_data_ptr_t values;
+        //! The key length of a fixed-width column, 0 for strings
+        uint32_t width;
+        void (*encode)(const_data_ptr_t values, idx_t count, data_ptr_t out, idx_t stride);
+    };
+
+    template <class T>
+    static void EncodeColumn(const_data_ptr_t values, idx_t count, data_ptr_t out, idx_t stride) {
+        EncodeKeyColumn<T>(reinterpret_cast<const T *>(values), count, out, stride);
+    }
+
+    idx_t count;
+    std::vector<Column> columns;
+    std::vector<data_t> buffer;
+    //! The start of the key of each row, and the end of its encoded columns, if the keys
+    //! have different lengths
+    std::vector<idx_t> offsets;
+    std::vector<idx_t> cursors;
+    std::vector<ARTKey> keys;
+};
+
+}  // namespace duckart
@@ -8,8 +8,17 @@
 namespace duckart {
 
 
+//! A leaf is either a Leaf slot, with the key bytes behind its parent in its prefix and a
+//! value, or an inlined leaf, which keeps a row id in the bits of the node pointer. The key
+//! bytes of an inlined leaf are a prefix chain ahead of it: its parent points to that chain,
+//! whose last prefix points to the inlined leaf, or to the inlined leaf itself if the key
+//! ends at the parent. The row ids of a non-unique key are a row id set, a gate at the same
+//! place as an inlined leaf, see row_id_set.cpp
 class Leaf {
    public:
+    //! Largest row id of an inlined leaf
+    static constexpr idx_t MAX_INLINED_ROW_ID = Node::MAX_PAYLOAD - 1;
+
     //! Delete copy constructors, as any Leaf can never own its memory
     Leaf(const Leaf&) = delete;
     Leaf& operator=(const Leaf&) = delete;
@@ -25,6 +34,25 @@ class Leaf {
     static Leaf& New(ART& art, Node& node, const Value& value);
     //! Free the leaf
     static void Free(ART& art, Node& node);
+
+    //! New inlined leaf, which needs no memory slot. Not supported in concurrent trees
+    static void NewInlined(ART& art, Node& node, const idx_t row_id);
+    //! Returns the row id of the inlined leaf
+    static inline idx_t GetRowId(const Node& node) {
+        D_ASSERT(node.getTag() == NType::LEAF_INLINED && !node.IsCleared());
+        return node.GetPayload() - 1;
+    }
+    //! Returns true if the node is an inlined leaf or a row id set, or the prefix chain ahead
+    //! of one
+    static inline bool IsInlined(const Node& node) {
+        return node.getTag() == NType::PREFIX || node.IsGate() ||
+               (node.getTag() == NType::LEAF_INLINED && !node.IsCleared());
+    }
+    //! Returns true if the node is a Leaf slot with a value
+    static inline bool HasValue(const Node& node) { return node.getTag() == NType::LEAF && !node.IsGate(); }
+    //! Returns true if the node is a Leaf slot, an inlined leaf, a row id set, or the prefix
+    //! chain ahead of one
+    static inline bool IsLeaf(const Node& node) { return node.getTag() == NType::LEAF || IsInlined(node); }
 };
 
 
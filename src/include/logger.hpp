@@ -1,12 +1,27 @@
 #pragma once
 
-#include <iostream>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <ctime>
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <string>
-#include <ctime>
-#include <iomanip>
-#include <sstream>
-#include <filesystem>
+#include <thread>
+#include <vector>
+
+//! Lowest level that is compiled in, the LOG_ macros below it expand to nothing.
+//! 0: DEBUG, 1: INFO, 2: WARNING, 3: ERROR, 4: nothing. Release builds drop DEBUG by default
+#ifndef DUCKART_LOG_LEVEL
+#ifdef NDEBUG
+#define DUCKART_LOG_LEVEL 1
+#else
+#define DUCKART_LOG_LEVEL 0
+#endif
+#endif
 
 class Logger {
 public:
@@ -17,19 +32,49 @@ public:
         ERROR
     };
 
-    Logger(const std::string& filename, LogLevel level = INFO) 
-        : m_filename(filename), m_level(level) {
+    //! SYNC writes every line on the calling thread, ASYNC hands the line to a per-thread
+    //! ring buffer that a background thread drains into the file
+    enum LogMode {
+        SYNC,
+        ASYNC
+    };
+
+    Logger(const std::string& filename, LogLevel level = INFO, LogMode mode = SYNC)
+        : m_filename(filename), m_level(level), m_id(NextLoggerId()) {
         m_file.open(filename, std::ios::app);
+        if (mode == ASYNC) {
+            m_writer = std::thread([this]() { WriterLoop(); });
+        }
     }
 
     ~Logger() {
+        if (m_writer.joinable()) {
+            {
+                std::lock_guard<std::mutex> guard(m_wait_mutex);
+                m_stop = true;
+            }
+            m_wait.notify_one();
+            m_writer.join();
+            Drain();
+            // the threads drop their cached rings of this logger on their next miss
+            std::lock_guard<std::mutex> guard(m_rings_mutex);
+            for (auto& ring : m_rings) {
+                ring->closed.store(true, std::memory_order_release);
+            }
+        }
         if (m_file.is_open()) {
             m_file.close();
         }
     }
 
     void setLogLevel(LogLevel level) {
-        m_level = level;
+        m_level.store(level, std::memory_order_relaxed);
+    }
+
+    //! Returns true if messages of level are written, the LOG_ macros check this before
+    //! building the message
+    bool isEnabled(LogLevel level) const {
+        return level >= m_level.load(std::memory_order_relaxed);
     }
 
     void debug(const std::string& message, const char* file, const char* function, int line) {
@@ -48,40 +93,236 @@ public:
         log(ERROR, "ERROR", message, file, function, line);
     }
 
+    //! Blocks until all lines logged so far by the calling thread are written
+    void flush() {
+        if (!m_writer.joinable()) {
+            std::lock_guard<std::mutex> guard(m_file_mutex);
+            m_file.flush();
+            return;
+        }
+        auto ring = GetRing();
+        while (ring->tail.load(std::memory_order_acquire) != ring->head.load(std::memory_order_acquire)) {
+            m_wait.notify_one();
+            std::this_thread::yield();
+        }
+        std::lock_guard<std::mutex> guard(m_file_mutex);
+        m_file.flush();
+    }
+
+    //! Number of rings of an ASYNC logger, at most the number of threads that logged at the
+    //! same time
+    size_t getRingCount() {
+        std::lock_guard<std::mutex> guard(m_rings_mutex);
+        return m_rings.size();
+    }
+
 private:
-    void log(LogLevel messageLevel, const std::string& levelString, const std::string& message, 
+    //! Single producer (the owning thread), single consumer (the writer thread) ring
+    struct LogRing {
+        static constexpr size_t CAPACITY = 1024;
+        std::array<std::string, CAPACITY> lines;
+        //! Next slot the producer writes
+        std::atomic<size_t> head{0};
+        //! Next slot the consumer reads
+        std::atomic<size_t> tail{0};
+        //! Set while a thread produces into the ring
+        std::atomic<bool> owned{true};
+        //! Set once the logger is destroyed
+        std::atomic<bool> closed{false};
+    };
+
+    //! The rings of a thread, by logger id. Hands them back when the thread exits, so that the
+    //! next thread that logs takes them over
+    struct RingCache {
+        std::vector<std::pair<size_t, std::shared_ptr<LogRing>>> rings;
+
+        ~RingCache() {
+            for (auto& entry : rings) {
+                entry.second->owned.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    void log(LogLevel messageLevel, const char* levelString, const std::string& message,
              const char* file, const char* function, int line) {
-        if (messageLevel >= m_level) {
-            std::time_t now = std::time(nullptr);
-            std::tm* localTime = std::localtime(&now);
+        if (!isEnabled(messageLevel)) {
+            return;
+        }
+
+        std::string entry;
+        entry.reserve(64 + message.size());
+        entry += '[';
+        entry += Timestamp();
+        entry += "] [";
+        entry += levelString;
+        entry += "] [";
+        entry += FileName(file);
+        entry += ':';
+        entry += std::to_string(line);
+        entry += ',';
+        entry += function;
+        entry += "()] ";
+        entry += message;
+        entry += '\n';
+
+        if (!m_writer.joinable()) {
+            std::lock_guard<std::mutex> guard(m_file_mutex);
+            m_file << entry;
+            return;
+        }
+
+        auto ring = GetRing();
+        auto head = ring->head.load(std::memory_order_relaxed);
+        // the ring is full, wait for the writer instead of dropping the line
+        while (head - ring->tail.load(std::memory_order_acquire) == LogRing::CAPACITY) {
+            m_wait.notify_one();
+            std::this_thread::yield();
+        }
+        ring->lines[head % LogRing::CAPACITY] = std::move(entry);
+        ring->head.store(head + 1, std::memory_order_release);
+    }
+
+    //! Returns the ring of the calling thread, on first use a ring that an exited thread handed
+    //! back, or a new one
+    LogRing* GetRing() {
+        thread_local RingCache cache;
+        for (auto& entry : cache.rings) {
+            if (entry.first == m_id) {
+                return entry.second.get();
+            }
+        }
+        // a miss, drop the rings of destroyed loggers
+        for (size_t i = 0; i < cache.rings.size();) {
+            if (cache.rings[i].second->closed.load(std::memory_order_acquire)) {
+                cache.rings[i] = std::move(cache.rings.back());
+                cache.rings.pop_back();
+            } else {
+                i++;
+            }
+        }
+        std::shared_ptr<LogRing> ring;
+        {
+            std::lock_guard<std::mutex> guard(m_rings_mutex);
+            for (auto& candidate : m_rings) {
+                auto owned = false;
+                // acquires the head that the previous owner wrote
+                if (candidate->owned.compare_exchange_strong(owned, true, std::memory_order_acquire)) {
+                    ring = candidate;
+                    break;
+                }
+            }
+            if (!ring) {
+                ring = std::make_shared<LogRing>();
+                m_rings.push_back(ring);
+            }
+        }
+        cache.rings.emplace_back(m_id, ring);
+        return ring.get();
+    }
 
-            std::filesystem::path filePath(file);
-            std::string fileName = filePath.filename().string();
+    //! Writes all pending lines of all rings, returns false if there were none
+    bool Drain() {
+        std::vector<LogRing*> rings;
+        {
+            std::lock_guard<std::mutex> guard(m_rings_mutex);
+            for (auto& ring : m_rings) {
+                rings.push_back(ring.get());
+            }
+        }
+
+        bool written = false;
+        std::lock_guard<std::mutex> guard(m_file_mutex);
+        for (auto ring : rings) {
+            auto tail = ring->tail.load(std::memory_order_relaxed);
+            auto head = ring->head.load(std::memory_order_acquire);
+            for (; tail != head; tail++) {
+                auto& line = ring->lines[tail % LogRing::CAPACITY];
+                m_file << line;
+                line.clear();
+            }
+            if (ring->tail.load(std::memory_order_relaxed) != head) {
+                ring->tail.store(head, std::memory_order_release);
+                written = true;
+            }
+        }
+        if (written) {
+            m_file.flush();
+        }
+        return written;
+    }
 
-            std::stringstream ss;
-            ss << "[" << std::put_time(localTime, "%Y-%m-%d %H:%M:%S") << "] "
-               << "[" << levelString << "] "
-               << "[" << fileName << ":" << line << "," << function << "()] "
-               << message;
+    void WriterLoop() {
+        while (true) {
+            if (Drain()) {
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(m_wait_mutex);
+            if (m_stop) {
+                return;
+            }
+            m_wait.wait_for(lock, std::chrono::milliseconds(10));
+        }
+    }
 
-            m_file << ss.str() << std::endl;
+    //! Formats the current time, localtime only runs once per second and thread
+    static const char* Timestamp() {
+        thread_local std::time_t cachedSecond = -1;
+        thread_local char cachedStamp[32];
+        std::time_t now = std::time(nullptr);
+        if (now != cachedSecond) {
+            std::tm localTime;
+#ifdef _WIN32
+            localtime_s(&localTime, &now);
+#else
+            localtime_r(&now, &localTime);
+#endif
+            std::strftime(cachedStamp, sizeof(cachedStamp), "%Y-%m-%d %H:%M:%S", &localTime);
+            cachedSecond = now;
+        }
+        return cachedStamp;
+    }
 
-            // Also print to console
-            //std::cout << ss.str() << std::endl;
+    static const char* FileName(const char* path) {
+        auto slash = std::strrchr(path, '/');
+        auto backslash = std::strrchr(path, '\\');
+        if (backslash > slash) {
+            slash = backslash;
         }
+        return slash ? slash + 1 : path;
+    }
+
+    static size_t NextLoggerId() {
+        static std::atomic<size_t> nextId{1};
+        return nextId.fetch_add(1);
     }
 
     std::string m_filename;
     std::ofstream m_file;
-    LogLevel m_level;
-};
+    std::atomic<LogLevel> m_level;
+    size_t m_id;
 
-extern Logger g_logger;
+    std::mutex m_file_mutex;
+    std::mutex m_rings_mutex;
+    //! Shared with the caches of the threads, which outlive the logger or not
+    std::vector<std::shared_ptr<LogRing>> m_rings;
 
-#define LOG_DEBUG(message) g_logger.debug(message, __FILE__, __FUNCTION__, __LINE__)
-#define LOG_INFO(message) g_logger.info(message, __FILE__, __FUNCTION__, __LINE__)
-#define LOG_WARNING(message) g_logger.warning(message, __FILE__, __FUNCTION__, __LINE__)
-#define LOG_ERROR(message) g_logger.error(message, __FILE__, __FUNCTION__, __LINE__)
+    std::thread m_writer;
+    std::mutex m_wait_mutex;
+    std::condition_variable m_wait;
+    bool m_stop = false;
+};
 
+extern Logger g_logger;
 
+// The message is only built if the level is compiled in and enabled at runtime
+#define DUCKART_LOG(LEVEL, LEVEL_NUMBER, FUNCTION, message)                   \
+    do {                                                                      \
+        if (DUCKART_LOG_LEVEL <= LEVEL_NUMBER && g_logger.isEnabled(LEVEL)) { \
+            g_logger.FUNCTION(message, __FILE__, __FUNCTION__, __LINE__);     \
+        }                                                                     \
+    } while (0)
 
+#define LOG_DEBUG(message) DUCKART_LOG(Logger::DEBUG, 0, debug, message)
+#define LOG_INFO(message) DUCKART_LOG(Logger::INFO, 1, info, message)
+#define LOG_WARNING(message) DUCKART_LOG(Logger::WARNING, 2, warning, message)
+#define LOG_ERROR(message) DUCKART_LOG(Logger::ERROR, 3, error, message)
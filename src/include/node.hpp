@@ -3,23 +3,21 @@
 #include "art.hpp"
 #include "common.hpp"
 #include "fixed_size_allocator.hpp"
-#include "tagged_pointer.hpp"
+#include "index_pointer.hpp"
 #include <iostream>
 
 
 namespace duckart {
 class ART;
 class FixedSizeAllocator; 
+struct InlinePrefix;
  
-class Node : public TaggedPointer<void> {
+class Node : public IndexPointer {
    public:
-    using TaggedPointer<void>::TaggedPointer;
+    using IndexPointer::IndexPointer;
 
-    template <typename T>
-    Node(T *ptr, NType type)
-        : TaggedPointer<void>(static_cast<void *>(ptr), type) {}
-
-    Node() : TaggedPointer<void>(nullptr, NType::NODE_DUMMY) {}
+    Node() : IndexPointer() {}
+    Node(const IndexPointer &ptr) : IndexPointer(ptr) {}
 
     //! Destructor
     ~Node() {
@@ -40,6 +38,9 @@ class Node : public TaggedPointer<void> {
     static void New(ART &art, Node &node, const NType type);
     //! Free the node (and its subtree)
     static void Free(ART &art, Node &node);
+    //! Free the memory slot of the node only. If the tree is concurrent, the slot is retired
+    //! instead, as readers might still read it
+    static void FreeSlot(ART &art, const Node &node);
 
     //! Insert the child node at byte
     static void InsertChild(ART &art, Node &node, const uint8_t byte,
@@ -53,11 +54,26 @@ class Node : public TaggedPointer<void> {
 
     //! Get the child (immutable) for the respective byte in the node
     const Node GetChild(ART &art, const uint8_t byte) const;
+    //! Get the first child whose byte is greater than or equal to byte, and set byte to
+    //! the byte of that child. Returns nullptr if there is no such child
+    Node *GetNextChildMutable(ART &art, uint8_t &byte) const;
+    //! Get the (immutable) first child whose byte is greater than or equal to byte, and
+    //! set byte to the byte of that child. Returns nullptr if there is no such child
+    const Node *GetNextChild(const ART &art, uint8_t &byte) const;
+    //! Get the (immutable) last child whose byte is less than or equal to byte, and set
+    //! byte to the byte of that child. Returns nullptr if there is no such child
+    const Node *GetPrevChild(const ART &art, uint8_t &byte) const;
 
     //！ Get Prefix 
-   const Node GetPrefix(ART& art) const;
+   const Node GetPrefix(const ART& art) const;
    //!  Set Prefix
    void SetPrefix(ART& art,Node& node) const;
+   //! Get the prefix bytes in the header of an inner node, which are empty for other nodes
+   const InlinePrefix &GetInlinePrefix(const ART &art) const;
+   //! Move the prefix bytes in the header of an inner node into a prefix chain (see
+   //! Prefix::Unpack), and back if the chain fits (see Prefix::Pack). No-op for other nodes
+   void UnpackPrefix(ART &art) const;
+   void PackPrefix(ART &art) const;
 
    //! Returns the string representation of the node
    static void Print(ART &art, Node &node);
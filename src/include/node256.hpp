@@ -21,10 +21,14 @@ class Node256 {
     Node256 &operator=(const Node256 &) = delete;
 
 
-    //! prefix
+    //! The prefix chain, if the prefix is too long for inline_prefix
     Node prefix;
+    //! Version and write lock word for optimistic lock coupling, see olc.hpp
+    uint64_t version;
     //! Number of non-null children
     uint16_t count;
+    //! The prefix bytes, if the prefix is short enough, otherwise prefix is the chain
+    InlinePrefix inline_prefix;
     //! Node pointers to the child nodes
     Node children[NODE_256_CAPACITY];
 
@@ -48,7 +52,18 @@ class Node256 {
 	}
 
 	//! Get the (immutable) child for the respective byte in the node
-	const Node GetChild(const uint8_t byte) const;
+	inline const Node GetChild(const uint8_t byte) const {
+		if (!children[byte].IsCleared()) {
+			return children[byte];
+		}
+		return Node{};
+	}
+	//! Get the first child whose byte is greater than or equal to byte
+	Node *GetNextChildMutable(uint8_t &byte);
+	//! Get the (immutable) first child whose byte is greater than or equal to byte
+	const Node *GetNextChild(uint8_t &byte) const;
+	//! Get the (immutable) last child whose byte is less than or equal to byte
+	const Node *GetPrevChild(uint8_t &byte) const;
 
      //! Returns the string representation of the node
 	std::string ToString(ART &art) const;
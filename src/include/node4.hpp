@@ -9,6 +9,7 @@
 #include "node.hpp"
 #include "prefix.hpp"
 #include "logger.hpp"
+#include "simd.hpp"
 
 namespace duckart {
 class Node; 
@@ -20,10 +21,14 @@ class Node4 {
     Node4(const Node4 &) = delete;
     Node4 &operator=(const Node4 &) = delete;
 
-    //!prefix
+    //! The prefix chain, if the prefix is too long for inline_prefix
     Node prefix;
+    //! Version and write lock word for optimistic lock coupling, see olc.hpp
+    uint64_t version;
      //! Number of non-null children
     uint8_t count;
+    //! The prefix bytes, if the prefix is short enough, otherwise prefix is the chain
+    InlinePrefix inline_prefix;
     //! Array containing all partial key bytes
     uint8_t key[NODE_4_CAPACITY];
     //! Node pointers to the child nodes
@@ -47,7 +52,20 @@ class Node4 {
 	void ReplaceChild(const uint8_t byte, const Node child);
 
 	//! Get the (immutable) child for the respective byte in the node
-	const Node GetChild(const uint8_t byte) const;
+	inline const Node GetChild(const uint8_t byte) const {
+		auto pos = FindKeyByte<NODE_4_CAPACITY>(key, count, byte);
+		if (pos != INVALID_INDEX) {
+			D_ASSERT(!children[pos].IsCleared());
+			return children[pos];
+		}
+		return Node{};
+	}
+	//! Get the first child whose byte is greater than or equal to byte
+	Node *GetNextChildMutable(uint8_t &byte);
+	//! Get the (immutable) first child whose byte is greater than or equal to byte
+	const Node *GetNextChild(uint8_t &byte) const;
+	//! Get the (immutable) last child whose byte is less than or equal to byte
+	const Node *GetPrevChild(uint8_t &byte) const;
 
     //! Returns the string representation of the node
     std::string ToString(ART &art) const;
@@ -17,10 +17,14 @@ class Node48 {
     Node48(const Node48 &) = delete;
     Node48 &operator=(const Node48 &) = delete;
  
-    //!prefix
+    //! The prefix chain, if the prefix is too long for inline_prefix
     Node prefix;
+    //! Version and write lock word for optimistic lock coupling, see olc.hpp
+    uint64_t version;
     //! Number of non-null children
     uint8_t count;
+    //! The prefix bytes, if the prefix is short enough, otherwise prefix is the chain
+    InlinePrefix inline_prefix;
     //! Array containing all possible partial key bytes, those not set have an
     //! EMPTY_MARKER
     uint8_t child_index[NODE_256_CAPACITY];
@@ -50,7 +54,19 @@ class Node48 {
 	}
 
 	//! Get the (immutable) child for the respective byte in the node
-	 const Node GetChild(const uint8_t byte) const;
+	inline const Node GetChild(const uint8_t byte) const {
+		if (child_index[byte] != EMPTY_MARKER) {
+			D_ASSERT(!children[child_index[byte]].IsCleared());
+			return children[child_index[byte]];
+		}
+		return Node{};
+	}
+	//! Get the first child whose byte is greater than or equal to byte
+	Node *GetNextChildMutable(uint8_t &byte);
+	//! Get the (immutable) first child whose byte is greater than or equal to byte
+	const Node *GetNextChild(uint8_t &byte) const;
+	//! Get the (immutable) last child whose byte is less than or equal to byte
+	const Node *GetPrevChild(uint8_t &byte) const;
 
       //! Returns the string representation of the node
      std::string ToString(ART &art) const;
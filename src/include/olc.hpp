@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+
+#include "common.hpp"
+
+namespace duckart {
+
+// Optimistic lock coupling, following "The ART of Practical Synchronization" by Leis et al.
+// (https://db.in.tum.de/~leis/papers/artsync.pdf). Every inner node has a version word:
+// bit 0 marks an obsolete (replaced) node, bit 1 is the write lock, and the remaining bits
+// count the modifications. Readers never write the word, they validate that it did not
+// change after reading the node. Writers upgrade their read version to a write lock.
+// All functions set restart if the caller has to restart its operation from the root.
+
+class OptimisticLock {
+   public:
+    static constexpr uint64_t OBSOLETE_BIT = 1;
+    static constexpr uint64_t LOCKED_BIT = 2;
+
+    //! Waits until the word is not locked, and returns its version
+    static inline uint64_t ReadLockOrRestart(uint64_t &word, bool &restart) {
+        std::atomic_ref<uint64_t> version(word);
+        auto v = version.load(std::memory_order_acquire);
+        for (idx_t spins = 0; v & LOCKED_BIT; spins++) {
+            if (spins > 64) {
+                std::this_thread::yield();
+            }
+            v = version.load(std::memory_order_acquire);
+        }
+        if (v & OBSOLETE_BIT) {
+            restart = true;
+        }
+        return v;
+    }
+
+    //! Validates that the word did not change since ReadLockOrRestart returned v
+    static inline void CheckOrRestart(uint64_t &word, const uint64_t v, bool &restart) {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (std::atomic_ref<uint64_t>(word).load(std::memory_order_relaxed) != v) {
+            restart = true;
+        }
+    }
+
+    //! Turns the read version v into a write lock, if the word did not change since
+    static inline void UpgradeToWriteLockOrRestart(uint64_t &word, uint64_t v, bool &restart) {
+        if (!std::atomic_ref<uint64_t>(word).compare_exchange_strong(v, v + LOCKED_BIT,
+                                                                     std::memory_order_acquire)) {
+            restart = true;
+        }
+    }
+
+    static inline void WriteUnlock(uint64_t &word) {
+        std::atomic_ref<uint64_t>(word).fetch_add(LOCKED_BIT, std::memory_order_release);
+    }
+
+    //! Unlocks the word of a node that was replaced, readers of the node restart
+    static inline void WriteUnlockObsolete(uint64_t &word) {
+        std::atomic_ref<uint64_t>(word).fetch_add(LOCKED_BIT + OBSOLETE_BIT, std::memory_order_release);
+    }
+};
+
+}  // namespace duckart
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "common.hpp"
+
+namespace duckart {
+
+//! Runs task(task_idx) for all tasks on thread_count threads, and rethrows the first exception
+inline void ParallelFor(idx_t thread_count, idx_t task_count, const std::function<void(idx_t)>& task) {
+    std::atomic<idx_t> next_task(0);
+    std::exception_ptr error;
+    std::mutex error_lock;
+
+    auto worker = [&]() {
+        for (auto task_idx = next_task++; task_idx < task_count; task_idx = next_task++) {
+            try {
+                task(task_idx);
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(error_lock);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                next_task = task_count;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (idx_t i = 1; i < MinValue(thread_count, task_count); i++) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+}  // namespace duckart
@@ -11,26 +11,51 @@ namespace duckart {
 // classes
 class ARTKey;
 
-//! The Prefix is a special node type that contains up to PREFIX_SIZE bytes, and one byte for the count,
-//! and a Node pointer. This pointer either points to a prefix node .
+//! The prefix of an inner node, if it is at most INLINE_PREFIX_SIZE bytes long. The node holds
+//! such a prefix in its header instead of in a chain of Prefix nodes, which saves a dependent
+//! cache miss per node on every traversal. Longer prefixes stay in the chain, so an inner node
+//! has either inline bytes or a prefix chain, never both
+struct InlinePrefix {
+	//! Number of prefix bytes in data, 0 if the node has no prefix or a prefix chain
+	uint8_t count;
+	uint8_t data[INLINE_PREFIX_SIZE];
+};
+
+//! The Prefix is a special node type that contains a segment of prefix bytes, their count,
+//! and a Node pointer to the next prefix node, or to the node behind the chain. Segments come
+//! in PREFIX_SEGMENT_CLASSES size classes with an allocator each: the smallest is this struct
+//! with PREFIX_SIZE bytes, the larger ones extend data to the end of their slot, so that the
+//! suffix of a long key takes one segment instead of a chain of small nodes
 class Prefix {
 public:
 	//! Delete copy constructors, as any Prefix can never own its memory
 	Prefix(const Prefix &) = delete;
 	Prefix &operator=(const Prefix &) = delete;
 
-	//! Up to PREFIX_SIZE bytes of prefix data and the count
-	uint8_t data[PREFIX_SIZE + 1];
 	//! A pointer to the next Node
 	Node ptr;
+	//! Number of prefix bytes in data
+	uint8_t count;
+	//! Index of the slot size in PREFIX_SEGMENT_SIZES
+	uint8_t size_class;
+	//! Up to Capacity() bytes of prefix data
+	uint8_t data[PREFIX_SIZE];
+
+	//! Number of prefix bytes a segment of the size class holds
+	static constexpr idx_t Capacity(uint8_t size_class);
+	idx_t Capacity() const { return Capacity(size_class); }
 
 public:
 	//! Get a new empty prefix node, might cause a new buffer allocation
 	static Prefix &New(ART &art, Node &node);
+	//! Get a new empty prefix segment of the smallest size class that holds count bytes, or
+	//! of the largest one
+	static Prefix &NewSegment(ART &art, Node &node, idx_t count);
 	//! Create a new prefix node containing a single byte and a pointer to a next node
 	static Prefix &New(ART &art, Node &node, uint8_t byte, const Node &next = Node());
-	//! Get a new chain of prefix nodes, might cause new buffer allocations,
-	//! with the node parameter holding the tail of the chain
+	//! Get a new chain of prefix nodes, might cause new buffer allocations, with the node
+	//! parameter holding the tail of the chain. Every segment is as large as the remaining
+	//! bytes need, so only prefixes longer than the largest segment take more than one
 	static void New(ART &art, reference<Node> &node, const ARTKey &key, const uint32_t depth, uint32_t count);
 	//! Free the node (and its subtree)
 	static void Free(ART &art, Node &node); 
@@ -39,13 +64,17 @@ public:
 	// Returns the string representation of the Prefix chain
     static std::string ToString(const ART &art, const Node &node);
     // check if two chains of Prefix match
-   static bool Match(ART &art, reference<Node> node1, reference<Node> node2);
+   static bool Match(const ART &art, reference<const Node> node1, reference<const Node> node2);
    	//! Returns the byte at position
 	static uint8_t GetByte(const ART &art, const Node &prefix_node, const idx_t position) ;
 	//! Splits the prefix at position. prefix_node then references the ptr (if any bytes left before
 	//! the split), or stays unchanged (no bytes left before the split). child_node references
 	//! the node after the split, which is either a new prefix node, or ptr
 	static void Split(ART &art, reference<Node> &prefix_node, Node &child_node, idx_t position);
+	//! Removes the first count bytes of the chain in place and frees the prefix nodes that
+	//! become empty. prefix_node then references the first node with bytes left, or the node
+	//! behind the chain
+	static void Trim(ART &art, Node &prefix_node, idx_t count);
 	//! Removes the first n bytes from the prefix and shifts all subsequent bytes in the
 	//! prefix node(s) by n. Frees empty prefix nodes
 	static void Reduce(ART &art, Node &prefix_node, const idx_t n);
@@ -56,9 +85,30 @@ public:
     //! Traverse a prefix and a key until (1) encountering a non-prefix node, or (2) encountering
 	//! a mismatching byte, in which case depth indexes the mismatching byte in the key
 	static idx_t TraverseMutable(ART &art, reference<Node> &prefix_node, const ARTKey &key, idx_t &depth);
+	//! Like TraverseMutable, for lookups that only read the prefix chain
+	static idx_t Traverse(const ART &art, reference<const Node> &prefix_node, const ARTKey &key, idx_t &depth);
 	//! differ two Prefixe Nodes to find (1) that they match (so far), or (2) that they have a mismatching position,
 	//! if match return true ,otherwise return false
 	static bool Mismatch(ART &art, reference<Node> &l_node, reference<Node> &r_node, idx_t &mismatch_position);
+
+	//! Sets the (empty) prefix of an inner node to the count key bytes at depth, in its
+	//! header if they fit, otherwise in a new prefix chain
+	static void New(ART &art, InlinePrefix &inlined, Node &node, const ARTKey &key, const uint32_t depth,
+	                uint32_t count);
+	//! Moves the prefix chain of an inner node into its header, if it is short enough
+	static void Pack(ART &art, InlinePrefix &inlined, Node &node);
+	//! Moves the inline prefix of an inner node into a new prefix node, so that the chain
+	//! operations above apply to it. Pack moves it back
+	static void Unpack(ART &art, InlinePrefix &inlined, Node &node);
+	//! Traverse an inline prefix and a key until encountering a mismatching byte. Returns its
+	//! position in the prefix, in which case depth indexes it in the key, or INVALID_INDEX
+	static idx_t Traverse(const InlinePrefix &inlined, const ARTKey &key, idx_t &depth);
+	//! Splits the inline prefix at position: head receives the bytes before position, and
+	//! inlined keeps the bytes behind it
+	static void Split(InlinePrefix &inlined, InlinePrefix &head, idx_t position);
+	//! Returns the string representation of the prefix of an inner node
+	static std::string ToString(const ART &art, const InlinePrefix &inlined, const Node &node);
+
    public:
 	//! Appends the byte to this prefix node, or creates a subsequent prefix node,
 	//! if this node is full
@@ -67,4 +117,11 @@ public:
 	//! Also frees all copied/appended nodes
 	void Append(ART &art, Node other_prefix);
 };
+
+static_assert(sizeof(Prefix) == PREFIX_SEGMENT_SIZES[0], "the smallest prefix segment is a Prefix");
+
+constexpr idx_t Prefix::Capacity(uint8_t size_class) {
+	return PREFIX_SEGMENT_SIZES[size_class] - (sizeof(Prefix) - PREFIX_SIZE);
+}
+static_assert(Prefix::Capacity(PREFIX_SEGMENT_CLASSES - 1) <= UINT8_MAX, "the count of a segment is a byte");
 }
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <type_traits>
+
+#include "common.hpp"
+#include "radix.hpp"
+
+// SSE2 is part of every x86-64 target, other targets use the scalar fallback
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define DUCKART_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace duckart {
+
+// Key byte search for the sorted key arrays of Node4 and Node16, following the
+// compare + movemask lookup of the ART paper (https://db.in.tum.de/~leis/papers/ART.pdf)
+
+#ifdef DUCKART_SSE2
+template <idx_t CAPACITY>
+static inline __m128i LoadKeyBytes(const uint8_t *keys) {
+    static_assert(CAPACITY == 4 || CAPACITY == 16, "Key byte search supports Node4 and Node16");
+    if (CAPACITY == 4) {
+        return _mm_cvtsi32_si128(Load<int32_t>(keys));
+    }
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(keys));
+}
+#endif
+
+//! Returns the position of byte in the first count keys, or INVALID_INDEX
+template <idx_t CAPACITY>
+static inline idx_t FindKeyByte(const uint8_t *keys, const uint8_t count, const uint8_t byte) {
+#ifdef DUCKART_SSE2
+    auto cmp = _mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(byte)), LoadKeyBytes<CAPACITY>(keys));
+    auto mask = static_cast<uint32_t>(_mm_movemask_epi8(cmp)) & ((uint32_t(1) << count) - 1);
+    return mask ? static_cast<idx_t>(__builtin_ctz(mask)) : INVALID_INDEX;
+#else
+    for (idx_t i = 0; i < count; i++) {
+        if (keys[i] == byte) {
+            return i;
+        }
+    }
+    return INVALID_INDEX;
+#endif
+}
+
+//! Returns the number of keys among the (sorted) first count keys that are smaller than
+//! byte, which is the position at which byte is inserted
+template <idx_t CAPACITY>
+static inline idx_t LowerBoundKeyByte(const uint8_t *keys, const uint8_t count, const uint8_t byte) {
+#ifdef DUCKART_SSE2
+    // SSE2 only compares signed bytes, flipping the sign bit keeps the unsigned order
+    auto sign = _mm_set1_epi8(static_cast<char>(0x80));
+    auto lhs = _mm_xor_si128(LoadKeyBytes<CAPACITY>(keys), sign);
+    auto rhs = _mm_xor_si128(_mm_set1_epi8(static_cast<char>(byte)), sign);
+    auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmplt_epi8(lhs, rhs))) & ((uint32_t(1) << count) - 1);
+    return static_cast<idx_t>(__builtin_popcount(mask));
+#else
+    idx_t pos = 0;
+    while (pos < count && keys[pos] < byte) {
+        pos++;
+    }
+    return pos;
+#endif
+}
+
+//! Returns the position of the first of count bytes in which lhs and rhs differ, or count
+//! if they are equal. Prefix segments hold up to a few hundred bytes, which this compares 16
+//! bytes at a time
+static inline idx_t FindMismatch(const uint8_t *lhs, const uint8_t *rhs, const idx_t count) {
+    idx_t pos = 0;
+#ifdef DUCKART_SSE2
+    for (; pos + 16 <= count; pos += 16) {
+        auto l = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lhs + pos));
+        auto r = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rhs + pos));
+        auto mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(l, r)));
+        if (mask != 0xFFFF) {
+            return pos + static_cast<idx_t>(__builtin_ctz(~mask));
+        }
+    }
+#endif
+    for (; pos < count; pos++) {
+        if (lhs[pos] != rhs[pos]) {
+            return pos;
+        }
+    }
+    return count;
+}
+
+// Key encoding of column vectors (see ARTKeyBatch): the big-endian byte order and the
+// flipped sign bit of Radix::EncodeData, for 4 (32-bit) or 2 (64-bit) values at a time
+
+#ifdef DUCKART_SSE2
+//! Reverses the bytes of every 32-bit lane, SSE2 lacks a byte shuffle
+static inline __m128i BSwapLanes32(__m128i v) {
+    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xB1), 0xB1);
+}
+
+//! Reverses the bytes of every 64-bit lane
+static inline __m128i BSwapLanes64(__m128i v) {
+    v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0x1B), 0x1B);
+}
+#endif
+
+//! Encodes count values into keys of sizeof(T) bytes, which start stride bytes apart at out
+template <class T>
+static inline void EncodeKeyColumn(const T *values, const idx_t count, data_ptr_t out, const idx_t stride) {
+    idx_t i = 0;
+#ifdef DUCKART_SSE2
+    if constexpr (sizeof(T) == 4 || sizeof(T) == 8) {
+        constexpr idx_t LANES = 16 / sizeof(T);
+        // flipping the most significant bit ahead of the swap flips the first key byte
+        const auto sign = !std::is_signed<T>::value ? _mm_setzero_si128()
+                          : sizeof(T) == 4           ? _mm_set1_epi32(INT32_MIN)
+                                                     : _mm_set1_epi64x(INT64_MIN);
+        for (; i + LANES <= count; i += LANES) {
+            auto v = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(values + i)), sign);
+            v = sizeof(T) == 4 ? BSwapLanes32(v) : BSwapLanes64(v);
+            auto dst = out + i * stride;
+            if (stride == sizeof(T)) {
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), v);
+            } else if (sizeof(T) == 4) {
+                // the keys of composite keys are apart
+                Store<int32_t>(_mm_cvtsi128_si32(v), dst);
+                Store<int32_t>(_mm_cvtsi128_si32(_mm_srli_si128(v, 4)), dst + stride);
+                Store<int32_t>(_mm_cvtsi128_si32(_mm_srli_si128(v, 8)), dst + 2 * stride);
+                Store<int32_t>(_mm_cvtsi128_si32(_mm_srli_si128(v, 12)), dst + 3 * stride);
+            } else {
+                _mm_storel_epi64(reinterpret_cast<__m128i *>(dst), v);
+                _mm_storel_epi64(reinterpret_cast<__m128i *>(dst + stride), _mm_unpackhi_epi64(v, v));
+            }
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        Radix::EncodeData<T>(out + i * stride, values[i]);
+    }
+}
+
+}  // namespace duckart
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common.hpp"
+
+namespace duckart {
+
+class BlockDirectory;
+
+//! A snapshot file (see snapshot.cpp) mapped read-only into memory, whose blocks are registered
+//! in a block directory under the ids they were written with, so that the pointers of a tree
+//! resolve into the mapped pages (see ART::Map). Unregisters the blocks and unmaps the file
+//! when it is destroyed
+class SnapshotMapping {
+   public:
+    //! Maps the snapshot at path. If populate is set, the whole file is read ahead, otherwise
+    //! every page is read on its first access
+    SnapshotMapping(const std::string &path, std::shared_ptr<BlockDirectory> directory,
+                    const std::vector<std::pair<idx_t, idx_t>> &layouts, bool populate);
+    ~SnapshotMapping();
+
+    SnapshotMapping(const SnapshotMapping &) = delete;
+    SnapshotMapping &operator=(const SnapshotMapping &) = delete;
+
+    //! The bits of the root pointer of the tree in the snapshot
+    uint64_t GetRoot() const { return root; }
+    //! Size of the file in bytes
+    idx_t GetSize() const { return size; }
+
+   private:
+    std::shared_ptr<BlockDirectory> directory;
+    std::vector<idx_t> block_ids;
+    void *data = nullptr;
+    idx_t size = 0;
+    uint64_t root = 0;
+
+    //! Unregisters the blocks and unmaps the file
+    void Release();
+};
+
+//! Where the pages of a block are in a checkpoint file
+struct CheckpointBlock {
+    //! Index of the allocator of the block, in the order of the snapshot allocators
+    idx_t allocator = 0;
+    //! The offset of every page of the block, in units of the alignment of the file, followed by
+    //! the pages of the bytes of the values of a leaf block that are larger than the slabs
+    std::vector<idx_t> pages;
+};
+
+//! What a tree knows about the checkpoint file that it writes to (see ART::Checkpoint): the
+//! pages that the latest root record references, and the space that no durable root record
+//! references any more, into which the next checkpoint writes
+struct CheckpointState {
+    std::string path;
+    //! The pages of every block of the latest checkpoint, by block id
+    std::map<idx_t, CheckpointBlock> blocks;
+    //! Offset and size of the root records that the latest root record chains to, from the
+    //! last full record on
+    std::vector<std::pair<idx_t, idx_t>> records;
+    //! Number of block entries in those records
+    idx_t record_entries = 0;
+    //! Free space as (size, offset) pairs, and the same ranges by offset
+    std::set<std::pair<idx_t, idx_t>> free_space;
+    std::map<idx_t, idx_t> free_ranges;
+    idx_t file_size = 0;
+    uint64_t sequence = 0;
+
+    //! Returns the offset of size free bytes, from the smallest free range that holds them, or
+    //! from the end of the file
+    idx_t Allocate(idx_t size);
+    //! Adds the range to the free space, merged with the free ranges next to it
+    void Free(idx_t offset, idx_t size);
+};
+
+}  // namespace duckart
@@ -10,34 +10,61 @@
 
 namespace duckart {
 
+//! A value of up to INLINE_SIZE bytes is stored inline, like a string_t. Larger values
+//! point to their bytes, which either the value owns (new[]), or a ValueArena (values in
+//! leaves, see ValueArena::Assign). Values never point into themselves, so a leaf slot can
+//! be moved with memcpy. The values of a mapped snapshot (see ART::Map) hold the distance from
+//! themselves to their bytes instead, which is the same in the file and in the mapping
 class Value {
    public:
-    Value() : len(0), data(nullptr) {}
-    Value(const data_ptr_t &data, const uint32_t &len)
-        : len(len), data(new data_t[len]) {
-        std::memcpy(this->data, data, len);
+    static constexpr uint32_t INLINE_SIZE = 12;
+    //! Owners of the bytes of a value that is not inlined, see value.pointer.arena
+    static constexpr uint32_t OWNED = 0;
+    static constexpr uint32_t ARENA = 1;
+    static constexpr uint32_t MAPPED = 2;
+
+    Value() { value.inlined.length = 0; }
+    Value(const data_ptr_t &data, const uint32_t &len) : Value(len) {
+        std::memcpy(GetData(), data, len);
+    }
+    //! A value of len uninitialized bytes
+    Value(const uint32_t &len) {
+        value.inlined.length = len;
+        if (!IsInlined()) {
+            value.pointer.arena = 0;
+            value.pointer.ptr = new data_t[len];
+        }
+    }
+    ~Value() {
+        if (!IsInlined() && !value.pointer.arena) {
+            delete[] value.pointer.ptr;
+        }
     }
-    Value(const uint32_t &len) : len(len), data(new data_t[len]) {}
-    ~Value() { delete[] data; }
 
-    // Copy constructor
-    Value(const Value &other) : len(other.len), data(new data_t[other.len]) {
-        std::memcpy(data, other.data, len);
+    // Copy constructor, the copy always owns its bytes
+    Value(const Value &other) : Value(other.GetSize()) {
+        std::memcpy(GetData(), other.GetData(), GetSize());
     }
 
     // Move constructor
-    Value(Value &&other) noexcept : len(other.len), data(other.data) {
-        other.data = nullptr;
-        other.len = 0;
+    Value(Value &&other) noexcept {
+        if (other.IsInlined() || !other.value.pointer.arena) {
+            std::memcpy(&value, &other.value, sizeof(value));
+            other.value.inlined.length = 0;
+        } else {
+            new (this) Value(static_cast<const Value &>(other));
+        }
     }
 
-    // Copy assignment operator
+    // Copy assignment operator, reuses the bytes of this value if they have the same size
     Value &operator=(const Value &other) {
         if (this != &other) {
-            delete[] data;
-            len = other.len;
-            data = new data_t[len];
-            std::memcpy(data, other.data, len);
+            D_ASSERT(IsInlined() || !value.pointer.arena);
+            if (GetSize() != other.GetSize()) {
+                this->~Value();
+                new (this) Value(other.GetSize());
+            }
+            std::memcpy(GetData(), other.GetData(), GetSize());
         }
         return *this;
     }
@@ -45,58 +72,79 @@ class Value {
     // Move assignment operator
     Value &operator=(Value &&other) noexcept {
         if (this != &other) {
-            delete[] data;
-            len = other.len;
-            data = other.data;
-            other.data = nullptr;
-            other.len = 0;
+            D_ASSERT(IsInlined() || !value.pointer.arena);
+            this->~Value();
+            new (this) Value(std::move(other));
         }
         return *this;
     }
 
-    uint32_t len;
-    data_ptr_t data;
+    bool IsInlined() const { return value.inlined.length <= INLINE_SIZE; }
+    uint32_t GetSize() const { return value.inlined.length; }
+    data_ptr_t GetData() { return IsInlined() ? value.inlined.inlined : GetPointer(); }
+    const_data_ptr_t GetData() const { return IsInlined() ? value.inlined.inlined : GetPointer(); }
 
    public:
     template <class T>
     static inline Value CreateValue(T element) {
-        auto data = Value::CreateData<T>(element);
-        return Value(data, sizeof(element));
+        Value value(sizeof(element));
+        Radix::EncodeData<T>(value.GetData(), element);
+        return value;
     }
 
     template <class T>
     static inline void CreateValue(Value &val, T element) {
-        val.data = Value::CreateData<T>(element);
-        val.len = sizeof(element);
+        val = CreateValue<T>(element);
     }
 
     template <class T>
     static inline T ExtractValue(Value &val) {
-        auto result = Value::ExtractData<T>(val.data);
+        auto result = Value::ExtractData<T>(val.GetData());
         return result;
     }
 
 	void Print() const {
-        std::cout << "Value: length = " << len << ", data = ";
-        for (uint32_t i = 0; i < len; ++i) {
-            std::cout << std::setw(2) << std::setfill('0') << std::hex << static_cast<int>(data[i]) << " ";
+        std::cout << "Value: length = " << GetSize() << ", data = ";
+        for (uint32_t i = 0; i < GetSize(); ++i) {
+            std::cout << std::setw(2) << std::setfill('0') << std::hex << static_cast<int>(GetData()[i]) << " ";
         }
         std::cout << std::dec << std::endl;
     }
 
    public:
-    data_t &operator[](size_t i) { return data[i]; }
-    const data_t &operator[](size_t i) const { return data[i]; }
+    data_t &operator[](size_t i) { return GetData()[i]; }
+    const data_t &operator[](size_t i) const { return GetData()[i]; }
     bool operator>(const Value &k) const;
     bool operator>=(const Value &k) const;
     bool operator==(const Value &k) const;
-    
+
    private:
-    template <class T>
-    static inline data_ptr_t CreateData(T value) {
-        auto data = new data_t[sizeof(value)];
-        Radix::EncodeData<T>(data, value);
-        return data;
+    friend class ValueArena;
+
+    union {
+        struct {
+            uint32_t length;
+            //! OWNED, ARENA if a ValueArena owns the bytes, or MAPPED
+            uint32_t arena;
+            data_ptr_t ptr;
+        } pointer;
+        struct {
+            uint32_t length;
+            uint32_t arena;
+            //! Distance in bytes from the value to its bytes
+            int64_t distance;
+        } mapped;
+        struct {
+            uint32_t length;
+            data_t inlined[INLINE_SIZE];
+        } inlined;
+    } value;
+
+    data_ptr_t GetPointer() const {
+        if (value.pointer.arena == MAPPED) {
+            return const_cast<data_ptr_t>(reinterpret_cast<const_data_ptr_t>(this)) + value.mapped.distance;
+        }
+        return value.pointer.ptr;
     }
 
     template <class T>
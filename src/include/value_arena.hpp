@@ -0,0 +1,192 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "common.hpp"
+#include "fixed_size_allocator.hpp"
+#include "value.hpp"
+
+namespace duckart {
+
+//! Holds the bytes of the leaf values that do not fit inline into their Value, in slabs of
+//! one FixedSizeAllocator per power of two size class. Values larger than the largest size
+//! class own their bytes, like free-standing values
+class ValueArena {
+   public:
+    static constexpr uint32_t MIN_CLASS_SIZE = 16;
+    static constexpr uint32_t MAX_CLASS_SIZE = 4096;
+    //! Size of the slab blocks, at least 16 slots per block
+    static constexpr idx_t SLAB_SIZE = 64 * 1024;
+
+    //! The slabs register in directory, see FixedSizeAllocator
+    explicit ValueArena(std::shared_ptr<BlockDirectory> directory = nullptr) {
+        static_assert(MIN_CLASS_SIZE > Value::INLINE_SIZE, "The smallest size class holds non-inlined values");
+        if (!directory) {
+            directory = std::make_shared<BlockDirectory>();
+        }
+        for (auto size = MIN_CLASS_SIZE; size <= MAX_CLASS_SIZE; size *= 2) {
+            classes.push_back(
+                std::make_unique<FixedSizeAllocator>(size, MaxValue<idx_t>(16, SLAB_SIZE / size), directory));
+        }
+    }
+
+    ValueArena(const ValueArena &) = delete;
+    ValueArena &operator=(const ValueArena &) = delete;
+
+    //! Copies source into target, which is inlined or owned by this arena. The bytes of
+    //! target are reused if source falls into the same size class, so updating a value of
+    //! the same size never allocates
+    void Assign(Value &target, const Value &source) {
+        auto size = source.GetSize();
+        if (size <= Value::INLINE_SIZE) {
+            Release(target);
+            target.value.inlined.length = size;
+            std::memcpy(target.value.inlined.inlined, source.GetData(), size);
+            return;
+        }
+        if (!target.IsInlined()) {
+            auto size_class = GetClass(target.GetSize());
+            if (size_class == GetClass(size) && (size_class != INVALID_INDEX || target.GetSize() == size)) {
+                target.value.pointer.length = size;
+                std::memcpy(target.value.pointer.ptr, source.GetData(), size);
+                MarkDirty(target);
+                return;
+            }
+            Release(target);
+        }
+
+        auto size_class = GetClass(size);
+        target.value.pointer.length = size;
+        if (size_class == INVALID_INDEX) {
+            target.value.pointer.arena = Value::OWNED;
+            target.value.pointer.ptr = new data_t[size];
+        } else {
+            target.value.pointer.arena = Value::ARENA;
+            target.value.pointer.ptr = static_cast<data_ptr_t>(classes[size_class]->New());
+        }
+        std::memcpy(target.value.pointer.ptr, source.GetData(), size);
+    }
+
+    //! Resizes target, which is inlined or owned by this arena, keeping its first bytes. The
+    //! bytes stay in place if size falls into the same size class
+    void Resize(Value &target, const uint32_t size) {
+        if (!target.IsInlined() && size > Value::INLINE_SIZE) {
+            auto size_class = GetClass(size);
+            if (size_class != INVALID_INDEX && size_class == GetClass(target.GetSize())) {
+                // the caller writes the bytes in place
+                target.value.pointer.length = size;
+                MarkDirty(target);
+                return;
+            }
+        }
+        Value resized(size);
+        std::memcpy(resized.GetData(), target.GetData(), MinValue(size, target.GetSize()));
+        Assign(target, resized);
+    }
+
+    //! Marks the slab block of the bytes of value as dirty (see ART::Checkpoint), once they are
+    //! modified in place. The bytes of values larger than the slabs belong to the leaf, whose
+    //! block the caller marks
+    void MarkDirty(const Value &value) const {
+        if (!value.IsInlined() && value.value.pointer.arena == Value::ARENA) {
+            classes[GetClass(value.GetSize())]->MarkDirty(value.value.pointer.ptr);
+        }
+    }
+
+    //! Frees the bytes of target, which is inlined or owned by this arena, and empties it
+    void Release(Value &target) {
+        if (!target.IsInlined()) {
+            D_ASSERT(target.value.pointer.arena != Value::MAPPED);
+            if (target.value.pointer.arena == Value::ARENA) {
+                classes[GetClass(target.GetSize())]->Free(target.value.pointer.ptr);
+            } else {
+                delete[] target.value.pointer.ptr;
+            }
+        }
+        target.value.inlined.length = 0;
+    }
+
+    //! See FixedSizeAllocator::SetConcurrent and SetThreadCache
+    void SetConcurrent(bool concurrent) {
+        for (auto &allocator : classes) {
+            allocator->SetConcurrent(concurrent);
+            allocator->SetThreadCache(concurrent);
+        }
+    }
+
+    //! Takes over the slabs of other, see FixedSizeAllocator::Adopt
+    void Adopt(ValueArena &other) {
+        for (idx_t i = 0; i < classes.size(); i++) {
+            classes[i]->Adopt(*other.classes[i]);
+        }
+    }
+
+    //! The allocators of the size classes, e.g., to write their slabs to a snapshot
+    const std::vector<std::unique_ptr<FixedSizeAllocator>> &GetAllocators() const { return classes; }
+
+    //! Returns the slab slot of the bytes of value, which is not inlined and owned by this
+    //! arena, e.g., to find their place in a snapshot (see ART::Serialize)
+    IndexPointer GetSlot(const Value &value) const {
+        D_ASSERT(!value.IsInlined() && value.value.pointer.arena == Value::ARENA);
+        return classes[GetClass(value.GetSize())]->ToPointer(value.value.pointer.ptr, NType::LEAF);
+    }
+    //! Returns true if value is not inlined and owns its bytes
+    static bool IsOwned(const Value &value) {
+        return !value.IsInlined() && value.value.pointer.arena == Value::OWNED;
+    }
+    //! Turns value, the copy of a leaf value that is not inlined, into a MAPPED value whose bytes
+    //! are distance bytes away from it
+    static void SetMapped(Value &value, int64_t distance) {
+        D_ASSERT(!value.IsInlined());
+        value.value.mapped.arena = Value::MAPPED;
+        value.value.mapped.distance = distance;
+    }
+    static int64_t GetDistance(const Value &value) {
+        D_ASSERT(!value.IsInlined() && value.value.mapped.arena == Value::MAPPED);
+        return value.value.mapped.distance;
+    }
+    //! Points value, a MAPPED value that was read back into memory, to bytes in the slabs of this
+    //! arena (ARENA), or to bytes that it owns from then on, allocated with new[] (OWNED)
+    static void SetBytes(Value &value, data_ptr_t bytes, uint32_t arena) {
+        D_ASSERT(!value.IsInlined() && arena != Value::MAPPED);
+        value.value.pointer.arena = arena;
+        value.value.pointer.ptr = bytes;
+    }
+
+    //! Replaces the address of the bytes of value, the copy of a leaf value that is not inlined,
+    //! with their location in a checkpoint, see ART::Checkpoint
+    static void SetLocation(Value &value, uint64_t location) {
+        D_ASSERT(!value.IsInlined() && value.value.pointer.arena != Value::MAPPED);
+        value.value.pointer.ptr = reinterpret_cast<data_ptr_t>(location);
+    }
+    static uint64_t GetLocation(const Value &value) {
+        D_ASSERT(!value.IsInlined());
+        return reinterpret_cast<uint64_t>(value.value.pointer.ptr);
+    }
+
+    //! Number of bytes in the slabs that hold values
+    idx_t GetUsedBytes() const {
+        idx_t bytes = 0;
+        for (idx_t i = 0; i < classes.size(); i++) {
+            bytes += classes[i]->GetUsed() * (MIN_CLASS_SIZE << i);
+        }
+        return bytes;
+    }
+
+   private:
+    //! One allocator per size class, from MIN_CLASS_SIZE to MAX_CLASS_SIZE bytes
+    std::vector<std::unique_ptr<FixedSizeAllocator>> classes;
+
+    //! Returns the size class of a non-inlined value, or INVALID_INDEX if it is too large
+    static idx_t GetClass(const uint32_t size) {
+        D_ASSERT(size > Value::INLINE_SIZE);
+        if (size > MAX_CLASS_SIZE) {
+            return INVALID_INDEX;
+        }
+        auto bits = 32 - __builtin_clz(MaxValue(size, MIN_CLASS_SIZE) - 1);
+        return bits - 4;
+    }
+};
+
+}  // namespace duckart
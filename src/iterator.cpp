@@ -0,0 +1,277 @@
+#include "iterator.hpp"
+
+#include "exception.hpp"
+#include "leaf.hpp"
+#include "prefix.hpp"
+
+namespace duckart {
+
+//===--------------------------------------------------------------------===//
+// IteratorKey
+//===--------------------------------------------------------------------===//
+bool IteratorKey::GreaterThan(const ARTKey& key, const bool equal) const {
+    auto min_len = MinValue<idx_t>(Size(), key.len);
+    auto result = std::memcmp(key_bytes.data(), key.data, min_len);
+    if (result != 0) {
+        return result > 0;
+    }
+    if (Size() != key.len) {
+        return Size() > key.len;
+    }
+    return equal;
+}
+
+ARTKey IteratorKey::ToARTKey() const {
+    ARTKey key(static_cast<uint32_t>(Size()));
+    std::memcpy(key.data, key_bytes.data(), Size());
+    return key;
+}
+
+//===--------------------------------------------------------------------===//
+// Iterator
+//===--------------------------------------------------------------------===//
+bool ART::Iterator::First() {
+    Reset();
+    return FindMinimum(*art.root);
+}
+
+bool ART::Iterator::Last() {
+    Reset();
+    return FindMaximum(*art.root);
+}
+
+bool ART::Iterator::LowerBound(const ARTKey& key) { return Seek(key, true); }
+
+bool ART::Iterator::UpperBound(const ARTKey& key) { return Seek(key, false); }
+
+bool ART::Iterator::Next() {
+    if (!Valid()) {
+        return false;
+    }
+    leaf = Node{};
+    return NextFromStack();
+}
+
+bool ART::Iterator::Prev() {
+    if (!Valid()) {
+        return false;
+    }
+    leaf = Node{};
+    return PrevFromStack();
+}
+
+idx_t ART::Iterator::Scan(const ARTKey& lo, const ARTKey& hi,
+                          const std::function<bool(const IteratorKey&, const Value&)>& callback) {
+    idx_t count = 0;
+    if (!LowerBound(lo)) {
+        return count;
+    }
+    while (Valid() && !current_key.GreaterThan(hi, false)) {
+        count++;
+        if (!callback(current_key, GetValue())) {
+            break;
+        }
+        Next();
+    }
+    return count;
+}
+
+const Value& ART::Iterator::GetValue() const {
+    D_ASSERT(Valid());
+    if (!Leaf::HasValue(leaf)) {
+        throw InternalException("An inlined leaf or a row id set has no value, see GetRowId.");
+    }
+    return art.GetAllocator(NType::LEAF).Get<const Leaf>(leaf)->value;
+}
+
+idx_t ART::Iterator::GetRowId() const {
+    D_ASSERT(Valid());
+    if (leaf.getTag() != NType::LEAF_INLINED || leaf.IsGate()) {
+        throw InternalException("Only an inlined leaf has a single row id, see GetValue and ScanRowIds.");
+    }
+    return Leaf::GetRowId(leaf);
+}
+
+void ART::Iterator::Reset() {
+    nodes.clear();
+    current_key.Truncate(0);
+    leaf = Node{};
+}
+
+Node ART::Iterator::PushPrefix(const Node& node) {
+    auto& inlined = node.GetInlinePrefix(art);
+    for (idx_t i = 0; i < inlined.count; i++) {
+        current_key.Push(inlined.data[i]);
+    }
+    auto prefix = node.GetPrefix(art);
+    while (prefix.getTag() == NType::PREFIX) {
+        auto p = art.GetAllocator(NType::PREFIX).Get<const Prefix>(prefix);
+        for (idx_t i = 0; i < p->count; i++) {
+            current_key.Push(p->data[i]);
+        }
+        prefix = p->ptr;
+    }
+    return prefix;
+}
+
+bool ART::Iterator::FindMinimum(Node node) {
+    if (node.IsCleared() || node.getTag() == NType::NODE_DUMMY) {
+        // empty tree
+        Reset();
+        return false;
+    }
+
+    while (true) {
+        auto tail = PushPrefix(node);
+        if (Leaf::IsLeaf(node)) {
+            // the prefix chain of an inlined leaf ends in the inlined leaf (or row id set)
+            leaf = Leaf::HasValue(node) ? node : tail;
+            return true;
+        }
+
+        uint8_t byte = 0;
+        auto child = node.GetNextChild(art, byte);
+        D_ASSERT(child);
+        nodes.emplace_back(node, current_key.Size(), byte);
+        current_key.Push(byte);
+        node = *child;
+    }
+}
+
+bool ART::Iterator::FindMaximum(Node node) {
+    if (node.IsCleared() || node.getTag() == NType::NODE_DUMMY) {
+        // empty tree
+        Reset();
+        return false;
+    }
+
+    while (true) {
+        auto tail = PushPrefix(node);
+        if (Leaf::IsLeaf(node)) {
+            // the prefix chain of an inlined leaf ends in the inlined leaf (or row id set)
+            leaf = Leaf::HasValue(node) ? node : tail;
+            return true;
+        }
+
+        uint8_t byte = UINT8_MAX;
+        auto child = node.GetPrevChild(art, byte);
+        D_ASSERT(child);
+        nodes.emplace_back(node, current_key.Size(), byte);
+        current_key.Push(byte);
+        node = *child;
+    }
+}
+
+bool ART::Iterator::NextFromStack() {
+    while (!nodes.empty()) {
+        auto& top = nodes.back();
+        current_key.Truncate(top.depth);
+        if (top.byte < UINT8_MAX) {
+            uint8_t byte = top.byte + 1;
+            auto child = top.node.GetNextChild(art, byte);
+            if (child) {
+                top.byte = byte;
+                current_key.Push(byte);
+                return FindMinimum(*child);
+            }
+        }
+        nodes.pop_back();
+    }
+    Reset();
+    return false;
+}
+
+bool ART::Iterator::PrevFromStack() {
+    while (!nodes.empty()) {
+        auto& top = nodes.back();
+        current_key.Truncate(top.depth);
+        if (top.byte > 0) {
+            uint8_t byte = top.byte - 1;
+            auto child = top.node.GetPrevChild(art, byte);
+            if (child) {
+                top.byte = byte;
+                current_key.Push(byte);
+                return FindMaximum(*child);
+            }
+        }
+        nodes.pop_back();
+    }
+    Reset();
+    return false;
+}
+
+int ART::Iterator::ComparePrefix(const Node& node, const ARTKey& key, idx_t& depth) const {
+    auto prefix_depth = depth;
+    // compares the bytes of the prefix with the key
+    auto compare = [&](const uint8_t* data, const idx_t count) {
+        for (idx_t i = 0; i < count; i++) {
+            // the key ends within the prefix, so all keys of the subtree are longer
+            if (prefix_depth >= key.len || data[i] > key[prefix_depth]) {
+                return 1;
+            }
+            if (data[i] < key[prefix_depth]) {
+                return -1;
+            }
+            prefix_depth++;
+        }
+        return 0;
+    };
+    auto& inlined = node.GetInlinePrefix(art);
+    auto cmp = compare(inlined.data, inlined.count);
+    auto prefix = node.GetPrefix(art);
+    while (cmp == 0 && prefix.getTag() == NType::PREFIX) {
+        auto p = art.GetAllocator(NType::PREFIX).Get<const Prefix>(prefix);
+        cmp = compare(p->data, p->count);
+        prefix = p->ptr;
+    }
+    if (cmp == 0) {
+        depth = prefix_depth;
+    }
+    return cmp;
+}
+
+bool ART::Iterator::Seek(const ARTKey& key, const bool equal) {
+    Reset();
+    auto node = *art.root;
+    if (node.IsCleared() || node.getTag() == NType::NODE_DUMMY) {
+        return false;
+    }
+
+    idx_t depth = 0;
+    while (true) {
+        auto cmp = ComparePrefix(node, key, depth);
+        if (cmp > 0) {
+            return FindMinimum(node);
+        }
+        if (cmp < 0) {
+            return NextFromStack();
+        }
+
+        if (Leaf::IsLeaf(node)) {
+            if (depth == key.len && equal) {
+                return FindMinimum(node);
+            }
+            // the leaf key equals key, or it is a prefix of key
+            return NextFromStack();
+        }
+        if (depth >= key.len) {
+            return FindMinimum(node);
+        }
+
+        PushPrefix(node);
+        uint8_t byte = key[depth];
+        auto child = node.GetNextChild(art, byte);
+        if (!child) {
+            return NextFromStack();
+        }
+        nodes.emplace_back(node, current_key.Size(), byte);
+        current_key.Push(byte);
+        if (byte > key[depth]) {
+            return FindMinimum(*child);
+        }
+        node = *child;
+        depth++;
+    }
+}
+
+}  // namespace duckart
@@ -0,0 +1,70 @@
+#include "key_batch.hpp"
+
+namespace duckart {
+
+const std::vector<ARTKey> &ARTKeyBatch::Encode() {
+    D_ASSERT(!columns.empty());
+    keys.clear();
+    idx_t width = 0;
+    bool fixed = true;
+    for (auto &column : columns) {
+        width += column.width;
+        fixed = fixed && column.width;
+    }
+
+    // keys of the same length: each column is one strided pass over the buffer
+    if (fixed) {
+        buffer.resize(count * width);
+        idx_t pos = 0;
+        for (auto &column : columns) {
+            column.encode(column.values, count, buffer.data() + pos, width);
+            pos += column.width;
+        }
+        for (idx_t i = 0; i < count; i++) {
+            keys.push_back(ARTKey::View(buffer.data() + i * width, static_cast<uint32_t>(width)));
+        }
+        return keys;
+    }
+
+    // with strings, the keys start at offsets, and the columns append to each key
+    offsets.assign(count + 1, 0);
+    for (auto &column : columns) {
+        if (column.width) {
+            continue;
+        }
+        auto strings = reinterpret_cast<const string_t *>(column.values);
+        for (idx_t i = 0; i < count; i++) {
+            offsets[i + 1] += ARTKey::GetKeyLength(strings[i]);
+        }
+    }
+    for (idx_t i = 0; i < count; i++) {
+        offsets[i + 1] += offsets[i] + width;
+    }
+    buffer.resize(offsets[count]);
+
+    cursors.assign(offsets.begin(), offsets.end() - 1);
+    for (auto &column : columns) {
+        if (column.width) {
+            for (idx_t i = 0; i < count; i++) {
+                column.encode(column.values + i * column.width, 1, buffer.data() + cursors[i], column.width);
+                cursors[i] += column.width;
+            }
+            continue;
+        }
+        auto strings = reinterpret_cast<const string_t *>(column.values);
+        for (idx_t i = 0; i < count; i++) {
+            // as ARTKey::CreateARTKey, without copying the string_t
+            auto size = strings[i].GetSize();
+            std::memcpy(buffer.data() + cursors[i], strings[i].GetData(), size);
+            buffer[cursors[i] + size] = '\0';
+            cursors[i] += size + 1;
+        }
+    }
+    for (idx_t i = 0; i < count; i++) {
+        D_ASSERT(cursors[i] == offsets[i + 1]);
+        keys.push_back(ARTKey::View(buffer.data() + offsets[i], static_cast<uint32_t>(offsets[i + 1] - offsets[i])));
+    }
+    return keys;
+}
+
+}  // namespace duckart
@@ -1,22 +1,49 @@
 #include "leaf.hpp"
 
+#include "exception.hpp"
+#include "prefix.hpp"
 #include "string_type.hpp"
+#include "value_arena.hpp"
 
 namespace duckart {
 // Leaf
 Leaf& Leaf::New(ART& art, Node& node, const Value& value) {    
-    node = Node::GetAllocator(art, NType::LEAF).New();      
-    node.setTag(NType::LEAF);  // set Node Type
+    node = Node::GetAllocator(art, NType::LEAF).New(NType::LEAF);
     auto& lnode = Node::RefMutable<Leaf>(art, node, NType::LEAF);
-    lnode.value = value;   
+    lnode.prefix = Node{};
+    // the slot is raw memory, so construct the value in place, larger values live in the
+    // value arena of the tree
+    new (&lnode.value) Value();
+    art.GetValueArena().Assign(lnode.value, value);
     return lnode;
 }
 
 
 void Leaf::Free(ART& art, Node& node) {
-    Node::GetAllocator(art, NType::LEAF).Free(node.getPointer());
+    if (art.IsConcurrent()) {
+        // leaves are immutable once they are in a concurrent tree, so readers
+        // might still read the prefix and the value of the whole leaf
+        art.Retire(node);
+        node.Clear();
+        return;
+    }
+    auto& lnode = Node::RefMutable<Leaf>(art, node, NType::LEAF);
+    Prefix::Free(art, lnode.prefix);
+    art.GetValueArena().Release(lnode.value);
+
+    Node::GetAllocator(art, NType::LEAF).Free(node);
     node.Clear();
 }
 
+void Leaf::NewInlined(ART& art, Node& node, const idx_t row_id) {
+    if (art.IsConcurrent()) {
+        throw NotImplementedException("Inlined leaves are not supported in concurrent trees.");
+    }
+    if (row_id > MAX_INLINED_ROW_ID) {
+        throw InternalException("Row id is too large for an inlined leaf.");
+    }
+    // plus one, so that row id 0 differs from a cleared pointer
+    node.SetPayload(row_id + 1, NType::LEAF_INLINED);
+}
 
 }  // namespace duckart
@@ -17,45 +17,53 @@ FixedSizeAllocator& Node::GetAllocator(const ART& art, const NType type) {
     return art.GetAllocator(type);
 }
 
+//! Returns the node for modification, which marks its block as dirty (see ART::Checkpoint)
+template <typename NODE>
+static NODE& GetMutable(const ART& art, const Node& ptr, const NType type) {
+    auto& allocator = Node::GetAllocator(art, type);
+    allocator.MarkDirty(ptr);
+    return *allocator.Get<NODE>(ptr);
+}
+
 template <typename NODE>
 NODE& Node::RefMutable(const ART& art, const Node& ptr, const NType type) {
-    return *static_cast<NODE*>(GetAllocator(art, type).Get<NODE>(ptr));
+    return GetMutable<NODE>(art, ptr, type);
 }
 // begin why ?
 template <>
 Prefix& Node::RefMutable<Prefix>(const ART& art, const Node& ptr,
                                  const NType type) {
-    return *static_cast<Prefix*>(GetAllocator(art, type).Get<Prefix>(ptr));
+    return GetMutable<Prefix>(art, ptr, type);
 }
 
 template <>
 Node4& Node::RefMutable<Node4>(const ART& art, const Node& ptr,
                                const NType type) {
-    return *static_cast<Node4*>(GetAllocator(art, type).Get<Node4>(ptr));
+    return GetMutable<Node4>(art, ptr, type);
 }
 
 template <>
 Node16& Node::RefMutable<Node16>(const ART& art, const Node& ptr,
                                  const NType type) {
-    return *static_cast<Node16*>(GetAllocator(art, type).Get<Node16>(ptr));
+    return GetMutable<Node16>(art, ptr, type);
 }
 
 template <>
 Node48& Node::RefMutable<Node48>(const ART& art, const Node& ptr,
                                  const NType type) {
-    return *static_cast<Node48*>(GetAllocator(art, type).Get<Node48>(ptr));
+    return GetMutable<Node48>(art, ptr, type);
 }
 
 template <>
 Node256& Node::RefMutable<Node256>(const ART& art, const Node& ptr,
                                    const NType type) {
-    return *static_cast<Node256*>(GetAllocator(art, type).Get<Node256>(ptr));
+    return GetMutable<Node256>(art, ptr, type);
 }
 
 template <>
 Leaf& Node::RefMutable<Leaf>(const ART& art, const Node& ptr,
                              const NType type) {
-    return *static_cast<Leaf*>(GetAllocator(art, type).Get<Leaf>(ptr));
+    return GetMutable<Leaf>(art, ptr, type);
 }
 // end why?
 
@@ -65,6 +73,9 @@ const NODE& Node::Ref(const ART& art, const Node& ptr, const NType type) {
         GetAllocator(art, type).Get<const NODE>(ptr));
 }
 
+// read-only lookups of the tree read leaves through Ref
+template const Leaf& Node::Ref<const Leaf>(const ART& art, const Node& ptr, const NType type);
+
 template <>
 const Prefix& Node::Ref<const Prefix>(const ART& art, const Node& ptr,
                                       const NType type) {
@@ -97,10 +108,15 @@ void Node::Free(ART& art, Node& node) {
     if (node.IsCleared()) {
         return node.Clear();
     }
+    // a row id set is a regular node behind the gate
+    node.SetGate(false);
 
     // free the children of the nodes
     auto type = node.getTag();
     switch (type) {
+        case NType::NODE_DUMMY:
+        case NType::LEAF_INLINED:
+            return node.Clear();
         // iterative
         case NType::LEAF:
             return Leaf::Free(art, node);
@@ -121,10 +137,22 @@ void Node::Free(ART& art, Node& node) {
             break;
     }
 
-    GetAllocator(art, type).Free(node.getPointer());
+    // free the prefix chain of inner nodes
+    auto prefix = node.GetPrefix(art);
+    Prefix::Free(art, prefix);
+
+    FreeSlot(art, node);
     node.Clear();
 }
 
+void Node::FreeSlot(ART& art, const Node& node) {
+    if (art.IsConcurrent()) {
+        // concurrent readers might still read the node
+        return art.Retire(node);
+    }
+    art.GetSlotAllocator(node).Free(node);
+}
+
 //===--------------------------------------------------------------------===//
 // Inserts
 //===--------------------------------------------------------------------===//
@@ -214,15 +242,82 @@ const Node Node::GetChild(ART& art, const uint8_t byte) const {
     }
 }
 
-const Node Node::GetPrefix(ART& art) const {
+Node* Node::GetNextChildMutable(ART& art, uint8_t& byte) const {
+    D_ASSERT(!IsCleared());
+
+    auto type = getTag();
+    switch (type) {
+        case NType::NODE_4:
+            return RefMutable<Node4>(art, *this, NType::NODE_4)
+                .GetNextChildMutable(byte);
+        case NType::NODE_16:
+            return RefMutable<Node16>(art, *this, NType::NODE_16)
+                .GetNextChildMutable(byte);
+        case NType::NODE_48:
+            return RefMutable<Node48>(art, *this, NType::NODE_48)
+                .GetNextChildMutable(byte);
+        case NType::NODE_256:
+            return RefMutable<Node256>(art, *this, NType::NODE_256)
+                .GetNextChildMutable(byte);
+        default:
+            throw InternalException("Invalid node type for GetNextChildMutable.");
+    }
+}
+
+const Node* Node::GetNextChild(const ART& art, uint8_t& byte) const {
+    D_ASSERT(!IsCleared());
+
+    auto type = getTag();
+    switch (type) {
+        case NType::NODE_4:
+            return Ref<const Node4>(art, *this, NType::NODE_4).GetNextChild(byte);
+        case NType::NODE_16:
+            return Ref<const Node16>(art, *this, NType::NODE_16).GetNextChild(byte);
+        case NType::NODE_48:
+            return Ref<const Node48>(art, *this, NType::NODE_48).GetNextChild(byte);
+        case NType::NODE_256:
+            return Ref<const Node256>(art, *this, NType::NODE_256).GetNextChild(byte);
+        default:
+            throw InternalException("Invalid node type for GetNextChild.");
+    }
+}
+
+const Node* Node::GetPrevChild(const ART& art, uint8_t& byte) const {
+    D_ASSERT(!IsCleared());
+
+    auto type = getTag();
+    switch (type) {
+        case NType::NODE_4:
+            return Ref<const Node4>(art, *this, NType::NODE_4).GetPrevChild(byte);
+        case NType::NODE_16:
+            return Ref<const Node16>(art, *this, NType::NODE_16).GetPrevChild(byte);
+        case NType::NODE_48:
+            return Ref<const Node48>(art, *this, NType::NODE_48).GetPrevChild(byte);
+        case NType::NODE_256:
+            return Ref<const Node256>(art, *this, NType::NODE_256).GetPrevChild(byte);
+        default:
+            throw InternalException("Invalid node type for GetPrevChild.");
+    }
+}
+
+const Node Node::GetPrefix(const ART& art) const {
     D_ASSERT(!IsCleared());
     LOG_DEBUG("get prefix,node type:" +
               std::to_string(static_cast<int>(getTag())));
+    // the key bytes of a row id set are the prefix chain ahead of it, like for an inlined leaf
+    if (IsGate()) {
+        return *this;
+    }
 
     auto type = getTag();
     switch (type) {
         case NType::LEAF:
             return Ref<const Leaf>(art, *this, NType::LEAF).prefix;
+        // the key bytes of an inlined leaf are the prefix chain ahead of it, which ends
+        // in the inlined leaf
+        case NType::PREFIX:
+        case NType::LEAF_INLINED:
+            return *this;
         case NType::NODE_4:
             return Ref<const Node4>(art, *this, NType::NODE_4).prefix;
         case NType::NODE_16:
@@ -263,6 +358,63 @@ void Node::SetPrefix(ART& art, Node& node) const {
     }
 }
 
+const InlinePrefix& Node::GetInlinePrefix(const ART& art) const {
+    // leaves, prefix nodes and row id sets keep their key bytes in prefix chains
+    static const InlinePrefix EMPTY {};
+    if (IsGate()) {
+        return EMPTY;
+    }
+    switch (getTag()) {
+        case NType::NODE_4:
+            return Ref<const Node4>(art, *this, NType::NODE_4).inline_prefix;
+        case NType::NODE_16:
+            return Ref<const Node16>(art, *this, NType::NODE_16).inline_prefix;
+        case NType::NODE_48:
+            return Ref<const Node48>(art, *this, NType::NODE_48).inline_prefix;
+        case NType::NODE_256:
+            return Ref<const Node256>(art, *this, NType::NODE_256).inline_prefix;
+        default:
+            return EMPTY;
+    }
+}
+
+//! Applies fn to the inline prefix and the prefix chain of an inner node
+template <class FN>
+static void UpdateInnerPrefix(ART& art, const Node& node, FN&& fn) {
+    switch (node.getTag()) {
+        case NType::NODE_4: {
+            auto& n4 = Node::RefMutable<Node4>(art, node, NType::NODE_4);
+            return fn(n4.inline_prefix, n4.prefix);
+        }
+        case NType::NODE_16: {
+            auto& n16 = Node::RefMutable<Node16>(art, node, NType::NODE_16);
+            return fn(n16.inline_prefix, n16.prefix);
+        }
+        case NType::NODE_48: {
+            auto& n48 = Node::RefMutable<Node48>(art, node, NType::NODE_48);
+            return fn(n48.inline_prefix, n48.prefix);
+        }
+        case NType::NODE_256: {
+            auto& n256 = Node::RefMutable<Node256>(art, node, NType::NODE_256);
+            return fn(n256.inline_prefix, n256.prefix);
+        }
+        default:
+            return;
+    }
+}
+
+void Node::UnpackPrefix(ART& art) const {
+    if (!IsGate()) {
+        UpdateInnerPrefix(art, *this, [&](InlinePrefix& inlined, Node& prefix) { Prefix::Unpack(art, inlined, prefix); });
+    }
+}
+
+void Node::PackPrefix(ART& art) const {
+    if (!IsGate()) {
+        UpdateInnerPrefix(art, *this, [&](InlinePrefix& inlined, Node& prefix) { Prefix::Pack(art, inlined, prefix); });
+    }
+}
+
 void Node::Print(ART& art, Node& node) {
     D_ASSERT(!node.IsCleared());
 
@@ -271,19 +423,19 @@ void Node::Print(ART& art, Node& node) {
     switch (type) {
         case NType::NODE_4:
             node_string =
-                RefMutable<Node4>(art, node, NType::NODE_4).ToString(art);
+                Ref<const Node4>(art, node, NType::NODE_4).ToString(art);
             break;
         case NType::NODE_16:
             node_string =
-                RefMutable<Node16>(art, node, NType::NODE_16).ToString(art);
+                Ref<const Node16>(art, node, NType::NODE_16).ToString(art);
             break;
         case NType::NODE_48:
             node_string =
-                RefMutable<Node48>(art, node, NType::NODE_48).ToString(art);
+                Ref<const Node48>(art, node, NType::NODE_48).ToString(art);
             break;
         case NType::NODE_256:
             node_string =
-                RefMutable<Node256>(art, node, NType::NODE_256).ToString(art);
+                Ref<const Node256>(art, node, NType::NODE_256).ToString(art);
             break;
         default:
             node_string =
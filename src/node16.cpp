@@ -8,11 +8,12 @@ namespace duckart {
 
 Node16 &Node16::New(ART &art, Node &node) {    
     LOG_DEBUG("new Node16..." );
-	node = Node::GetAllocator(art, NType::NODE_16).New();
-    D_ASSERT(node.getPointer()!=nullptr);
-	node.setTag(NType::NODE_16);
+	node = Node::GetAllocator(art, NType::NODE_16).New(NType::NODE_16);
 	auto &n16 = Node::RefMutable<Node16>(art, node, NType::NODE_16);
 
+	n16.prefix = Node{};
+	n16.inline_prefix.count = 0;
+	n16.version = 0;
 	n16.count = 0;
 	return n16;
 }
@@ -36,6 +37,7 @@ Node16 &Node16::GrowNode4(ART &art, Node &node16, Node &node4) {
     //copy perfix
     //std::memcpy(node16.prefix,node4.prefix,PREFIX_SIZE+1);
     n16.prefix = n4.prefix;
+    n16.inline_prefix = n4.inline_prefix;
 
     // copy child
     n16.count = n4.count;
@@ -45,6 +47,7 @@ Node16 &Node16::GrowNode4(ART &art, Node &node16, Node &node4) {
     }
 
     n4.count = 0;
+    n4.prefix = Node{};
     Node::Free(art, node4);
     return n16;
 }
@@ -56,6 +59,7 @@ Node16 &Node16::ShrinkNode48(ART &art, Node &node16, Node &node48) {
     //copy perfix
     //std::memcpy(node16.prefix,node48.prefix,PREFIX_SIZE+1);
     n16.prefix = n48.prefix;
+    n16.inline_prefix = n48.inline_prefix;
 
     // copy child
     n16.count = 0;
@@ -69,6 +73,7 @@ Node16 &Node16::ShrinkNode48(ART &art, Node &node16, Node &node48) {
     }
 
     n48.count = 0;
+    n48.prefix = Node{};
     Node::Free(art, node48);
     return n16;
 }
@@ -79,17 +84,12 @@ void Node16::InsertChild(ART &art, Node &node, const uint8_t byte,
     auto &n16 = Node::RefMutable<Node16>(art, node, NType::NODE_16);
 
     // ensure that there is no other child at the same byte
-    for (idx_t i = 0; i < n16.count; i++) {
-        D_ASSERT(n16.key[i] != byte);
-    }
+    D_ASSERT(FindKeyByte<NODE_16_CAPACITY>(n16.key, n16.count, byte) == INVALID_INDEX);
 
     // insert new child node into node
     if (n16.count < NODE_16_CAPACITY) {
         // still space, just insert the child
-        idx_t child_pos = 0;
-        while (child_pos < n16.count && n16.key[child_pos] < byte) {
-            child_pos++;
-        }
+        auto child_pos = LowerBoundKeyByte<NODE_16_CAPACITY>(n16.key, n16.count, byte);
         // move children backwards to make space
         for (idx_t i = n16.count; i > child_pos; i--) {
             n16.key[i] = n16.key[i - 1];
@@ -112,14 +112,8 @@ void Node16::DeleteChild(ART &art, Node &node, const uint8_t byte) {
     D_ASSERT(!node.IsCleared());
     auto &n16 = Node::RefMutable<Node16>(art, node, NType::NODE_16);
 
-    idx_t child_pos = 0;
-    for (; child_pos < n16.count; child_pos++) {
-        if (n16.key[child_pos] == byte) {
-            break;
-        }
-    }
-
-    D_ASSERT(child_pos < n16.count);
+    auto child_pos = FindKeyByte<NODE_16_CAPACITY>(n16.key, n16.count, byte);
+    D_ASSERT(child_pos != INVALID_INDEX);
 
     // free the child and decrease the count
     Node::Free(art, n16.children[child_pos]);
@@ -139,28 +133,39 @@ void Node16::DeleteChild(ART &art, Node &node, const uint8_t byte) {
 }
 
 void Node16::ReplaceChild(const uint8_t byte, const Node child) {
-    for (idx_t i = 0; i < count; i++) {
-        if (key[i] == byte) {
-            children[i] = child;
-            return;
-        }
+    auto pos = FindKeyByte<NODE_16_CAPACITY>(key, count, byte);
+    if (pos != INVALID_INDEX) {
+        children[pos] = child;
     }
 }
 
-const Node Node16::GetChild(const uint8_t byte) const {
-    for (idx_t i = 0; i < count; i++) {
-        if (key[i] == byte) {
-            D_ASSERT(!children[i].IsCleared());
-            return children[i];
-        }
+Node *Node16::GetNextChildMutable(uint8_t &byte) {
+    return const_cast<Node *>(GetNextChild(byte));
+}
+
+const Node *Node16::GetNextChild(uint8_t &byte) const {
+    auto pos = LowerBoundKeyByte<NODE_16_CAPACITY>(key, count, byte);
+    if (pos < count) {
+        byte = key[pos];
+        return &children[pos];
+    }
+    return nullptr;
+}
+
+const Node *Node16::GetPrevChild(uint8_t &byte) const {
+    // number of keys less than or equal to byte
+    auto pos = byte == UINT8_MAX ? count : LowerBoundKeyByte<NODE_16_CAPACITY>(key, count, byte + 1);
+    if (pos > 0) {
+        byte = key[pos - 1];
+        return &children[pos - 1];
     }
-    return Node{};
+    return nullptr;
 }
 
 std::string Node16::ToString(ART &art) const {
     std::stringstream ss;
 
-    ss << "{node_type:Node16, prefix:" << Prefix::ToString(art, prefix)
+    ss << "{node_type:Node16, prefix:" << Prefix::ToString(art, inline_prefix, prefix)
        << ", size:" << static_cast<int>(count) << ", child:[";
 
     bool first = true;
@@ -173,7 +178,7 @@ std::string Node16::ToString(ART &art) const {
                <<",node_type:"
                << static_cast<int>(children[i].getTag())
                << ", prefix:"
-               << Prefix::ToString(art, children[i].GetPrefix(art)) 
+               << Prefix::ToString(art, children[i].GetInlinePrefix(art), children[i].GetPrefix(art)) 
                //<<","<<children[i].GetPrefix(art).AddrToString()
                <<"}";
             first = false;
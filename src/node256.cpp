@@ -9,11 +9,12 @@ namespace duckart {
 Node256 &Node256::New(ART &art, Node &node) {    
     LOG_DEBUG("new Node256..." );
 
-    node = Node::GetAllocator(art, NType::NODE_256).New();
-    D_ASSERT(node.getPointer()!=nullptr);
-    node.setTag(NType::NODE_256);
+    node = Node::GetAllocator(art, NType::NODE_256).New(NType::NODE_256);
     auto &n256 = Node::RefMutable<Node256>(art, node, NType::NODE_256);
 
+    n256.prefix = Node{};
+    n256.inline_prefix.count = 0;
+    n256.version = 0;
     n256.count = 0;
     for (idx_t i = 0; i < NODE_256_CAPACITY; i++) {
         n256.children[i].Clear();
@@ -45,6 +46,7 @@ Node256 &Node256::GrowNode48(ART &art, Node &node256, Node &node48) {
     //copy perfix
     //std::memcpy(node256.prefix,node48.prefix,PREFIX_SIZE+1);
     n256.prefix = n48.prefix;
+    n256.inline_prefix = n48.inline_prefix;
 
     // copy child
     n256.count = n48.count;
@@ -57,6 +59,7 @@ Node256 &Node256::GrowNode48(ART &art, Node &node256, Node &node48) {
     }
 
     n48.count = 0;
+    n48.prefix = Node{};
     
     LOG_DEBUG("GrowNode48 ...");
 
@@ -96,17 +99,34 @@ void Node256::DeleteChild(ART &art, Node &node, const uint8_t byte) {
    
 }
 
-const Node Node256::GetChild(const uint8_t byte) const {
-    if (!children[byte].IsCleared()) {
-        return  children[byte];
+Node *Node256::GetNextChildMutable(uint8_t &byte) {
+    return const_cast<Node *>(GetNextChild(byte));
+}
+
+const Node *Node256::GetNextChild(uint8_t &byte) const {
+    for (idx_t i = byte; i < NODE_256_CAPACITY; i++) {
+        if (!children[i].IsCleared()) {
+            byte = static_cast<uint8_t>(i);
+            return &children[i];
+        }
+    }
+    return nullptr;
+}
+
+const Node *Node256::GetPrevChild(uint8_t &byte) const {
+    for (idx_t i = byte + 1; i > 0; i--) {
+        if (!children[i - 1].IsCleared()) {
+            byte = static_cast<uint8_t>(i - 1);
+            return &children[i - 1];
+        }
     }
-    return Node{};
+    return nullptr;
 }
 
 std::string Node256::ToString(ART &art) const {
     std::stringstream ss;
 
-    ss << "{node_type:Node256, prefix:" << Prefix::ToString(art, prefix)
+    ss << "{node_type:Node256, prefix:" << Prefix::ToString(art, inline_prefix, prefix)
        << ", size:" << static_cast<int>(count) << ", child:[";
 
     bool first = true;
@@ -118,7 +138,7 @@ std::string Node256::ToString(ART &art) const {
             ss << "{child:" << i 
                << ", byte:" << static_cast<char>(i)
                << ", node_type:" << static_cast<int>(children[i].getTag())
-               << ", prefix:" << Prefix::ToString(art, children[i].GetPrefix(art))
+               << ", prefix:" << Prefix::ToString(art, children[i].GetInlinePrefix(art), children[i].GetPrefix(art))
                << "}";
             first = false;
         }
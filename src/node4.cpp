@@ -4,6 +4,7 @@
 #include <memory>
 #include <vector>
 
+#include "leaf.hpp"
 #include "node16.hpp"
 
 namespace duckart {
@@ -12,13 +13,13 @@ namespace duckart {
 Node4 &Node4::New(ART &art, Node &node) {
     LOG_DEBUG("new Node4...");
 
-    node = Node::GetAllocator(art, NType::NODE_4).New();
-    D_ASSERT(node.getPointer() != nullptr);
-    node.setTag(NType::NODE_4);  // set Node Type
+    node = Node::GetAllocator(art, NType::NODE_4).New(NType::NODE_4);
     auto &n4 = Node::RefMutable<Node4>(art, node, NType::NODE_4);
 
     // prefix
-    n4.prefix = Node{};   
+    n4.prefix = Node{};
+    n4.inline_prefix.count = 0;
+    n4.version = 0;
 
     // child count
     n4.count = 0;
@@ -45,11 +46,9 @@ void Node4::Free(ART &art, Node &node) {
 }
 
 void Node4::ReplaceChild(const uint8_t byte, const Node child) {
-    for (idx_t i = 0; i < count; i++) {
-        if (key[i] == byte) {
-            children[i] = child;
-            return;
-        }
+    auto pos = FindKeyByte<NODE_4_CAPACITY>(key, count, byte);
+    if (pos != INVALID_INDEX) {
+        children[pos] = child;
     }
 }
 
@@ -60,17 +59,12 @@ void Node4::InsertChild(ART &art, Node &node, const uint8_t byte,
     auto &n4 = Node::RefMutable<Node4>(art, node, NType::NODE_4);
 
     // ensure that there is no other child at the same byte
-    for (idx_t i = 0; i < n4.count; i++) {
-        D_ASSERT(n4.key[i] != byte);
-    }
+    D_ASSERT(FindKeyByte<NODE_4_CAPACITY>(n4.key, n4.count, byte) == INVALID_INDEX);
 
     // insert new child node into node
     if (n4.count < NODE_4_CAPACITY) {
         // still space, just insert the child
-        idx_t child_pos = 0;
-        while (child_pos < n4.count && n4.key[child_pos] < byte) {
-            child_pos++;
-        }
+        auto child_pos = LowerBoundKeyByte<NODE_4_CAPACITY>(n4.key, n4.count, byte);
         // move children backwards to make space
         for (idx_t i = n4.count; i > child_pos; i--) {
             n4.key[i] = n4.key[i - 1];
@@ -94,14 +88,8 @@ void Node4::DeleteChild(ART &art, Node &node, const uint8_t byte) {
     D_ASSERT(!node.IsCleared());
     auto &n4 = Node::RefMutable<Node4>(art, node, NType::NODE_4);
 
-    idx_t child_pos = 0;
-    for (; child_pos < n4.count; child_pos++) {
-        if (n4.key[child_pos] == byte) {
-            break;
-        }
-    }
-
-    D_ASSERT(child_pos < n4.count); 
+    auto child_pos = FindKeyByte<NODE_4_CAPACITY>(n4.key, n4.count, byte);
+    D_ASSERT(child_pos != INVALID_INDEX); 
     D_ASSERT(n4.count > 1);
 
     // free the child and decrease the count
@@ -123,16 +111,26 @@ void Node4::DeleteChild(ART &art, Node &node, const uint8_t byte) {
 		// new prefix nodes)
 		auto old_n4_node = node;
 
-		// get only child and concatenate prefixes
+		// get only child and concatenate prefixes, the chain operations apply to prefix
+		// chains only, so move inline prefixes into chains first
 		auto child = n4.GetChild(n4.key[0]);
+        Prefix::Unpack(art, n4.inline_prefix, n4.prefix);
+        child.UnpackPrefix(art);
         auto child_prefix = child.GetPrefix(art);
         auto n4_prefix = n4.prefix;
 		Prefix::Concatenate(art, n4_prefix, n4.key[0], child_prefix);
-        child.SetPrefix(art,n4_prefix);
+        if (Leaf::IsInlined(child)) {
+            // the concatenated chain ends in the inlined leaf, and replaces it
+            child = n4_prefix;
+        } else {
+            child.SetPrefix(art,n4_prefix);
+            child.PackPrefix(art);
+        }
         
         Node::Swap(node, child);
 
 		n4.count--;
+		n4.prefix = Node{};
 		Node::Free(art, old_n4_node);
 	}
 }
@@ -144,30 +142,45 @@ Node4 &Node4::ShrinkNode16(ART &art, Node &node4, Node &node16) {
     D_ASSERT(n16.count <= NODE_4_CAPACITY);
     n4.count = n16.count;
     n4.prefix = n16.prefix;
+    n4.inline_prefix = n16.inline_prefix;
     for (idx_t i = 0; i < n16.count; i++) {
         n4.key[i] = n16.key[i];
         n4.children[i] = n16.children[i];
     }
 
     n16.count = 0;
+    n16.prefix = Node{};
     Node::Free(art, node16);
     return n4;
 }
 
-const Node Node4::GetChild(const uint8_t byte) const {
-    for (idx_t i = 0; i < count; i++) {
-        if (key[i] == byte) {
-            D_ASSERT(!children[i].IsCleared());
-            return children[i];
-        }
+Node *Node4::GetNextChildMutable(uint8_t &byte) {
+    return const_cast<Node *>(GetNextChild(byte));
+}
+
+const Node *Node4::GetNextChild(uint8_t &byte) const {
+    auto pos = LowerBoundKeyByte<NODE_4_CAPACITY>(key, count, byte);
+    if (pos < count) {
+        byte = key[pos];
+        return &children[pos];
+    }
+    return nullptr;
+}
+
+const Node *Node4::GetPrevChild(uint8_t &byte) const {
+    // number of keys less than or equal to byte
+    auto pos = byte == UINT8_MAX ? count : LowerBoundKeyByte<NODE_4_CAPACITY>(key, count, byte + 1);
+    if (pos > 0) {
+        byte = key[pos - 1];
+        return &children[pos - 1];
     }
-    return Node{};
+    return nullptr;
 }
 
 std::string Node4::ToString(ART &art) const {
     std::stringstream ss;
 
-    ss << "{node_type:Node4, prefix:" << Prefix::ToString(art, prefix)
+    ss << "{node_type:Node4, prefix:" << Prefix::ToString(art, inline_prefix, prefix)
        << ", size:" << static_cast<int>(count) << ", child:[";
 
     bool first = true;
@@ -180,7 +193,7 @@ std::string Node4::ToString(ART &art) const {
                <<",node_type:"
                << static_cast<int>(children[i].getTag())
                << ", prefix:"
-               << Prefix::ToString(art, children[i].GetPrefix(art)) 
+               << Prefix::ToString(art, children[i].GetInlinePrefix(art), children[i].GetPrefix(art)) 
                //<<","<<children[i].GetPrefix(art).AddrToString()
                <<"}";
             first = false;
@@ -10,11 +10,12 @@ namespace duckart {
 Node48 &Node48::New(ART &art, Node &node) {
     LOG_DEBUG("new Node48..." );
 
-    node = Node::GetAllocator(art, NType::NODE_48).New();
-    D_ASSERT(node.getPointer()!=nullptr);
-    node.setTag(NType::NODE_48);
+    node = Node::GetAllocator(art, NType::NODE_48).New(NType::NODE_48);
     auto &n48 = Node::RefMutable<Node48>(art, node, NType::NODE_48);
 
+    n48.prefix = Node{};
+    n48.inline_prefix.count = 0;
+    n48.version = 0;
     n48.count = 0;
     for (idx_t i = 0; i < NODE_256_CAPACITY; i++) {
         n48.child_index[i] = EMPTY_MARKER;
@@ -49,6 +50,7 @@ Node48 &Node48::GrowNode16(ART &art, Node &node48, Node &node16) {
     // copy perfix
     //std::memcpy(node48.prefix,node16.prefix,PREFIX_SIZE+1);
     n48.prefix = n16.prefix;
+    n48.inline_prefix = n16.inline_prefix;
 
     // copy child
     n48.count = n16.count;
@@ -67,6 +69,7 @@ Node48 &Node48::GrowNode16(ART &art, Node &node48, Node &node16) {
     }
 
     n16.count = 0;
+    n16.prefix = Node{};
     Node::Free(art, node16);
     return n48;
 }
@@ -78,6 +81,7 @@ Node48 &Node48::ShrinkNode256(ART &art, Node &node48, Node &node256) {
     //copy perfix
     //std::memcpy(node48.prefix,node256.prefix,PREFIX_SIZE+1);
     n48.prefix = n256.prefix;
+    n48.inline_prefix = n256.inline_prefix;
 
     //copy child
     n48.count = 0;
@@ -98,6 +102,7 @@ Node48 &Node48::ShrinkNode256(ART &art, Node &node48, Node &node256) {
     }
 
     n256.count = 0;
+    n256.prefix = Node{};
     Node::Free(art, node256);
     return n48;
 }
@@ -150,18 +155,34 @@ void Node48::DeleteChild(ART &art, Node &node, const uint8_t byte) {
     }
 }
 
-const Node Node48::GetChild(const uint8_t byte) const {
-    if (child_index[byte] != EMPTY_MARKER) {
-        D_ASSERT(!children[child_index[byte]].IsCleared());
-        return children[child_index[byte]];
+Node *Node48::GetNextChildMutable(uint8_t &byte) {
+    return const_cast<Node *>(GetNextChild(byte));
+}
+
+const Node *Node48::GetNextChild(uint8_t &byte) const {
+    for (idx_t i = byte; i < NODE_256_CAPACITY; i++) {
+        if (child_index[i] != EMPTY_MARKER) {
+            byte = static_cast<uint8_t>(i);
+            return &children[child_index[i]];
+        }
+    }
+    return nullptr;
+}
+
+const Node *Node48::GetPrevChild(uint8_t &byte) const {
+    for (idx_t i = byte + 1; i > 0; i--) {
+        if (child_index[i - 1] != EMPTY_MARKER) {
+            byte = static_cast<uint8_t>(i - 1);
+            return &children[child_index[i - 1]];
+        }
     }
-    return Node{};
+    return nullptr;
 }
 
 std::string Node48::ToString(ART &art) const {
     std::stringstream ss;
 
-    ss << "{node_type:Node48, prefix:" << Prefix::ToString(art, prefix)
+    ss << "{node_type:Node48, prefix:" << Prefix::ToString(art, inline_prefix, prefix)
        << ", size:" << static_cast<int>(count) << ", child:[";
 
     bool first = true;
@@ -174,7 +195,7 @@ std::string Node48::ToString(ART &art) const {
             ss << "{child:" << static_cast<int>(child_index[i]) 
                << ", byte:" << static_cast<char>(i)
                << ", node_type:" << static_cast<int>(child.getTag())
-               << ", prefix:" << Prefix::ToString(art, child.GetPrefix(art))
+               << ", prefix:" << Prefix::ToString(art, child.GetInlinePrefix(art), child.GetPrefix(art))
                << "}";
             first = false;
         }
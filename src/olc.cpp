@@ -0,0 +1,650 @@
+#include "olc.hpp"
+
+#include "art.hpp"
+#include "epoch.hpp"
+#include "leaf.hpp"
+#include "node.hpp"
+#include "node16.hpp"
+#include "node256.hpp"
+#include "node4.hpp"
+#include "node48.hpp"
+#include "prefix.hpp"
+
+namespace duckart {
+
+//===--------------------------------------------------------------------===//
+// Helpers
+//===--------------------------------------------------------------------===//
+// The readers of the concurrent operations read nodes that writers might modify at the same
+// time, so the helpers below must not assert anything about the node contents. The callers
+// validate the version of the node before they act on the results.
+
+//! Returns the slot of the child at byte, or nullptr if there is no such child. Only reads the
+//! node, so that lookups do not mark its block as dirty (see ART::Checkpoint)
+static const Node* GetChild(const ART& art, const Node& node, const uint8_t byte) {
+    auto& allocator = Node::GetAllocator(art, node.getTag());
+    switch (node.getTag()) {
+        case NType::NODE_4: {
+            auto& n4 = *allocator.Get<const Node4>(node);
+            auto count = MinValue<uint8_t>(n4.count, NODE_4_CAPACITY);
+            auto pos = FindKeyByte<NODE_4_CAPACITY>(n4.key, count, byte);
+            return pos == INVALID_INDEX ? nullptr : &n4.children[pos];
+        }
+        case NType::NODE_16: {
+            auto& n16 = *allocator.Get<const Node16>(node);
+            auto count = MinValue<uint8_t>(n16.count, NODE_16_CAPACITY);
+            auto pos = FindKeyByte<NODE_16_CAPACITY>(n16.key, count, byte);
+            return pos == INVALID_INDEX ? nullptr : &n16.children[pos];
+        }
+        case NType::NODE_48: {
+            auto& n48 = *allocator.Get<const Node48>(node);
+            auto idx = n48.child_index[byte];
+            return idx < NODE_48_CAPACITY ? &n48.children[idx] : nullptr;
+        }
+        case NType::NODE_256: {
+            auto& n256 = *allocator.Get<const Node256>(node);
+            return n256.children[byte].IsCleared() ? nullptr : &n256.children[byte];
+        }
+        default:
+            throw InternalException("Invalid node type for GetChildSlot.");
+    }
+}
+
+//! Returns the slot of the child at byte for a writer, see GetChild
+static Node* GetChildSlot(const ART& art, const Node& node, const uint8_t byte) {
+    return const_cast<Node*>(GetChild(art, node, byte));
+}
+
+//! Marks the block of the parent node, whose child slot a writer replaces once it holds the
+//! write lock of the parent. The root pointer is in no block
+static void MarkParent(const ART& art, const Node& parent) {
+    if (!parent.IsCleared()) {
+        Node::GetAllocator(art, parent.getTag()).MarkDirty(parent);
+    }
+}
+
+//! Returns the number of children of the inner node
+static idx_t GetCount(const ART& art, const Node& node) {
+    switch (node.getTag()) {
+        case NType::NODE_4:
+            return Node::GetAllocator(art, NType::NODE_4).Get<const Node4>(node)->count;
+        case NType::NODE_16:
+            return Node::GetAllocator(art, NType::NODE_16).Get<const Node16>(node)->count;
+        case NType::NODE_48:
+            return Node::GetAllocator(art, NType::NODE_48).Get<const Node48>(node)->count;
+        case NType::NODE_256:
+            return Node::GetAllocator(art, NType::NODE_256).Get<const Node256>(node)->count;
+        default:
+            throw InternalException("Invalid node type for GetCount.");
+    }
+}
+
+//! Returns true if inserting a child replaces the node with a larger node
+static bool IsFull(const NType type, const idx_t count) {
+    switch (type) {
+        case NType::NODE_4:
+            return count >= NODE_4_CAPACITY;
+        case NType::NODE_16:
+            return count >= NODE_16_CAPACITY;
+        case NType::NODE_48:
+            return count >= NODE_48_CAPACITY;
+        default:
+            return false;
+    }
+}
+
+//! Returns true if deleting a child replaces the node, i.e., if it shrinks the node or if
+//! it compresses a Node4 into its only remaining child
+static bool IsUnderfull(const NType type, const idx_t count) {
+    switch (type) {
+        case NType::NODE_4:
+            return count <= 2;
+        case NType::NODE_16:
+            return count <= NODE_4_CAPACITY;
+        case NType::NODE_48:
+            return count <= NODE_48_SHRINK_THRESHOLD;
+        case NType::NODE_256:
+            return count <= NODE_256_SHRINK_THRESHOLD + 1;
+        default:
+            return false;
+    }
+}
+
+//! Compares the prefix of the leaf or inner node (its inline prefix or its prefix chain)
+//! with the key at depth. Returns the position of the first mismatching byte, or
+//! INVALID_INDEX if the whole prefix matches. Sets count to the number of bytes of the prefix
+static idx_t ComparePrefix(const ART& art, const Node& node, const ARTKey& key, const idx_t depth, idx_t& count) {
+    auto mismatch = INVALID_INDEX;
+    count = 0;
+    auto compare = [&](const uint8_t* data, const idx_t data_count) {
+        for (idx_t i = 0; i < data_count; i++) {
+            if (mismatch == INVALID_INDEX && (depth + count >= key.len || data[i] != key[depth + count])) {
+                mismatch = count;
+            }
+            count++;
+        }
+    };
+    auto& inlined = node.GetInlinePrefix(art);
+    compare(inlined.data, MinValue<idx_t>(inlined.count, INLINE_PREFIX_SIZE));
+    auto prefix = node.GetPrefix(art);
+    while (prefix.getTag() == NType::PREFIX) {
+        auto& p = Node::Ref<const Prefix>(art, prefix, NType::PREFIX);
+        auto size_class = MinValue<uint8_t>(p.size_class, PREFIX_SEGMENT_CLASSES - 1);
+        compare(p.data, MinValue<idx_t>(p.count, Prefix::Capacity(size_class)));
+        prefix = p.ptr;
+    }
+    return mismatch;
+}
+
+//! Copies the prefix bytes of the leaf or inner node into a new key behind the first len
+//! bytes of head
+static ARTKey GatherPrefix(const ART& art, const Node& node, const ARTKey& head, const idx_t len, const idx_t count) {
+    ARTKey key(static_cast<uint32_t>(len + count));
+    std::memcpy(key.data, head.data, len);
+    auto& inlined = node.GetInlinePrefix(art);
+    std::memcpy(key.data + len, inlined.data, inlined.count);
+    auto pos = len + inlined.count;
+    auto prefix = node.GetPrefix(art);
+    while (prefix.getTag() == NType::PREFIX) {
+        auto& p = Node::Ref<const Prefix>(art, prefix, NType::PREFIX);
+        std::memcpy(key.data + pos, p.data, p.count);
+        pos += p.count;
+        prefix = p.ptr;
+    }
+    D_ASSERT(pos == key.len);
+    return key;
+}
+
+//! Returns true if the leaf holds the key, leaves never change once they are in the tree
+static bool LeafMatches(const ART& art, const Node& leaf, const ARTKey& key, const idx_t depth) {
+    idx_t count;
+    return ComparePrefix(art, leaf, key, depth, count) == INVALID_INDEX && depth + count == key.len;
+}
+
+// The version words are not part of the contents of a node, locking a node does not mark its
+// block as dirty
+uint64_t& ART::GetVersion(const Node& node) const {
+    switch (node.getTag()) {
+        case NType::NODE_4:
+            return Node::GetAllocator(*this, NType::NODE_4).Get<Node4>(node)->version;
+        case NType::NODE_16:
+            return Node::GetAllocator(*this, NType::NODE_16).Get<Node16>(node)->version;
+        case NType::NODE_48:
+            return Node::GetAllocator(*this, NType::NODE_48).Get<Node48>(node)->version;
+        case NType::NODE_256:
+            return Node::GetAllocator(*this, NType::NODE_256).Get<Node256>(node)->version;
+        default:
+            throw InternalException("Invalid node type for GetVersion.");
+    }
+}
+
+void ART::SetLeafPrefix(const Node& leaf, const ARTKey& key, const idx_t depth) {
+    auto& l = Node::RefMutable<Leaf>(*this, leaf, NType::LEAF);
+    D_ASSERT(l.prefix.getTag() != NType::PREFIX);
+    reference<Node> prefix(l.prefix);
+    Prefix::New(*this, prefix, key, depth, key.len - depth);
+}
+
+//===--------------------------------------------------------------------===//
+// Concurrent operations
+//===--------------------------------------------------------------------===//
+bool ART::ConcurrentInsert(const ARTKey& key, const Value& value) {
+    D_ASSERT(concurrent);
+    CheckWritable();
+    EpochGuard guard(*epochs);
+    // the leaf is private until an attempt publishes it, which sets its prefix
+    Node leaf;
+    Leaf::New(*this, leaf, value);
+    while (true) {
+        bool restart = false;
+        auto inserted = TryInsert(key, leaf, restart);
+        if (!restart) {
+            return inserted;
+        }
+    }
+}
+
+bool ART::ConcurrentDelete(const ARTKey& key) {
+    D_ASSERT(concurrent);
+    CheckWritable();
+    EpochGuard guard(*epochs);
+    while (true) {
+        bool restart = false;
+        auto deleted = TryDelete(key, restart);
+        if (!restart) {
+            return deleted;
+        }
+    }
+}
+
+bool ART::ConcurrentLookup(const ARTKey& key, Value& value) const {
+    D_ASSERT(concurrent);
+    EpochGuard guard(*epochs);
+    while (true) {
+        bool restart = false;
+        auto found = TryLookup(key, value, restart);
+        if (!restart) {
+            return found;
+        }
+    }
+}
+
+bool ART::TryInsert(const ARTKey& key, const Node& leaf, bool& restart) {
+    // the slot is the child pointer of the parent (or the root pointer), which the parent
+    // version guards
+    auto parent_version = &root_version;
+    auto pv = OptimisticLock::ReadLockOrRestart(*parent_version, restart);
+    if (restart) {
+        return false;
+    }
+    auto slot = root.get();
+    // the node that holds the slot, Node() for the root pointer
+    Node parent;
+    idx_t depth = 0;
+
+    while (true) {
+        auto node = *slot;
+        OptimisticLock::CheckOrRestart(*parent_version, pv, restart);
+        if (restart) {
+            return false;
+        }
+
+        if (node.IsCleared() || node.getTag() == NType::NODE_DUMMY) {
+            // empty tree
+            OptimisticLock::UpgradeToWriteLockOrRestart(*parent_version, pv, restart);
+            if (restart) {
+                return false;
+            }
+            MarkParent(*this, parent);
+            SetLeafPrefix(leaf, key, depth);
+            *slot = leaf;
+            OptimisticLock::WriteUnlock(*parent_version);
+            return true;
+        }
+
+        if (node.getTag() == NType::LEAF) {
+            idx_t count;
+            auto& old_leaf = *GetAllocator(NType::LEAF).Get<const Leaf>(node);
+            auto mismatch = ComparePrefix(*this, node, key, depth, count);
+            if (mismatch == INVALID_INDEX ? depth + count != key.len : depth + mismatch >= key.len) {
+                throw InternalException("ConcurrentInsert does not support keys that are a prefix of another key.");
+            }
+
+            OptimisticLock::UpgradeToWriteLockOrRestart(*parent_version, pv, restart);
+            if (restart) {
+                return false;
+            }
+            MarkParent(*this, parent);
+            if (mismatch == INVALID_INDEX) {
+                // the key exists, replace the leaf
+                SetLeafPrefix(leaf, key, depth);
+                *slot = leaf;
+                OptimisticLock::WriteUnlock(*parent_version);
+                Leaf::Free(*this, node);
+                return false;
+            }
+
+            // split the leaf into a Node4 with the common prefix, and a copy of the old leaf
+            // with the remaining bytes of the old key
+            auto old_key = GatherPrefix(*this, node, key, depth, count);
+            Node node4;
+            auto& n4 = Node4::New(*this, node4);
+            Prefix::New(*this, n4.inline_prefix, n4.prefix, key, depth, mismatch);
+
+            Node leaf_copy;
+            auto& copy = Leaf::New(*this, leaf_copy, old_leaf.value);
+            reference<Node> copy_prefix(copy.prefix);
+            auto copy_depth = depth + mismatch + 1;
+            Prefix::New(*this, copy_prefix, old_key, copy_depth, old_key.len - copy_depth);
+            SetLeafPrefix(leaf, key, copy_depth);
+
+            Node4::InsertChild(*this, node4, old_key[depth + mismatch], leaf_copy);
+            Node4::InsertChild(*this, node4, key[depth + mismatch], leaf);
+            *slot = node4;
+            OptimisticLock::WriteUnlock(*parent_version);
+            Leaf::Free(*this, node);
+            return true;
+        }
+
+        auto& version = GetVersion(node);
+        auto v = OptimisticLock::ReadLockOrRestart(version, restart);
+        if (restart) {
+            return false;
+        }
+        // the node might have moved below a new node since we read it from the slot
+        OptimisticLock::CheckOrRestart(*parent_version, pv, restart);
+        if (restart) {
+            return false;
+        }
+
+        idx_t count;
+        auto mismatch = ComparePrefix(*this, node, key, depth, count);
+        OptimisticLock::CheckOrRestart(version, v, restart);
+        if (restart) {
+            return false;
+        }
+
+        if (mismatch != INVALID_INDEX) {
+            if (depth + mismatch >= key.len) {
+                throw InternalException("ConcurrentInsert does not support keys that are a prefix of another key.");
+            }
+            OptimisticLock::UpgradeToWriteLockOrRestart(*parent_version, pv, restart);
+            if (restart) {
+                return false;
+            }
+            MarkParent(*this, parent);
+            OptimisticLock::UpgradeToWriteLockOrRestart(version, v, restart);
+            if (restart) {
+                OptimisticLock::WriteUnlock(*parent_version);
+                return false;
+            }
+
+            // split the prefix: a new Node4 with the common prefix takes the place of the
+            // node, and the node keeps the prefix bytes behind the mismatch
+            Node node4;
+            auto& n4 = Node4::New(*this, node4);
+            Prefix::New(*this, n4.inline_prefix, n4.prefix, key, depth, mismatch);
+
+            auto prefix_key = GatherPrefix(*this, node, key, 0, count);
+            auto old_prefix = GetPrefixMutable(node);
+            auto& inlined = GetInlinePrefixMutable(node);
+            GetPrefixMutable(node) = Node();
+            inlined.count = 0;
+            Prefix::New(*this, inlined, GetPrefixMutable(node), prefix_key, mismatch + 1, count - mismatch - 1);
+            Prefix::Free(*this, old_prefix);
+            SetLeafPrefix(leaf, key, depth + mismatch + 1);
+
+            Node4::InsertChild(*this, node4, prefix_key[mismatch], node);
+            Node4::InsertChild(*this, node4, key[depth + mismatch], leaf);
+            *slot = node4;
+            OptimisticLock::WriteUnlock(version);
+            OptimisticLock::WriteUnlock(*parent_version);
+            return true;
+        }
+
+        depth += count;
+        if (depth >= key.len) {
+            throw InternalException("ConcurrentInsert does not support keys that are a prefix of another key.");
+        }
+        auto child_slot = GetChildSlot(*this, node, key[depth]);
+        auto full = IsFull(node.getTag(), GetCount(*this, node));
+        OptimisticLock::CheckOrRestart(version, v, restart);
+        if (restart) {
+            return false;
+        }
+
+        if (child_slot) {
+            parent_version = &version;
+            parent = node;
+            pv = v;
+            slot = child_slot;
+            depth++;
+            continue;
+        }
+
+        if (!full) {
+            // the node stays in place, so its own lock suffices
+            OptimisticLock::UpgradeToWriteLockOrRestart(version, v, restart);
+            if (restart) {
+                return false;
+            }
+            SetLeafPrefix(leaf, key, depth + 1);
+            auto local = node;
+            Node::InsertChild(*this, local, key[depth], leaf);
+            D_ASSERT(local.SameSlot(node));
+            OptimisticLock::WriteUnlock(version);
+            return true;
+        }
+
+        // the node grows into a new node, which replaces it in the parent
+        OptimisticLock::UpgradeToWriteLockOrRestart(*parent_version, pv, restart);
+        if (restart) {
+            return false;
+        }
+        MarkParent(*this, parent);
+        OptimisticLock::UpgradeToWriteLockOrRestart(version, v, restart);
+        if (restart) {
+            OptimisticLock::WriteUnlock(*parent_version);
+            return false;
+        }
+        SetLeafPrefix(leaf, key, depth + 1);
+        Node::InsertChild(*this, *slot, key[depth], leaf);
+        OptimisticLock::WriteUnlockObsolete(version);
+        OptimisticLock::WriteUnlock(*parent_version);
+        return true;
+    }
+}
+
+bool ART::TryDelete(const ARTKey& key, bool& restart) {
+    auto parent_version = &root_version;
+    auto pv = OptimisticLock::ReadLockOrRestart(*parent_version, restart);
+    if (restart) {
+        return false;
+    }
+    auto slot = root.get();
+    // the node that holds the slot, Node() for the root pointer
+    Node parent;
+    idx_t depth = 0;
+
+    while (true) {
+        auto node = *slot;
+        OptimisticLock::CheckOrRestart(*parent_version, pv, restart);
+        if (restart) {
+            return false;
+        }
+
+        if (node.IsCleared() || node.getTag() == NType::NODE_DUMMY) {
+            return false;
+        }
+
+        if (node.getTag() == NType::LEAF) {
+            // only the root can be a leaf here, we check the leaf children from their parent
+            if (!LeafMatches(*this, node, key, depth)) {
+                return false;
+            }
+            OptimisticLock::UpgradeToWriteLockOrRestart(*parent_version, pv, restart);
+            if (restart) {
+                return false;
+            }
+            MarkParent(*this, parent);
+            *slot = Node{};
+            OptimisticLock::WriteUnlock(*parent_version);
+            Leaf::Free(*this, node);
+            return true;
+        }
+
+        auto& version = GetVersion(node);
+        auto v = OptimisticLock::ReadLockOrRestart(version, restart);
+        if (restart) {
+            return false;
+        }
+        OptimisticLock::CheckOrRestart(*parent_version, pv, restart);
+        if (restart) {
+            return false;
+        }
+
+        idx_t count;
+        auto mismatch = ComparePrefix(*this, node, key, depth, count);
+        OptimisticLock::CheckOrRestart(version, v, restart);
+        if (restart) {
+            return false;
+        }
+        if (mismatch != INVALID_INDEX || depth + count >= key.len) {
+            return false;
+        }
+
+        depth += count;
+        auto byte = key[depth];
+        auto child_slot = GetChildSlot(*this, node, byte);
+        auto child = child_slot ? *child_slot : Node{};
+        auto underfull = IsUnderfull(node.getTag(), GetCount(*this, node));
+        OptimisticLock::CheckOrRestart(version, v, restart);
+        if (restart) {
+            return false;
+        }
+
+        if (!child_slot) {
+            return false;
+        }
+        if (child.getTag() != NType::LEAF) {
+            parent_version = &version;
+            parent = node;
+            pv = v;
+            slot = child_slot;
+            depth++;
+            continue;
+        }
+        if (!LeafMatches(*this, child, key, depth + 1)) {
+            return false;
+        }
+
+        if (!underfull) {
+            // the node stays in place, so its own lock suffices
+            OptimisticLock::UpgradeToWriteLockOrRestart(version, v, restart);
+            if (restart) {
+                return false;
+            }
+            auto local = node;
+            Node::DeleteChild(*this, local, byte);
+            D_ASSERT(local.SameSlot(node));
+            OptimisticLock::WriteUnlock(version);
+            return true;
+        }
+
+        OptimisticLock::UpgradeToWriteLockOrRestart(*parent_version, pv, restart);
+        if (restart) {
+            return false;
+        }
+        MarkParent(*this, parent);
+        OptimisticLock::UpgradeToWriteLockOrRestart(version, v, restart);
+        if (restart) {
+            OptimisticLock::WriteUnlock(*parent_version);
+            return false;
+        }
+
+        if (node.getTag() != NType::NODE_4) {
+            // shrink the node, which replaces it in the parent
+            Node::DeleteChild(*this, *slot, byte);
+            D_ASSERT(!slot->SameSlot(node));
+            OptimisticLock::WriteUnlockObsolete(version);
+            OptimisticLock::WriteUnlock(*parent_version);
+            return true;
+        }
+
+        // compress the Node4 into its remaining child, which then holds the prefix of the
+        // Node4, the byte of the child and its own prefix
+        auto& n4 = Node::RefMutable<Node4>(*this, node, NType::NODE_4);
+        D_ASSERT(n4.count == 2);
+        auto other = n4.key[0] == byte ? 1 : 0;
+        auto remaining = n4.children[other];
+        auto remaining_byte = n4.key[other];
+
+        idx_t n4_count, remaining_count;
+        ComparePrefix(*this, node, key, 0, n4_count);
+        ComparePrefix(*this, remaining, key, 0, remaining_count);
+
+        ARTKey bytes(static_cast<uint32_t>(n4_count + 1 + remaining_count));
+        auto head = GatherPrefix(*this, node, key, 0, n4_count);
+        auto tail = GatherPrefix(*this, remaining, key, 0, remaining_count);
+        std::memcpy(bytes.data, head.data, n4_count);
+        bytes.data[n4_count] = remaining_byte;
+        std::memcpy(bytes.data + n4_count + 1, tail.data, remaining_count);
+
+        if (remaining.getTag() == NType::LEAF) {
+            // leaves are immutable, so the remaining leaf is replaced by a copy
+            Node leaf_copy;
+            auto& copy = Leaf::New(*this, leaf_copy, GetAllocator(NType::LEAF).Get<const Leaf>(remaining)->value);
+            reference<Node> copy_prefix(copy.prefix);
+            Prefix::New(*this, copy_prefix, bytes, 0, bytes.len);
+            *slot = leaf_copy;
+            Leaf::Free(*this, remaining);
+        } else {
+            auto& child_version = GetVersion(remaining);
+            auto cv = OptimisticLock::ReadLockOrRestart(child_version, restart);
+            if (!restart) {
+                OptimisticLock::UpgradeToWriteLockOrRestart(child_version, cv, restart);
+            }
+            if (restart) {
+                OptimisticLock::WriteUnlock(version);
+                OptimisticLock::WriteUnlock(*parent_version);
+                return false;
+            }
+            auto old_prefix = GetPrefixMutable(remaining);
+            auto& inlined = GetInlinePrefixMutable(remaining);
+            GetPrefixMutable(remaining) = Node();
+            inlined.count = 0;
+            Prefix::New(*this, inlined, GetPrefixMutable(remaining), bytes, 0, bytes.len);
+            Prefix::Free(*this, old_prefix);
+            OptimisticLock::WriteUnlock(child_version);
+            *slot = remaining;
+        }
+
+        // free the deleted leaf, the prefix of the Node4 and the Node4 itself
+        Leaf::Free(*this, n4.children[1 - other]);
+        Prefix::Free(*this, n4.prefix);
+        n4.count = 0;
+        Node::Free(*this, node);
+        OptimisticLock::WriteUnlockObsolete(version);
+        OptimisticLock::WriteUnlock(*parent_version);
+        return true;
+    }
+}
+
+bool ART::TryLookup(const ARTKey& key, Value& value, bool& restart) const {
+    auto parent_version = &root_version;
+    auto pv = OptimisticLock::ReadLockOrRestart(*parent_version, restart);
+    if (restart) {
+        return false;
+    }
+    const Node* slot = root.get();
+    idx_t depth = 0;
+
+    while (true) {
+        auto node = *slot;
+        OptimisticLock::CheckOrRestart(*parent_version, pv, restart);
+        if (restart) {
+            return false;
+        }
+
+        if (node.IsCleared() || node.getTag() == NType::NODE_DUMMY) {
+            return false;
+        }
+        if (node.getTag() == NType::LEAF) {
+            // the leaf does not change while it is reachable, and it is not freed before
+            // this thread leaves its epoch
+            if (!LeafMatches(*this, node, key, depth)) {
+                return false;
+            }
+            value = GetAllocator(NType::LEAF).Get<const Leaf>(node)->value;
+            return true;
+        }
+
+        auto& version = GetVersion(node);
+        auto v = OptimisticLock::ReadLockOrRestart(version, restart);
+        if (restart) {
+            return false;
+        }
+        OptimisticLock::CheckOrRestart(*parent_version, pv, restart);
+        if (restart) {
+            return false;
+        }
+
+        idx_t count;
+        auto mismatch = ComparePrefix(*this, node, key, depth, count);
+        const Node* child_slot = nullptr;
+        if (mismatch == INVALID_INDEX && depth + count < key.len) {
+            child_slot = GetChild(*this, node, key[depth + count]);
+        }
+        OptimisticLock::CheckOrRestart(version, v, restart);
+        if (restart || !child_slot) {
+            return false;
+        }
+
+        parent_version = &version;
+        pv = v;
+        slot = child_slot;
+        depth += count + 1;
+    }
+}
+
+}  // namespace duckart
@@ -4,29 +4,45 @@
 #include "artkey.hpp"
 #include "logger.hpp"
 #include "node.hpp"
+#include "simd.hpp"
 
 namespace duckart {
+
+//! Returns the number of prefix bytes in the chain at node
+static idx_t CountBytes(ART &art, Node node) {
+    idx_t count = 0;
+    while (node.getTag() == NType::PREFIX) {
+        auto &prefix = Node::Ref<const Prefix>(art, node, NType::PREFIX);
+        count += prefix.count;
+        node = prefix.ptr;
+    }
+    return count;
+}
+
 Prefix &Prefix::New(ART &art, Node &node) {
     LOG_DEBUG("new Prefix...");
-    node = Node::GetAllocator(art, NType::PREFIX).New();
-    D_ASSERT(node.getPointer() != nullptr);
-    node.setTag(NType::PREFIX);
+    return NewSegment(art, node, 0);
+}
+
+Prefix &Prefix::NewSegment(ART &art, Node &node, idx_t count) {
+    uint8_t size_class = 0;
+    while (size_class + 1 < PREFIX_SEGMENT_CLASSES && Capacity(size_class) < count) {
+        size_class++;
+    }
+    node = art.GetPrefixAllocator(size_class).New(NType::PREFIX);
     LOG_DEBUG("new perfix," + node.AddrToString());
 
     auto &prefix = Node::RefMutable<Prefix>(art, node, NType::PREFIX);
-
-    prefix.data[PREFIX_SIZE] = 0;
+    prefix.count = 0;
+    prefix.size_class = size_class;
     prefix.ptr = Node{};
     return prefix;
 }
 
 Prefix &Prefix::New(ART &art, Node &node, uint8_t byte, const Node &next) {
     LOG_DEBUG("new Prefix with one byte...");
-    node = Node::GetAllocator(art, NType::PREFIX).New();
-    node.setTag(NType::PREFIX);
-
-    auto &prefix = Node::RefMutable<Prefix>(art, node, NType::PREFIX);
-    prefix.data[PREFIX_SIZE] = 1;
+    auto &prefix = NewSegment(art, node, 1);
+    prefix.count = 1;
     prefix.data[0] = byte;
     prefix.ptr = next;
     return prefix;
@@ -44,16 +60,12 @@ void Prefix::New(ART &art, reference<Node> &node, const ARTKey &key,
     reference<Node> firstNode = node;
 
     while (count > 0) {
-        node.get() = Node::GetAllocator(art, NType::PREFIX).New();
-        D_ASSERT(node.get().getPointer() != nullptr);
-        node.get().setTag(NType::PREFIX);
+        // the segment ends in a DUMMY Node
+        auto &prefix = NewSegment(art, node, count);
         LOG_DEBUG("new Prefix by a ARTKey," + node.get().AddrToString());
-        auto &prefix = Node::RefMutable<Prefix>(art, node, NType::PREFIX);
-        // set ptr to DUMMY Node
-        prefix.ptr = Node{};
 
-        auto this_count = MinValue((uint32_t)PREFIX_SIZE, count);
-        prefix.data[PREFIX_SIZE] = (uint8_t)this_count;
+        auto this_count = MinValue(static_cast<uint32_t>(prefix.Capacity()), count);
+        prefix.count = static_cast<uint8_t>(this_count);
         std::memcpy(prefix.data, key.data + depth + copy_count, this_count);
 
         copy_count += this_count;
@@ -76,11 +88,12 @@ void Prefix::Free(ART &art, Node &node) {
            current_node.getTag() == NType::PREFIX) {
         LOG_DEBUG("free Prefix," + current_node.AddrToString());
         next_node =  Node::RefMutable<Prefix>(art, current_node, NType::PREFIX).ptr;
-        Node::GetAllocator(art, NType::PREFIX).Free(current_node.getPointer());
+        Node::FreeSlot(art, current_node);
         current_node = next_node;
     }
 
-    //Node::Free(art, current_node);
+    // the chain ahead of an inlined leaf or a row id set ends in it
+    Node::Free(art, current_node);
     node.Clear();
 }
 
@@ -92,8 +105,8 @@ void Prefix::Print(const ART &art, const Node &node) {
     std::cout << "Prefix chain: ";
 
     while (current.getTag() == NType::PREFIX) {
-        auto &prefix = Node::RefMutable<Prefix>(art, current, NType::PREFIX);
-        uint8_t count = prefix.data[PREFIX_SIZE];
+        auto &prefix = Node::Ref<const Prefix>(art, current, NType::PREFIX);
+        uint8_t count = prefix.count;
 
         std::cout << "[ ";
         for (uint8_t i = 0; i < count; ++i) {
@@ -112,8 +125,8 @@ std::string Prefix::ToString(const ART &art, const Node &node) {
 
     auto current = node;
     while (current.getTag() == NType::PREFIX) {
-        auto &prefix = Node::RefMutable<Prefix>(art, current, NType::PREFIX);
-        uint8_t count = prefix.data[PREFIX_SIZE];
+        auto &prefix = Node::Ref<const Prefix>(art, current, NType::PREFIX);
+        uint8_t count = prefix.count;
 
         ss << "[ ";
         for (uint8_t i = 0; i < count; ++i) {
@@ -128,18 +141,17 @@ std::string Prefix::ToString(const ART &art, const Node &node) {
 }
 
 // Function to check if two chains of Prefix match
-bool Prefix::Match(ART &art, reference<Node> node1, reference<Node> node2) {
+bool Prefix::Match(const ART &art, reference<const Node> node1, reference<const Node> node2) {
     while (node1.get().getTag() == NType::PREFIX &&
            node2.get().getTag() == NType::PREFIX) {
-        auto &prefix1 = Node::RefMutable<Prefix>(art, node1, NType::PREFIX);
-        auto &prefix2 = Node::RefMutable<Prefix>(art, node2, NType::PREFIX);
+        auto &prefix1 = Node::Ref<const Prefix>(art, node1, NType::PREFIX);
+        auto &prefix2 = Node::Ref<const Prefix>(art, node2, NType::PREFIX);
 
-        if (prefix1.data[PREFIX_SIZE] != prefix2.data[PREFIX_SIZE]) {
+        if (prefix1.count != prefix2.count) {
             return false;
         }
 
-        if (std::memcmp(prefix1.data, prefix2.data,
-                        prefix1.data[PREFIX_SIZE]) != 0) {
+        if (std::memcmp(prefix1.data, prefix2.data, prefix1.count) != 0) {
             return false;
         }
 
@@ -156,12 +168,12 @@ Prefix &Prefix::Append(ART &art, const uint8_t byte) {
     reference<Prefix> prefix(*this);
 
     // if this prefix node is full ,we need a new prefix node
-    if (prefix.get().data[PREFIX_SIZE] == PREFIX_SIZE) {
+    if (prefix.get().count == prefix.get().Capacity()) {
         prefix = New(art, prefix.get().ptr);
     }
 
-    prefix.get().data[prefix.get().data[PREFIX_SIZE]] = byte;
-    prefix.get().data[PREFIX_SIZE]++;
+    prefix.get().data[prefix.get().count] = byte;
+    prefix.get().count++;
     return prefix.get();
 }
 
@@ -169,23 +181,33 @@ void Prefix::Append(ART &art, Node other_prefix) {
     LOG_DEBUG("Prefix Append...");
     D_ASSERT(!other_prefix.IsCleared());
 
+    // once this segment is full, the next one takes all bytes that are left
+    auto remaining = CountBytes(art, other_prefix);
     reference<Prefix> prefix(*this);
     while (other_prefix.getTag() == NType::PREFIX) {
         // copy prefix bytes
         auto &other =
             Node::RefMutable<Prefix>(art, other_prefix, NType::PREFIX);
-        for (idx_t i = 0; i < other.data[PREFIX_SIZE]; i++) {
-            prefix = prefix.get().Append(art, other.data[i]);          
+        for (idx_t copied = 0; copied < other.count;) {
+            if (prefix.get().count == prefix.get().Capacity()) {
+                prefix = NewSegment(art, prefix.get().ptr, remaining);
+            }
+            auto this_count = MinValue<idx_t>(prefix.get().Capacity() - prefix.get().count, other.count - copied);
+            std::memcpy(prefix.get().data + prefix.get().count, other.data + copied, this_count);
+            prefix.get().count += static_cast<uint8_t>(this_count);
+            copied += this_count;
+            remaining -= this_count;
         }
 
         D_ASSERT(!other.ptr.IsCleared());
 
-        // prefix.get().ptr = other.ptr;
         auto temp_prefix = other.ptr;
-        Node::GetAllocator(art, NType::PREFIX).Free(other_prefix.getPointer());
+        Node::FreeSlot(art, other_prefix);
         other_prefix = temp_prefix;
     }
 
+    // the chain ends in Node{}, or in the inlined leaf behind it
+    prefix.get().ptr = other_prefix;
     D_ASSERT(prefix.get().ptr.getTag() != NType::PREFIX);
 }
 
@@ -194,17 +216,17 @@ void Prefix::Split(ART &art, reference<Node> &prefix_node, Node &child_node,
     LOG_DEBUG("Prefix::Split,node type:" +
               std::to_string(static_cast<int>(prefix_node.get().getTag())));
 
-    D_ASSERT(position < PREFIX_SIZE);
     D_ASSERT(!prefix_node.get().IsCleared());
     D_ASSERT(prefix_node.get().getTag() != NType::NODE_DUMMY);
 
     auto &prefix = Node::RefMutable<Prefix>(art, prefix_node, NType::PREFIX);
+    D_ASSERT(position < prefix.count);
 
     // the split is at the last byte of this prefix, so the child_node contains
     // all subsequent prefix nodes (prefix.ptr) (if any), and the count of this
     // prefix decreases by one, then, set prefix.ptr to a DUMMY Node
-    if (position + 1 == PREFIX_SIZE) {
-        prefix.data[PREFIX_SIZE]--;
+    if (position + 1 == prefix.Capacity()) {
+        prefix.count--;
         child_node = prefix.ptr;
         prefix.ptr = Node{};
         return;
@@ -212,37 +234,40 @@ void Prefix::Split(ART &art, reference<Node> &prefix_node, Node &child_node,
 
     // Save the reference to the first prefix node
     reference<Node> firstNode = prefix_node;
-    reference<Prefix> child_prefix = New(art, child_node);
 
     // append the remaining bytes after the split
-    if (position + 1 < prefix.data[PREFIX_SIZE]) {       
-        for (idx_t i = position + 1; i < prefix.data[PREFIX_SIZE]; i++) {
-            child_prefix = child_prefix.get().Append(art, prefix.data[i]);
-        }
+    if (position + 1 < prefix.count) {
+        // one segment for the remaining bytes of this node and of the rest of the chain
+        idx_t count = prefix.count - position - 1;
+        auto &child_prefix = NewSegment(art, child_node, count + CountBytes(art, prefix.ptr));
+        std::memcpy(child_prefix.data, prefix.data + position + 1, count);
+        child_prefix.count = static_cast<uint8_t>(count);
 
         D_ASSERT(!prefix.ptr.IsCleared());
 
         if (prefix.ptr.getTag() == NType::PREFIX) {
-            child_prefix.get().Append(art, prefix.ptr);
+            child_prefix.Append(art, prefix.ptr);
         } else {
             // this is the last prefix node of the prefix chain
-            child_prefix.get().ptr = prefix.ptr;           
+            child_prefix.ptr = prefix.ptr;
         }
     }
 
     // this is the last byte of the prefix 
-    if (position + 1 == prefix.data[PREFIX_SIZE]) {
+    if (position + 1 == prefix.count) {
         child_node = prefix.ptr;
     }
 
     // set the new size of this node
-    prefix.data[PREFIX_SIZE] = static_cast<uint8_t>(position);
+    prefix.count = static_cast<uint8_t>(position);
 
     // if split at first byte ,free the prefix
     if (position == 0) {
         LOG_DEBUG("split at first byte,current:" + prefix_node.get().AddrToString() +",next:" + prefix.ptr.AddrToString() );
       
-        //prefix.ptr.Clear();
+        // the subsequent nodes are either owned by child_node now or were freed by
+        // Append, so only free this prefix node
+        prefix.ptr = Node{};
         Node::Free(art, prefix_node.get());
         prefix_node.get() = Node{};
         return;
@@ -254,15 +279,31 @@ void Prefix::Split(ART &art, reference<Node> &prefix_node, Node &child_node,
     return;
 }
 
+void Prefix::Trim(ART &art, Node &prefix_node, idx_t count) {
+    while (count > 0) {
+        D_ASSERT(prefix_node.getTag() == NType::PREFIX);
+        auto &prefix = Node::RefMutable<Prefix>(art, prefix_node, NType::PREFIX);
+        if (count < prefix.count) {
+            prefix.count -= static_cast<uint8_t>(count);
+            std::memmove(prefix.data, prefix.data + count, prefix.count);
+            return;
+        }
+        count -= prefix.count;
+        auto next = prefix.ptr;
+        Node::FreeSlot(art, prefix_node);
+        prefix_node = next;
+    }
+}
+
 void Prefix::Reduce(ART &art, Node &prefix_node, const idx_t n) {
     D_ASSERT(!prefix_node.IsCleared());
-    D_ASSERT(n < PREFIX_SIZE);
 
     reference<Prefix> prefix =
         Node::RefMutable<Prefix>(art, prefix_node, NType::PREFIX);
+    D_ASSERT(n < prefix.get().count);
 
     // free this prefix node
-    if (n == (idx_t)(prefix.get().data[PREFIX_SIZE] - 1)) {
+    if (n == (idx_t)(prefix.get().count - 1)) {
         auto next_ptr = prefix.get().ptr;
         D_ASSERT(!next_ptr.IsCleared());
         prefix.get().ptr.Clear();
@@ -272,11 +313,9 @@ void Prefix::Reduce(ART &art, Node &prefix_node, const idx_t n) {
     }
 
     // shift by n bytes in the current prefix
-    for (idx_t i = 0; i < PREFIX_SIZE - n - 1; i++) {
-        prefix.get().data[i] = prefix.get().data[n + i + 1];
-    }
-    D_ASSERT(n < (idx_t)(prefix.get().data[PREFIX_SIZE] - 1));
-    prefix.get().data[PREFIX_SIZE] -= n + 1;
+    D_ASSERT(n < (idx_t)(prefix.get().count - 1));
+    prefix.get().count -= n + 1;
+    std::memmove(prefix.get().data, prefix.get().data + n + 1, prefix.get().count);
 
     // append the remaining prefix bytes
     prefix.get().Append(art, prefix.get().ptr);
@@ -317,7 +356,9 @@ void Prefix::Concatenate(ART &art, Node &prefix_node, const uint8_t byte,
     if (prefix_node.getTag() != NType::PREFIX &&
         child_prefix_node.getTag() == NType::PREFIX) {
         auto child_prefix = child_prefix_node;
-        auto &prefix = New(art, prefix_node, byte);
+        auto &prefix = NewSegment(art, prefix_node, 1 + CountBytes(art, child_prefix));
+        prefix.data[0] = byte;
+        prefix.count = 1;
         prefix.Append(art, child_prefix);
         return;
     }
@@ -327,29 +368,55 @@ void Prefix::Concatenate(ART &art, Node &prefix_node, const uint8_t byte,
     New(art, prefix_node, byte, child_prefix_node);
 }
 
+// Compares the prefix chain at prefix_node with the key, without writing to it. Returns the
+// position of the first mismatch within a segment, then prefix_node is the segment and
+// previous the segment ahead of it, or INVALID_INDEX
+template <typename NODE>
+static idx_t TraverseChain(const ART &art, reference<NODE> &prefix_node, const ARTKey &key, idx_t &depth,
+                           Node &previous) {
+    // a leaf whose key is fully consumed has no prefix
+    D_ASSERT(!prefix_node.get().IsCleared());
+
+    auto &allocator = Node::GetAllocator(art, NType::PREFIX);
+    while (prefix_node.get().getTag() == NType::PREFIX) {
+        auto &prefix = *allocator.Get<Prefix>(prefix_node.get());
+        // a key that ends within the prefix mismatches at its end
+        auto count = MinValue<idx_t>(prefix.count, key.len - depth);
+        auto pos = FindMismatch(prefix.data, key.data + depth, count);
+        depth += pos;
+        if (pos < prefix.count) {
+            return pos;
+        }
+        previous = prefix_node.get();
+        prefix_node = prefix.ptr;
+        D_ASSERT(!prefix_node.get().IsCleared());
+    }
+    return INVALID_INDEX;
+}
+
 // depth : the mismatch position of ARTKey
 // prefix_node: the Prefix Node of Prefix chain where first mismatch
 // Returns the position of the first mismatch within a prefix node if found
 idx_t Prefix::TraverseMutable(ART &art, reference<Node> &prefix_node,
                               const ARTKey &key, idx_t &depth) {
-    D_ASSERT(!prefix_node.get().IsCleared()); 
-    D_ASSERT(prefix_node.get().getTag() == NType::PREFIX);
-
-    // compare prefix nodes to key bytes
-    while (prefix_node.get().getTag() == NType::PREFIX) {
-        auto &prefix =
-            Node::RefMutable<Prefix>(art, prefix_node, NType::PREFIX);
-        for (idx_t i = 0; i < prefix.data[PREFIX_SIZE]; i++) {
-            if (prefix.data[i] != key[depth]) {
-                return i;
-            }
-            depth++;
+    // the segments are only read unless they mismatch
+    Node previous;
+    auto pos = TraverseChain(art, prefix_node, key, depth, previous);
+    if (pos != INVALID_INDEX) {
+        // the caller splits the chain at the segment, and might replace the pointer to it in
+        // the previous segment
+        auto &allocator = Node::GetAllocator(art, NType::PREFIX);
+        allocator.MarkDirty(prefix_node.get());
+        if (previous.getTag() == NType::PREFIX) {
+            allocator.MarkDirty(previous);
         }
-        prefix_node = prefix.ptr;
-        D_ASSERT(!prefix_node.get().IsCleared());
     }
+    return pos;
+}
 
-    return INVALID_INDEX;
+idx_t Prefix::Traverse(const ART &art, reference<const Node> &prefix_node, const ARTKey &key, idx_t &depth) {
+    Node previous;
+    return TraverseChain(art, prefix_node, key, depth, previous);
 }
 
 //! differ two Prefixe Nodes to find (1) that they match (so far), or (2) that
@@ -360,18 +427,15 @@ bool Prefix::Mismatch(ART &art, reference<Node> &l_node,
     auto &r_prefix = Node::RefMutable<Prefix>(art, r_node.get(), NType::PREFIX);
 
     // compare prefix bytes
-    idx_t max_count =
-        MinValue(l_prefix.data[PREFIX_SIZE], r_prefix.data[PREFIX_SIZE]);
-    for (idx_t i = 0; i < max_count; i++) {
-        if (l_prefix.data[i] != r_prefix.data[i]) {
-            mismatch_position = i;
-            break;
-        }
+    idx_t max_count = MinValue(l_prefix.count, r_prefix.count);
+    auto pos = FindMismatch(l_prefix.data, r_prefix.data, max_count);
+    if (pos < max_count) {
+        mismatch_position = pos;
     }
 
     if (mismatch_position == INVALID_INDEX) {
         // prefixes match (so far)
-        if (l_prefix.data[PREFIX_SIZE] == r_prefix.data[PREFIX_SIZE]) {
+        if (l_prefix.count == r_prefix.count) {
             return true;  // both Prefix Node
         } else {
             mismatch_position = max_count;
@@ -382,10 +446,91 @@ bool Prefix::Mismatch(ART &art, reference<Node> &l_node,
     return false;
 }
 
+void Prefix::New(ART &art, InlinePrefix &inlined, Node &node, const ARTKey &key, const uint32_t depth,
+                 uint32_t count) {
+    D_ASSERT(inlined.count == 0 && node.getTag() != NType::PREFIX);
+    if (count <= INLINE_PREFIX_SIZE) {
+        std::memcpy(inlined.data, key.data + depth, count);
+        inlined.count = static_cast<uint8_t>(count);
+        return;
+    }
+    reference<Node> ref_node(node);
+    New(art, ref_node, key, depth, count);
+}
+
+void Prefix::Pack(ART &art, InlinePrefix &inlined, Node &node) {
+    D_ASSERT(inlined.count == 0);
+
+    // the chain might have partially filled prefix nodes, so count its bytes first
+    idx_t count = 0;
+    for (auto current = node; current.getTag() == NType::PREFIX;) {
+        auto &prefix = Node::Ref<const Prefix>(art, current, NType::PREFIX);
+        count += prefix.count;
+        if (count > INLINE_PREFIX_SIZE) {
+            return;
+        }
+        current = prefix.ptr;
+    }
+
+    while (node.getTag() == NType::PREFIX) {
+        auto &prefix = Node::RefMutable<Prefix>(art, node, NType::PREFIX);
+        std::memcpy(inlined.data + inlined.count, prefix.data, prefix.count);
+        inlined.count += prefix.count;
+        auto next = prefix.ptr;
+        Node::FreeSlot(art, node);
+        node = next;
+    }
+    // the chain of an inner node ends in Node{}
+    D_ASSERT(node.getTag() == NType::NODE_DUMMY);
+}
+
+void Prefix::Unpack(ART &art, InlinePrefix &inlined, Node &node) {
+    if (inlined.count == 0) {
+        return;
+    }
+    D_ASSERT(node.getTag() != NType::PREFIX);
+    auto &prefix = New(art, node);
+    std::memcpy(prefix.data, inlined.data, inlined.count);
+    prefix.count = inlined.count;
+    inlined.count = 0;
+}
+
+idx_t Prefix::Traverse(const InlinePrefix &inlined, const ARTKey &key, idx_t &depth) {
+    for (idx_t i = 0; i < inlined.count; i++) {
+        if (depth >= key.len || inlined.data[i] != key[depth]) {
+            return i;
+        }
+        depth++;
+    }
+    return INVALID_INDEX;
+}
+
+void Prefix::Split(InlinePrefix &inlined, InlinePrefix &head, idx_t position) {
+    D_ASSERT(position < inlined.count);
+    std::memcpy(head.data, inlined.data, position);
+    head.count = static_cast<uint8_t>(position);
+
+    // the byte at position becomes the key byte of the node in its new parent
+    inlined.count -= static_cast<uint8_t>(position + 1);
+    std::memmove(inlined.data, inlined.data + position + 1, inlined.count);
+}
+
+std::string Prefix::ToString(const ART &art, const InlinePrefix &inlined, const Node &node) {
+    if (inlined.count == 0) {
+        return ToString(art, node);
+    }
+    std::stringstream ss;
+    ss << "[ ";
+    for (uint8_t i = 0; i < inlined.count; ++i) {
+        ss << static_cast<char>(inlined.data[i]);
+    }
+    ss << " ] ";
+    return ss.str();
+}
+
  uint8_t Prefix::GetByte(const ART &art, const Node &prefix_node, const idx_t position) {
 		auto &prefix = Node::Ref<const Prefix>(art, prefix_node, NType::PREFIX);
-		D_ASSERT(position <  PREFIX_SIZE);
-		D_ASSERT(position < prefix.data[PREFIX_SIZE]);
+		D_ASSERT(position < prefix.count);
 		return prefix.data[position];
 	}
 
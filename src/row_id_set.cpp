@@ -0,0 +1,308 @@
+#include <algorithm>
+#include <vector>
+
+#include "art.hpp"
+#include "exception.hpp"
+#include "iterator.hpp"
+#include "leaf.hpp"
+#include "node.hpp"
+#include "prefix.hpp"
+#include "value_arena.hpp"
+
+namespace duckart {
+
+// Row id sets of non-unique keys, following the nested ART of DuckDB v1.1. The leaf of a key
+// with a single row id is an inlined leaf. More row ids become a row id set, a node with the
+// gate bit at the place of the inlined leaf, i.e., behind the prefix chain of the key bytes:
+// - up to ART::ROW_ID_ARRAY_CAPACITY row ids: a Leaf slot whose value holds the sorted row
+//   ids, which grows and shrinks in place within its size class of the value arena
+// - more row ids: the root of a nested ART over the row ids, as 8-byte keys with inlined
+//   leaves, in which Insert, Delete and Search work as in the tree itself
+// A nested tree shrinks back into an array once it holds ROW_ID_ARRAY_CAPACITY / 2 row ids,
+// so that a key that hovers around the capacity does not convert on every operation.
+
+//! Returns the row ids of the array of a row id set
+static idx_t* GetRowIdArray(const Leaf& leaf, idx_t& count) {
+    count = leaf.value.GetSize() / sizeof(idx_t);
+    return reinterpret_cast<idx_t*>(const_cast<data_ptr_t>(leaf.value.GetData()));
+}
+
+//! Calls callback for the inlined leaves of the nested tree at node in key order, returns
+//! false if callback stopped the scan
+static bool ScanNested(const ART& art, const Node& node, const std::function<bool(idx_t)>& callback,
+                       idx_t& count) {
+    switch (node.getTag()) {
+        case NType::LEAF_INLINED:
+            count++;
+            return callback(Leaf::GetRowId(node));
+        case NType::PREFIX: {
+            // the prefix chain ahead of an inlined leaf
+            auto tail = node;
+            while (tail.getTag() == NType::PREFIX) {
+                tail = Node::Ref<const Prefix>(art, tail, NType::PREFIX).ptr;
+            }
+            return ScanNested(art, tail, callback, count);
+        }
+        default: {
+            uint8_t byte = 0;
+            auto child = node.GetNextChild(art, byte);
+            while (child) {
+                if (!ScanNested(art, *child, callback, count)) {
+                    return false;
+                }
+                if (byte == NODE_256_CAPACITY - 1) {
+                    break;
+                }
+                byte++;
+                child = node.GetNextChild(art, byte);
+            }
+            return true;
+        }
+    }
+}
+
+bool ART::AddRowId(const ARTKey& key, const idx_t row_id) {
+    CheckWritable();
+    auto slot = LookupLeafMutable(key);
+    if (!slot) {
+        Node leaf;
+        Leaf::NewInlined(*this, leaf, row_id);
+        return Insert(*root, key, leaf, 0);
+    }
+
+    auto& leaf = *slot;
+    if (Leaf::HasValue(leaf)) {
+        throw InternalException("The key has a value, not row ids.");
+    }
+
+    // a second row id turns the inlined leaf into an array
+    if (!leaf.IsGate()) {
+        auto existing = Leaf::GetRowId(leaf);
+        if (existing == row_id) {
+            return false;
+        }
+        idx_t row_ids[2] = {MinValue(existing, row_id), MaxValue(existing, row_id)};
+        NewRowIdSet(leaf, row_ids, 2);
+        return true;
+    }
+
+    if (leaf.getTag() == NType::LEAF) {
+        auto& array_leaf = Node::RefMutable<Leaf>(*this, leaf, NType::LEAF);
+        idx_t count;
+        auto row_ids = GetRowIdArray(array_leaf, count);
+        auto pos = static_cast<idx_t>(std::lower_bound(row_ids, row_ids + count, row_id) - row_ids);
+        if (pos < count && row_ids[pos] == row_id) {
+            return false;
+        }
+
+        if (count < ROW_ID_ARRAY_CAPACITY) {
+            // the resize might move the array, and updates count
+            value_arena->Resize(array_leaf.value, (count + 1) * sizeof(idx_t));
+            row_ids = GetRowIdArray(array_leaf, count);
+            std::memmove(row_ids + pos + 1, row_ids + pos, (count - 1 - pos) * sizeof(idx_t));
+            row_ids[pos] = row_id;
+            return true;
+        }
+
+        // the array is full, move its row ids into a nested tree
+        std::vector<idx_t> all(row_ids, row_ids + count);
+        all.insert(all.begin() + pos, row_id);
+        NewRowIdSet(leaf, all.data(), all.size());
+        return true;
+    }
+
+    // the nested tree is a regular tree behind the gate
+    Node nested = leaf;
+    nested.SetGate(false);
+    StackARTKey<idx_t> row_id_key(row_id);
+    if (Search(nested, row_id_key, 0).getTag() == NType::LEAF_INLINED) {
+        return false;
+    }
+    Node row_id_leaf;
+    Leaf::NewInlined(*this, row_id_leaf, row_id);
+    Insert(nested, row_id_key, row_id_leaf, 0);
+    nested.SetGate(true);
+    leaf = nested;
+    return true;
+}
+
+bool ART::RemoveRowId(const ARTKey& key, const idx_t row_id) {
+    CheckWritable();
+    auto slot = LookupLeafMutable(key);
+    if (!slot) {
+        return false;
+    }
+
+    auto& leaf = *slot;
+    if (Leaf::HasValue(leaf)) {
+        throw InternalException("The key has a value, not row ids.");
+    }
+
+    // the last row id of the key
+    if (!leaf.IsGate()) {
+        if (Leaf::GetRowId(leaf) != row_id) {
+            return false;
+        }
+        return Delete(*root, key, 0);
+    }
+
+    if (leaf.getTag() == NType::LEAF) {
+        auto& array_leaf = Node::RefMutable<Leaf>(*this, leaf, NType::LEAF);
+        idx_t count;
+        auto row_ids = GetRowIdArray(array_leaf, count);
+        auto pos = static_cast<idx_t>(std::lower_bound(row_ids, row_ids + count, row_id) - row_ids);
+        if (pos == count || row_ids[pos] != row_id) {
+            return false;
+        }
+
+        if (count == 2) {
+            // a single row id is an inlined leaf again
+            auto other = row_ids[1 - pos];
+            Node::Free(*this, leaf);
+            Leaf::NewInlined(*this, leaf, other);
+            return true;
+        }
+        std::memmove(row_ids + pos, row_ids + pos + 1, (count - 1 - pos) * sizeof(idx_t));
+        value_arena->Resize(array_leaf.value, (count - 1) * sizeof(idx_t));
+        return true;
+    }
+
+    Node nested = leaf;
+    nested.SetGate(false);
+    if (!Delete(nested, StackARTKey<idx_t>(row_id), 0)) {
+        return false;
+    }
+
+    // shrink the nested tree into an array, once it is small enough
+    const idx_t shrink_count = ROW_ID_ARRAY_CAPACITY / 2;
+    std::vector<idx_t> row_ids;
+    idx_t count = 0;
+    ScanNested(*this, nested, [&](idx_t id) {
+        row_ids.push_back(id);
+        return row_ids.size() <= shrink_count;
+    }, count);
+    if (row_ids.size() <= shrink_count) {
+        Node::Free(*this, nested);
+        leaf = Node();
+        NewRowIdSet(leaf, row_ids.data(), row_ids.size());
+        return true;
+    }
+    nested.SetGate(true);
+    leaf = nested;
+    return true;
+}
+
+idx_t ART::ScanRowIds(const ARTKey& key, const std::function<bool(idx_t)>& callback) const {
+    auto leaf = LookupLeaf(key);
+    if (leaf.IsCleared() || leaf.getTag() == NType::NODE_DUMMY) {
+        return 0;
+    }
+    if (Leaf::HasValue(leaf)) {
+        throw InternalException("The key has a value, not row ids.");
+    }
+    return ScanLeafRowIds(leaf, callback);
+}
+
+idx_t ART::ScanLeafRowIds(const Node& leaf, const std::function<bool(idx_t)>& callback) const {
+    if (!leaf.IsGate()) {
+        callback(Leaf::GetRowId(leaf));
+        return 1;
+    }
+
+    if (leaf.getTag() == NType::LEAF) {
+        idx_t count;
+        auto row_ids = GetRowIdArray(*GetAllocator(NType::LEAF).Get<const Leaf>(leaf), count);
+        for (idx_t i = 0; i < count; i++) {
+            if (!callback(row_ids[i])) {
+                return i + 1;
+            }
+        }
+        return count;
+    }
+
+    Node nested = leaf;
+    nested.SetGate(false);
+    idx_t count = 0;
+    ScanNested(*this, nested, callback, count);
+    return count;
+}
+
+void ART::NewRowIdSet(Node& leaf, const idx_t* row_ids, const idx_t count) {
+    D_ASSERT(count > 1);
+    Node::Free(*this, leaf);
+
+    if (count <= ROW_ID_ARRAY_CAPACITY) {
+        Value value(reinterpret_cast<data_ptr_t>(const_cast<idx_t*>(row_ids)),
+                    static_cast<uint32_t>(count * sizeof(idx_t)));
+        Leaf::New(*this, leaf, value);
+        leaf.SetGate(true);
+        return;
+    }
+
+    Node nested;
+    for (idx_t i = 0; i < count; i++) {
+        Node row_id_leaf;
+        Leaf::NewInlined(*this, row_id_leaf, row_ids[i]);
+        Insert(nested, StackARTKey<idx_t>(row_ids[i]), row_id_leaf, 0);
+    }
+    nested.SetGate(true);
+    leaf = nested;
+}
+
+Node* ART::LookupLeafMutable(const ARTKey& key) {
+    auto node = root.get();
+    idx_t depth = 0;
+
+    while (true) {
+        if (node->IsCleared() || node->getTag() == NType::NODE_DUMMY) {
+            return nullptr;
+        }
+        if (node->IsGate() || node->getTag() == NType::LEAF_INLINED) {
+            return depth == key.len ? node : nullptr;
+        }
+
+        switch (node->getTag()) {
+            case NType::LEAF: {
+                auto& leaf = Node::RefMutable<Leaf>(*this, *node, NType::LEAF);
+                if (!MatchPrefix(leaf.prefix, key, depth) || depth != key.len) {
+                    return nullptr;
+                }
+                return node;
+            }
+            case NType::PREFIX: {
+                // the key bytes ahead of an inlined leaf or a row id set
+                auto& prefix = Node::RefMutable<Prefix>(*this, *node, NType::PREFIX);
+                auto count = prefix.count;
+                if (depth + count > key.len || std::memcmp(prefix.data, key.data + depth, count) != 0) {
+                    return nullptr;
+                }
+                depth += count;
+                node = &prefix.ptr;
+                break;
+            }
+            default: {
+                if (!MatchPrefix(node->GetInlinePrefix(*this), node->GetPrefix(*this), key, depth) || depth >= key.len) {
+                    return nullptr;
+                }
+                uint8_t byte = key[depth];
+                auto child = node->GetNextChildMutable(*this, byte);
+                if (!child || byte != key[depth]) {
+                    return nullptr;
+                }
+                node = child;
+                depth++;
+                break;
+            }
+        }
+    }
+}
+
+idx_t ART::Iterator::ScanRowIds(const std::function<bool(idx_t)>& callback) const {
+    D_ASSERT(Valid());
+    if (Leaf::HasValue(leaf)) {
+        throw InternalException("The key has a value, not row ids.");
+    }
+    return art.ScanLeafRowIds(leaf, callback);
+}
+
+}  // namespace duckart
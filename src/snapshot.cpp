@@ -0,0 +1,1238 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "art.hpp"
+#include "epoch.hpp"
+#include "exception.hpp"
+#include "leaf.hpp"
+#include "node.hpp"
+#include "parallel.hpp"
+#include "snapshot.hpp"
+#include "value_arena.hpp"
+
+namespace duckart {
+
+// Snapshots write the blocks of all allocators of the tree as they are in memory, including
+// their headers and occupancy bitmaps. The pointers of the tree are block ids and offsets (see
+// IndexPointer), and the blocks keep their ids when they are read back or mapped, so no
+// pointer of the tree is rewritten. The only addresses in the blocks are those of the leaf
+// values that do not fit inline. The writer turns them into MAPPED values, which hold the
+// distance from the value to its bytes in the file: a slot in the slabs of the value arena, or
+// for values larger than the slabs, bytes behind the blocks. A mapped snapshot (see ART::Map)
+// reads them as they are, Deserialize resolves them to addresses again.
+//
+// File layout, all integers in the byte order of the host:
+// - SnapshotHeader
+// - one SnapshotAllocator per allocator: those of the tree, then the value arena size classes
+// - the ids of the blocks of every allocator, in the order of the allocators
+// - the blocks in the same order, starting at data_offset, which is aligned to
+//   SNAPSHOT_ALIGNMENT. Every block is as large as the block size of its allocator, a power of
+//   two of at least SNAPSHOT_ALIGNMENT, so every block is page-aligned in a mapping
+// - from large_value_offset on, the bytes of the values larger than the slabs
+
+//! Written as the first bytes of the file, "DUCKART\0"
+static constexpr char SNAPSHOT_MAGIC[8] = {'D', 'U', 'C', 'K', 'A', 'R', 'T', '\0'};
+//! Incremented whenever the layout of the file or of any node changes
+static constexpr uint32_t SNAPSHOT_VERSION = 3;
+static constexpr idx_t SNAPSHOT_ALIGNMENT = 4096;
+//! Blocks are written and read in runs of at least this many bytes
+static constexpr idx_t SNAPSHOT_IO_SIZE = 1 << 20;
+//! Largest number of blocks in one run, below IOV_MAX
+static constexpr idx_t SNAPSHOT_IO_BLOCKS = 512;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t allocator_count;
+    //! The bits of the root pointer
+    uint64_t root;
+    uint64_t block_count;
+    uint64_t data_offset;
+    uint64_t large_value_offset;
+    uint64_t file_size;
+};
+
+struct SnapshotAllocator {
+    uint64_t element_size;
+    uint64_t block_size;
+    uint64_t block_count;
+};
+
+//! A run of consecutive blocks in the file
+struct SnapshotRun {
+    idx_t first_block;
+    idx_t block_count;
+    idx_t offset;
+};
+
+//! The validated metadata of a snapshot
+struct SnapshotLayout {
+    SnapshotHeader header;
+    std::vector<SnapshotAllocator> allocators;
+    //! Id, allocator, size and file offset of every block, in the order of the file
+    std::vector<idx_t> block_ids;
+    std::vector<idx_t> block_allocators;
+    std::vector<idx_t> block_sizes;
+    std::vector<idx_t> block_offsets;
+};
+
+//! Closes the file descriptor when it goes out of scope
+class SnapshotFile {
+   public:
+    SnapshotFile(const std::string& path, int flags) : path(path) {
+        fd = open(path.c_str(), flags, 0644);
+        if (fd < 0) {
+            throw IOException("Could not open " + path + ": " + std::strerror(errno));
+        }
+    }
+    ~SnapshotFile() {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    SnapshotFile(const SnapshotFile&) = delete;
+    SnapshotFile& operator=(const SnapshotFile&) = delete;
+
+    //! Writes (reads) all bytes of iov at offset, and retries partial transfers
+    void Write(iovec* iov, int count, idx_t offset) const { Transfer(iov, count, offset, true); }
+    void Read(iovec* iov, int count, idx_t offset) const { Transfer(iov, count, offset, false); }
+    void Write(const void* data, idx_t size, idx_t offset) const {
+        iovec iov {const_cast<void*>(data), size};
+        Write(&iov, 1, offset);
+    }
+    void Read(void* data, idx_t size, idx_t offset) const {
+        iovec iov {data, size};
+        Read(&iov, 1, offset);
+    }
+
+    int GetDescriptor() const { return fd; }
+    idx_t GetSize() const {
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            throw IOException("Could not stat " + path + ": " + std::strerror(errno));
+        }
+        return static_cast<idx_t>(st.st_size);
+    }
+    void Truncate(idx_t size) const {
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            throw IOException("Could not resize " + path + ": " + std::strerror(errno));
+        }
+    }
+    //! Returns once the written bytes are on the disk
+    void Sync() const {
+        if (fdatasync(fd) != 0) {
+            throw IOException("Could not sync " + path + ": " + std::strerror(errno));
+        }
+    }
+
+   private:
+    std::string path;
+    int fd;
+
+    void Transfer(iovec* iov, int count, idx_t offset, bool write) const {
+        while (count > 0) {
+            auto result = write ? pwritev(fd, iov, count, static_cast<off_t>(offset))
+                                : preadv(fd, iov, count, static_cast<off_t>(offset));
+            if (result < 0 && errno == EINTR) {
+                continue;
+            }
+            if (result <= 0) {
+                throw IOException((write ? "Could not write " : "Could not read ") + path + ": " +
+                                  (result < 0 ? std::strerror(errno) : "unexpected end of file"));
+            }
+            offset += result;
+            auto done = static_cast<idx_t>(result);
+            while (count > 0 && done >= iov->iov_len) {
+                done -= iov->iov_len;
+                iov++;
+                count--;
+            }
+            if (count > 0) {
+                iov->iov_base = static_cast<char*>(iov->iov_base) + done;
+                iov->iov_len -= done;
+            }
+        }
+    }
+};
+
+//! The allocators of the tree followed by those of the value arena, in the order of the file
+static std::vector<FixedSizeAllocator*> GetSnapshotAllocators(const ART& art) {
+    std::vector<FixedSizeAllocator*> result;
+    for (auto& allocator : art.allocators) {
+        result.push_back(allocator.get());
+    }
+    for (auto& allocator : art.GetValueArena().GetAllocators()) {
+        result.push_back(allocator.get());
+    }
+    return result;
+}
+
+//! The element size and the block size of every allocator, which a snapshot must match
+static std::vector<std::pair<idx_t, idx_t>> GetSnapshotLayouts(const std::vector<FixedSizeAllocator*>& allocators) {
+    std::vector<std::pair<idx_t, idx_t>> result;
+    for (auto allocator : allocators) {
+        result.emplace_back(allocator->GetElementSize(), allocator->GetBlockSize());
+    }
+    return result;
+}
+
+//! Reads and validates the metadata of the snapshot at path, read(data, size, offset) reads
+//! from the file
+static SnapshotLayout ReadSnapshotLayout(const std::string& path, idx_t file_size,
+                                         const std::vector<std::pair<idx_t, idx_t>>& layouts,
+                                         const std::function<void(void*, idx_t, idx_t)>& read) {
+    SnapshotLayout layout;
+    auto& header = layout.header;
+    if (file_size < sizeof(header)) {
+        throw IOException(path + " is not a snapshot.");
+    }
+    read(&header, sizeof(header), 0);
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+        throw IOException(path + " is not a snapshot.");
+    }
+    if (header.version != SNAPSHOT_VERSION) {
+        throw IOException(path + " has snapshot version " + std::to_string(header.version) + ", expected " +
+                          std::to_string(SNAPSHOT_VERSION) + ".");
+    }
+    if (header.file_size != file_size) {
+        throw IOException(path + " is truncated.");
+    }
+    if (header.allocator_count != layouts.size()) {
+        throw IOException(path + " was written with different node types.");
+    }
+
+    layout.allocators.resize(layouts.size());
+    read(layout.allocators.data(), sizeof(SnapshotAllocator) * layouts.size(), sizeof(header));
+    auto offset = header.data_offset;
+    for (idx_t i = 0; i < layouts.size(); i++) {
+        auto& entry = layout.allocators[i];
+        if (entry.element_size != layouts[i].first || entry.block_size != layouts[i].second) {
+            throw IOException(path + " was written with different node layouts.");
+        }
+        if (entry.block_count > file_size / entry.block_size) {
+            throw IOException(path + " is corrupt.");
+        }
+        for (idx_t b = 0; b < entry.block_count; b++) {
+            layout.block_allocators.push_back(i);
+            layout.block_sizes.push_back(entry.block_size);
+            layout.block_offsets.push_back(offset);
+            offset += entry.block_size;
+        }
+    }
+    auto table_end = sizeof(header) + sizeof(SnapshotAllocator) * layouts.size() + sizeof(uint64_t) * header.block_count;
+    if (layout.block_sizes.size() != header.block_count || header.data_offset % SNAPSHOT_ALIGNMENT != 0 ||
+        header.data_offset < table_end || offset != header.large_value_offset || offset > file_size) {
+        throw IOException(path + " is corrupt.");
+    }
+    std::vector<uint64_t> ids(header.block_count);
+    read(ids.data(), sizeof(uint64_t) * ids.size(), sizeof(header) + sizeof(SnapshotAllocator) * layouts.size());
+    layout.block_ids.assign(ids.begin(), ids.end());
+    return layout;
+}
+
+//! Splits the blocks into runs of about SNAPSHOT_IO_SIZE bytes, which the threads transfer with
+//! one system call each
+static std::vector<SnapshotRun> GetSnapshotRuns(const std::vector<idx_t>& block_sizes, idx_t data_offset) {
+    std::vector<SnapshotRun> runs;
+    auto offset = data_offset;
+    for (idx_t i = 0; i < block_sizes.size(); i++) {
+        if (runs.empty() || runs.back().block_count == SNAPSHOT_IO_BLOCKS ||
+            offset - runs.back().offset >= SNAPSHOT_IO_SIZE) {
+            runs.push_back({i, 0, offset});
+        }
+        runs.back().block_count++;
+        offset += block_sizes[i];
+    }
+    return runs;
+}
+
+static idx_t AlignSnapshotOffset(idx_t offset) {
+    return (offset + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+}
+
+//! Returns the file offset of the bytes of the leaf value, which is not inlined. Values larger
+//! than the slabs are placed at large_offset, which advances past them
+static idx_t GetValueOffset(const ValueArena& arena, const Value& value, const std::vector<idx_t>& id_offsets,
+                            idx_t& large_offset) {
+    if (ValueArena::IsOwned(value)) {
+        auto offset = large_offset;
+        large_offset += value.GetSize();
+        return offset;
+    }
+    auto slot = arena.GetSlot(value);
+    return id_offsets[slot.GetBlockId()] + slot.GetOffset();
+}
+
+idx_t ART::Serialize(const std::string& path, idx_t thread_count) {
+    if (mapping) {
+        throw InternalException("Cannot serialize a mapped tree, copy its file instead.");
+    }
+    if (vacuum_active) {
+        throw InternalException("Cannot serialize a tree during a vacuum.");
+    }
+    if (thread_count == 0) {
+        thread_count = MaxValue<idx_t>(std::thread::hardware_concurrency(), 1);
+    }
+    // retired nodes and the free slots in thread caches are occupied in the bitmaps
+    ReclaimRetired();
+    auto allocators = GetSnapshotAllocators(*this);
+    for (auto allocator : allocators) {
+        allocator->FlushThreadCaches();
+    }
+
+    SnapshotHeader header;
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.allocator_count = static_cast<uint32_t>(allocators.size());
+    header.root = root->Get();
+
+    std::vector<SnapshotAllocator> allocator_entries;
+    std::vector<uint64_t> block_ids;
+    std::vector<idx_t> block_sizes;
+    //! The allocator of every block
+    std::vector<idx_t> block_allocators;
+    for (idx_t i = 0; i < allocators.size(); i++) {
+        auto ids = allocators[i]->GetBlockIds();
+        allocator_entries.push_back({allocators[i]->GetElementSize(), allocators[i]->GetBlockSize(), ids.size()});
+        for (auto id : ids) {
+            block_ids.push_back(id);
+            block_sizes.push_back(allocators[i]->GetBlockSize());
+            block_allocators.push_back(i);
+        }
+    }
+    header.block_count = block_ids.size();
+    header.data_offset = AlignSnapshotOffset(sizeof(SnapshotHeader) + sizeof(SnapshotAllocator) * allocators.size() +
+                                             sizeof(uint64_t) * block_ids.size());
+
+    // the file offset of every block by its id, which locates the bytes of the arena values
+    auto& leaf_allocator = GetAllocator(NType::LEAF);
+    std::vector<idx_t> id_offsets(leaf_allocator.GetDirectory()->GetIdCount(), INVALID_INDEX);
+    std::vector<idx_t> block_offsets;
+    auto offset = header.data_offset;
+    for (idx_t i = 0; i < block_ids.size(); i++) {
+        id_offsets[block_ids[i]] = offset;
+        block_offsets.push_back(offset);
+        offset += block_sizes[i];
+    }
+    header.large_value_offset = offset;
+
+    // the values larger than the slabs follow the blocks, in the order of their leaves
+    std::vector<idx_t> leaf_blocks;
+    for (idx_t i = 0; i < block_ids.size(); i++) {
+        if (allocators[block_allocators[i]] == &leaf_allocator) {
+            leaf_blocks.push_back(i);
+        }
+    }
+    std::vector<idx_t> large_offsets(leaf_blocks.size() + 1, 0);
+    ParallelFor(thread_count, leaf_blocks.size(), [&](idx_t i) {
+        auto block = leaf_allocator.GetDirectory()->Get(block_ids[leaf_blocks[i]]);
+        leaf_allocator.ForEachSlot(block, [&](char* slot) {
+            auto& value = reinterpret_cast<Leaf*>(slot)->value;
+            if (ValueArena::IsOwned(value)) {
+                large_offsets[i + 1] += value.GetSize();
+            }
+        });
+    });
+    large_offsets[0] = header.large_value_offset;
+    for (idx_t i = 0; i < leaf_blocks.size(); i++) {
+        large_offsets[i + 1] += large_offsets[i];
+    }
+    header.file_size = large_offsets.back();
+
+    // write to a temporary file, so that a failed write never replaces a previous snapshot
+    auto temp_path = path + ".tmp";
+    SnapshotFile file(temp_path, O_WRONLY | O_CREAT | O_TRUNC);
+    file.Truncate(header.file_size);
+
+    // the threads write runs of blocks straight from memory, except for the leaf blocks, in
+    // whose copies they turn the values that are not inlined into MAPPED values
+    auto runs = GetSnapshotRuns(block_sizes, header.data_offset);
+    ParallelFor(thread_count, runs.size(), [&](idx_t run_idx) {
+        thread_local std::vector<uint64_t> staging;
+        auto& run = runs[run_idx];
+        idx_t staging_size = 0;
+        for (idx_t i = run.first_block; i < run.first_block + run.block_count; i++) {
+            if (allocators[block_allocators[i]] == &leaf_allocator) {
+                staging_size += block_sizes[i];
+            }
+        }
+        staging.resize(staging_size / sizeof(uint64_t));
+
+        iovec iov[SNAPSHOT_IO_BLOCKS];
+        auto staged = reinterpret_cast<char*>(staging.data());
+        for (idx_t i = 0; i < run.block_count; i++) {
+            auto block = run.first_block + i;
+            auto allocator = allocators[block_allocators[block]];
+            auto live = reinterpret_cast<char*>(allocator->GetDirectory()->Get(block_ids[block]));
+            iov[i] = {live, block_sizes[block]};
+            if (allocator != &leaf_allocator) {
+                continue;
+            }
+            std::memcpy(staged, live, block_sizes[block]);
+            auto large_offset =
+                large_offsets[std::lower_bound(leaf_blocks.begin(), leaf_blocks.end(), block) - leaf_blocks.begin()];
+            allocator->ForEachSlot(reinterpret_cast<BlockHeader*>(staged), [&](char* slot) {
+                auto& value = reinterpret_cast<Leaf*>(slot)->value;
+                if (value.IsInlined()) {
+                    return;
+                }
+                auto value_offset = block_offsets[block] + (reinterpret_cast<char*>(&value) - staged);
+                auto bytes_offset = GetValueOffset(*value_arena, value, id_offsets, large_offset);
+                if (ValueArena::IsOwned(value)) {
+                    auto& source = reinterpret_cast<Leaf*>(live + (slot - staged))->value;
+                    file.Write(source.GetData(), source.GetSize(), bytes_offset);
+                }
+                ValueArena::SetMapped(value, static_cast<int64_t>(bytes_offset) - static_cast<int64_t>(value_offset));
+            });
+            iov[i].iov_base = staged;
+            staged += block_sizes[block];
+        }
+        file.Write(iov, static_cast<int>(run.block_count), run.offset);
+    });
+
+    file.Write(&header, sizeof(header), 0);
+    file.Write(allocator_entries.data(), sizeof(SnapshotAllocator) * allocator_entries.size(), sizeof(header));
+    file.Write(block_ids.data(), sizeof(uint64_t) * block_ids.size(),
+               sizeof(header) + sizeof(SnapshotAllocator) * allocator_entries.size());
+    if (std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        throw IOException("Could not rename " + temp_path + " to " + path + ": " + std::strerror(errno));
+    }
+    return header.file_size;
+}
+
+//! Throws if the tree has any keys or slots, which loading a snapshot would replace
+static void CheckEmpty(const ART& art, const std::vector<FixedSizeAllocator*>& allocators, const char* operation) {
+    if (!art.root->IsCleared() && art.root->getTag() != NType::NODE_DUMMY) {
+        throw InternalException(std::string(operation) + " requires an empty tree.");
+    }
+    for (auto allocator : allocators) {
+        allocator->FlushThreadCaches();
+        if (allocator->GetUsed() != 0) {
+            throw InternalException(std::string(operation) + " requires an empty tree.");
+        }
+    }
+}
+
+idx_t ART::Deserialize(const std::string& path, idx_t thread_count) {
+    if (mapping) {
+        throw InternalException("Cannot load a snapshot into a mapped tree.");
+    }
+    if (thread_count == 0) {
+        thread_count = MaxValue<idx_t>(std::thread::hardware_concurrency(), 1);
+    }
+    ReclaimRetired();
+    auto allocators = GetSnapshotAllocators(*this);
+    CheckEmpty(*this, allocators, "Deserialize");
+
+    SnapshotFile file(path, O_RDONLY);
+    auto file_size = file.GetSize();
+    auto layout = ReadSnapshotLayout(path, file_size, GetSnapshotLayouts(allocators),
+                                     [&](void* data, idx_t size, idx_t offset) { file.Read(data, size, offset); });
+    auto& header = layout.header;
+
+    auto& leaf_allocator = GetAllocator(NType::LEAF);
+    try {
+        // the blocks take the ids they had when they were written
+        for (auto allocator : allocators) {
+            allocator->Reset();
+        }
+        std::vector<BlockHeader*> blocks;
+        idx_t first_block = 0;
+        for (idx_t i = 0; i < allocators.size(); i++) {
+            std::vector<idx_t> ids(layout.block_ids.begin() + first_block,
+                                   layout.block_ids.begin() + first_block + layout.allocators[i].block_count);
+            auto headers = allocators[i]->LoadBlocks(ids);
+            blocks.insert(blocks.end(), headers.begin(), headers.end());
+            first_block += ids.size();
+        }
+
+        // resolves a MAPPED value in the block that was read from block_offset
+        auto resolve = [&](Value& value, idx_t block_offset, idx_t value_in_block) {
+            auto bytes_offset = block_offset + value_in_block + ValueArena::GetDistance(value);
+            if (bytes_offset < header.data_offset || bytes_offset + value.GetSize() > file_size) {
+                throw IOException(path + " is corrupt.");
+            }
+            if (bytes_offset >= header.large_value_offset) {
+                auto bytes = new data_t[value.GetSize()];
+                ValueArena::SetBytes(value, bytes, Value::OWNED);
+                file.Read(bytes, value.GetSize(), bytes_offset);
+                return;
+            }
+            auto block = std::upper_bound(layout.block_offsets.begin(), layout.block_offsets.end(), bytes_offset) -
+                         layout.block_offsets.begin() - 1;
+            auto in_block = bytes_offset - layout.block_offsets[block];
+            if (in_block + value.GetSize() > layout.block_sizes[block]) {
+                throw IOException(path + " is corrupt.");
+            }
+            ValueArena::SetBytes(value, reinterpret_cast<data_ptr_t>(blocks[block]) + in_block, Value::ARENA);
+        };
+
+        auto runs = GetSnapshotRuns(layout.block_sizes, header.data_offset);
+        ParallelFor(thread_count, runs.size(), [&](idx_t run_idx) {
+            auto& run = runs[run_idx];
+            iovec iov[SNAPSHOT_IO_BLOCKS];
+            for (idx_t i = 0; i < run.block_count; i++) {
+                iov[i] = {blocks[run.first_block + i], layout.block_sizes[run.first_block + i]};
+            }
+            file.Read(iov, static_cast<int>(run.block_count), run.offset);
+            for (idx_t i = run.first_block; i < run.first_block + run.block_count; i++) {
+                if (allocators[layout.block_allocators[i]] != &leaf_allocator) {
+                    continue;
+                }
+                auto block = reinterpret_cast<char*>(blocks[i]);
+                leaf_allocator.ForEachSlot(blocks[i], [&](char* slot) {
+                    auto& value = reinterpret_cast<Leaf*>(slot)->value;
+                    if (!value.IsInlined()) {
+                        resolve(value, layout.block_offsets[i], reinterpret_cast<char*>(&value) - block);
+                    }
+                });
+            }
+        });
+
+        for (auto allocator : allocators) {
+            allocator->FinalizeLoad();
+        }
+    } catch (...) {
+        // leave an empty tree behind
+        for (auto allocator : allocators) {
+            allocator->Reset();
+            allocator->FinalizeLoad();
+        }
+        *root = Node();
+        throw;
+    }
+    root->Set(header.root);
+    return file_size;
+}
+
+idx_t ART::Map(const std::string& path, bool populate) {
+    if (mapping) {
+        throw InternalException("The tree is mapped already.");
+    }
+    ReclaimRetired();
+    auto allocators = GetSnapshotAllocators(*this);
+    CheckEmpty(*this, allocators, "Map");
+    // the blocks of the mapping take the ids they had when they were written, the allocators
+    // have no blocks left, and take fresh ids for new ones
+    for (auto allocator : allocators) {
+        allocator->Reset();
+    }
+    mapping = decltype(mapping)(new SnapshotMapping(path, GetDirectory(), GetSnapshotLayouts(allocators), populate),
+                                [](SnapshotMapping* mapped) { delete mapped; });
+    root->Set(mapping->GetRoot());
+    return mapping->GetSize();
+}
+
+//===--------------------------------------------------------------------===//
+// SnapshotMapping
+//===--------------------------------------------------------------------===//
+SnapshotMapping::SnapshotMapping(const std::string& path, std::shared_ptr<BlockDirectory> directory,
+                                 const std::vector<std::pair<idx_t, idx_t>>& layouts, bool populate)
+    : directory(std::move(directory)) {
+    SnapshotFile file(path, O_RDONLY);
+    size = file.GetSize();
+    auto layout = ReadSnapshotLayout(path, size, layouts,
+                                     [&](void* data, idx_t size, idx_t offset) { file.Read(data, size, offset); });
+
+    data = mmap(nullptr, size, PROT_READ, MAP_SHARED | (populate ? MAP_POPULATE : 0), file.GetDescriptor(), 0);
+    if (data == MAP_FAILED) {
+        data = nullptr;
+        throw IOException("Could not map " + path + ": " + std::strerror(errno));
+    }
+    try {
+        for (idx_t i = 0; i < layout.block_ids.size(); i++) {
+            auto header = reinterpret_cast<BlockHeader*>(static_cast<char*>(data) + layout.block_offsets[i]);
+            this->directory->RegisterAt(header, layout.block_ids[i]);
+            block_ids.push_back(layout.block_ids[i]);
+        }
+    } catch (...) {
+        Release();
+        throw;
+    }
+    root = layout.header.root;
+}
+
+SnapshotMapping::~SnapshotMapping() { Release(); }
+
+void SnapshotMapping::Release() {
+    for (auto block_id : block_ids) {
+        directory->Unregister(block_id);
+    }
+    block_ids.clear();
+    if (data) {
+        munmap(data, size);
+        data = nullptr;
+    }
+}
+
+//===--------------------------------------------------------------------===//
+// Checkpoint
+//===--------------------------------------------------------------------===//
+// A checkpoint file holds the pages of the blocks of a tree at arbitrary, aligned offsets, and
+// root records that say where they are. Checkpoint writes the pages that changed since the
+// previous checkpoint (see BlockDirectory::MarkDirty) into space that the latest root record
+// does not reference, then appends a root record, and only then points the header to it. So
+// the file always holds a complete tree, whichever write a crash interrupts. The space of the
+// replaced pages and records is reused once the new root record is durable.
+//
+// A root record either lists the pages of all blocks (a full record), or only those that
+// changed since the previous record, and the blocks that were released. Every entry places a
+// run of pages of a block that are adjacent in the file. Loading applies the chain of records
+// from the last full record on. Checkpoint writes a full record once the chain would hold more
+// entries than a full record, so the records cost O(1) per changed run of pages, amortized,
+// like the pages themselves.
+//
+// The leaf values that are not inlined hold the location of their bytes instead of their
+// address: the IndexPointer of their slot in the value arena, or for values larger than the
+// slabs, the offset of their bytes behind the pages of the leaf block. A leaf block with such
+// values is always written as a whole, with its values.
+//
+// File layout, all integers in the byte order of the host:
+// - CheckpointHeader, followed by one SnapshotAllocator per allocator (the block counts are 0),
+//   in the first SNAPSHOT_ALIGNMENT bytes
+// - pages and root records (CheckpointRecord, followed by its CheckpointEntry list), each
+//   aligned to SNAPSHOT_ALIGNMENT
+
+//! Written as the first bytes of the file, "DUCKCKP\0"
+static constexpr char CHECKPOINT_MAGIC[8] = {'D', 'U', 'C', 'K', 'C', 'K', 'P', '\0'};
+//! Incremented whenever the layout of the file or of any node changes
+static constexpr uint32_t CHECKPOINT_VERSION = 3;
+//! The allocator of the entry of a released block
+static constexpr uint64_t CHECKPOINT_REMOVED = ~uint64_t(0);
+
+static_assert(BlockDirectory::PAGE_SIZE % SNAPSHOT_ALIGNMENT == 0, "Dirty pages are whole pages of the file");
+
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t allocator_count;
+    //! The latest root record
+    uint64_t record_offset;
+    uint64_t record_size;
+};
+
+struct CheckpointRecord {
+    uint64_t sequence;
+    //! The bits of the root pointer
+    uint64_t root;
+    //! The record that this one changes, or 0 if this is a full record
+    uint64_t previous_offset;
+    uint64_t previous_size;
+    uint64_t entry_count;
+};
+
+//! Places size bytes of pages of a block, from first_page on, at offset
+struct CheckpointEntry {
+    uint64_t block_id;
+    //! CHECKPOINT_REMOVED if the block was released
+    uint64_t allocator;
+    //! Number of pages of the block and of the values behind it, the block drops any others
+    uint64_t page_count;
+    uint64_t first_page;
+    uint64_t offset;
+    uint64_t size;
+};
+
+//! A run of pages of a block that a checkpoint writes
+struct CheckpointWrite {
+    idx_t allocator;
+    idx_t block_id;
+    idx_t first_page;
+    //! Bytes of the block in the run
+    idx_t size;
+    //! Bytes of the values behind a leaf block, which is written as a whole
+    idx_t owned_size;
+    idx_t offset;
+};
+
+//! A run of pages of a block that LoadCheckpoint reads, into the block or into its values
+struct CheckpointRead {
+    char* target;
+    idx_t size;
+    idx_t offset;
+};
+
+idx_t CheckpointState::Allocate(idx_t size) {
+    auto it = free_space.lower_bound({size, 0});
+    if (it == free_space.end()) {
+        // the file grows by less if its last range is free
+        auto offset = file_size;
+        auto last = free_ranges.empty() ? free_ranges.end() : std::prev(free_ranges.end());
+        if (last != free_ranges.end() && last->first + last->second == file_size) {
+            offset = last->first;
+            free_space.erase({last->second, last->first});
+            free_ranges.erase(last);
+        }
+        file_size = offset + size;
+        return offset;
+    }
+    auto range = *it;
+    free_space.erase(it);
+    free_ranges.erase(range.second);
+    Free(range.second + size, range.first - size);
+    return range.second;
+}
+
+void CheckpointState::Free(idx_t offset, idx_t size) {
+    if (size == 0) {
+        return;
+    }
+    auto next = free_ranges.lower_bound(offset);
+    if (next != free_ranges.end() && offset + size == next->first) {
+        size += next->second;
+        free_space.erase({next->second, next->first});
+        next = free_ranges.erase(next);
+    }
+    if (next != free_ranges.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == offset) {
+            offset = previous->first;
+            size += previous->second;
+            free_space.erase({previous->second, previous->first});
+            free_ranges.erase(previous);
+        }
+    }
+    free_space.emplace(size, offset);
+    free_ranges.emplace(offset, size);
+}
+
+//! Calls callback(first_page, page_count, offset) for the runs of pages of the block that are
+//! adjacent in the file
+template <typename F>
+static void ForEachPageRun(const CheckpointBlock& block, F&& callback) {
+    idx_t first = 0;
+    for (idx_t i = 1; i <= block.pages.size(); i++) {
+        if (i == block.pages.size() || block.pages[i] != block.pages[i - 1] + SNAPSHOT_ALIGNMENT) {
+            callback(first, i - first, block.pages[first]);
+            first = i;
+        }
+    }
+}
+
+//! Returns the number of bytes of the values in the leaf block that are larger than the slabs
+static idx_t GetOwnedSize(const FixedSizeAllocator& leaf_allocator, BlockHeader* block) {
+    idx_t size = 0;
+    leaf_allocator.ForEachSlot(block, [&](char* slot) {
+        auto& value = reinterpret_cast<Leaf*>(slot)->value;
+        if (ValueArena::IsOwned(value)) {
+            size += value.GetSize();
+        }
+    });
+    return size;
+}
+
+idx_t ART::Checkpoint(const std::string& path, idx_t thread_count) {
+    if (mapping) {
+        throw InternalException("Cannot checkpoint a mapped tree.");
+    }
+    if (vacuum_active) {
+        throw InternalException("Cannot checkpoint a tree during a vacuum.");
+    }
+    if (thread_count == 0) {
+        thread_count = MaxValue<idx_t>(std::thread::hardware_concurrency(), 1);
+    }
+    ReclaimRetired();
+    auto allocators = GetSnapshotAllocators(*this);
+    for (auto allocator : allocators) {
+        allocator->FlushThreadCaches();
+    }
+    auto& directory = *GetDirectory();
+    auto& leaf_allocator = GetAllocator(NType::LEAF);
+
+    // the tree takes the state back once the checkpoint is durable, after a failure the next
+    // checkpoint starts a new file
+    std::unique_ptr<CheckpointState> state;
+    auto full = !checkpoint || checkpoint->path != path;
+    if (full) {
+        state = std::make_unique<CheckpointState>();
+        state->path = path;
+        state->file_size = SNAPSHOT_ALIGNMENT;
+    } else {
+        state = std::move(checkpoint);
+    }
+    auto temp_path = path + ".tmp";
+    SnapshotFile file(full ? temp_path : path, full ? O_WRONLY | O_CREAT | O_TRUNC : O_WRONLY);
+
+    // the changed blocks, and the blocks of the previous checkpoint that are gone
+    std::vector<CheckpointWrite> changed;
+    std::vector<uint8_t> live(directory.GetIdCount(), 0);
+    for (idx_t i = 0; i < allocators.size(); i++) {
+        for (auto id : allocators[i]->GetBlockIds()) {
+            live[id] = 1;
+        }
+        for (auto id : full ? allocators[i]->GetBlockIds() : allocators[i]->GetDirtyBlockIds()) {
+            changed.push_back({i, id, 0, allocators[i]->GetBlockSize(), 0, 0});
+        }
+    }
+    std::vector<idx_t> removed;
+    for (auto& entry : state->blocks) {
+        if (entry.first >= live.size() || !live[entry.first]) {
+            removed.push_back(entry.first);
+        }
+    }
+    ParallelFor(thread_count, changed.size(), [&](idx_t i) {
+        if (allocators[changed[i].allocator] == &leaf_allocator) {
+            changed[i].owned_size = GetOwnedSize(leaf_allocator, directory.Get(changed[i].block_id));
+        }
+    });
+
+    // the runs of dirty pages of the changed blocks, or the whole blocks if they are new, or
+    // hold values behind them
+    std::vector<std::pair<idx_t, idx_t>> superseded;
+    std::vector<CheckpointWrite> writes;
+    for (auto& block : changed) {
+        auto allocator = allocators[block.allocator];
+        auto page_count = AlignSnapshotOffset(block.size + block.owned_size) / SNAPSHOT_ALIGNMENT;
+        auto& pages = state->blocks[block.block_id];
+        if (block.owned_size > 0 || pages.allocator != block.allocator || pages.pages.size() != page_count) {
+            if (!pages.pages.empty()) {
+                ForEachPageRun(pages, [&](idx_t, idx_t count, idx_t offset) {
+                    superseded.emplace_back(offset, count * SNAPSHOT_ALIGNMENT);
+                });
+            }
+            pages.allocator = block.allocator;
+            pages.pages.assign(page_count, 0);
+            writes.push_back(block);
+            continue;
+        }
+        auto page_size = allocator->GetPageSize();
+        for (idx_t page = 0; page < block.size / page_size; page++) {
+            if (!allocator->IsDirty(block.block_id, page)) {
+                continue;
+            }
+            auto first_page = page * page_size / SNAPSHOT_ALIGNMENT;
+            for (idx_t i = 0; i < page_size / SNAPSHOT_ALIGNMENT; i++) {
+                superseded.emplace_back(pages.pages[first_page + i], SNAPSHOT_ALIGNMENT);
+            }
+            if (!writes.empty() && writes.back().block_id == block.block_id &&
+                writes.back().first_page * SNAPSHOT_ALIGNMENT + writes.back().size == page * page_size) {
+                writes.back().size += page_size;
+            } else {
+                writes.push_back({block.allocator, block.block_id, first_page, page_size, 0, 0});
+            }
+        }
+    }
+
+    // place the runs, the pages that they replace are free once this checkpoint is durable
+    idx_t written = 0;
+    for (auto& write : writes) {
+        auto size = AlignSnapshotOffset(write.size + write.owned_size);
+        write.offset = state->Allocate(size);
+        written += size;
+        auto& pages = state->blocks[write.block_id].pages;
+        for (idx_t i = 0; i < size / SNAPSHOT_ALIGNMENT; i++) {
+            pages[write.first_page + i] = write.offset + i * SNAPSHOT_ALIGNMENT;
+        }
+    }
+    for (auto id : removed) {
+        ForEachPageRun(state->blocks[id], [&](idx_t, idx_t count, idx_t offset) {
+            superseded.emplace_back(offset, count * SNAPSHOT_ALIGNMENT);
+        });
+        state->blocks.erase(id);
+    }
+
+    // the threads write runs that are adjacent in the file, the pages of leaf blocks from copies
+    // whose values hold the locations of their bytes
+    std::sort(writes.begin(), writes.end(),
+              [](const CheckpointWrite& l, const CheckpointWrite& r) { return l.offset < r.offset; });
+    std::vector<SnapshotRun> runs;
+    for (idx_t i = 0; i < writes.size(); i++) {
+        auto& previous = writes[i > 0 ? i - 1 : 0];
+        if (runs.empty() || runs.back().block_count == SNAPSHOT_IO_BLOCKS ||
+            writes[i].offset - runs.back().offset >= SNAPSHOT_IO_SIZE ||
+            writes[i].offset != previous.offset + previous.size || previous.owned_size > 0) {
+            runs.push_back({i, 0, writes[i].offset});
+        }
+        runs.back().block_count++;
+    }
+    ParallelFor(thread_count, runs.size(), [&](idx_t run_idx) {
+        thread_local std::vector<uint64_t> staging;
+        auto& run = runs[run_idx];
+        idx_t staging_size = 0;
+        for (idx_t i = run.first_block; i < run.first_block + run.block_count; i++) {
+            if (allocators[writes[i].allocator] == &leaf_allocator) {
+                staging_size += leaf_allocator.GetBlockSize();
+            }
+        }
+        staging.resize(staging_size / sizeof(uint64_t));
+
+        iovec iov[SNAPSHOT_IO_BLOCKS];
+        auto staged = reinterpret_cast<char*>(staging.data());
+        for (idx_t i = 0; i < run.block_count; i++) {
+            auto& write = writes[run.first_block + i];
+            auto allocator = allocators[write.allocator];
+            auto live_block = reinterpret_cast<char*>(directory.Get(write.block_id));
+            auto first_byte = write.first_page * SNAPSHOT_ALIGNMENT;
+            iov[i] = {live_block + first_byte, write.size};
+            if (allocator != &leaf_allocator) {
+                continue;
+            }
+            std::memcpy(staged, live_block, allocator->GetBlockSize());
+            auto owned_offset = allocator->GetBlockSize();
+            allocator->ForEachSlot(reinterpret_cast<BlockHeader*>(staged), [&](char* slot) {
+                auto& value = reinterpret_cast<Leaf*>(slot)->value;
+                if (value.IsInlined()) {
+                    return;
+                }
+                if (!ValueArena::IsOwned(value)) {
+                    ValueArena::SetLocation(value, value_arena->GetSlot(value).Get());
+                    return;
+                }
+                auto& source = reinterpret_cast<Leaf*>(live_block + (slot - staged))->value;
+                file.Write(source.GetData(), source.GetSize(), write.offset + owned_offset);
+                ValueArena::SetLocation(value, owned_offset);
+                owned_offset += source.GetSize();
+            });
+            iov[i].iov_base = staged + first_byte;
+            staged += allocator->GetBlockSize();
+        }
+        file.Write(iov, static_cast<int>(run.block_count), run.offset);
+    });
+
+    // the root record, which lists all pages once the chain of records grows too long
+    idx_t full_entries = 0;
+    for (auto& entry : state->blocks) {
+        ForEachPageRun(entry.second, [&](idx_t, idx_t, idx_t) { full_entries++; });
+    }
+    auto change_count = writes.size() + removed.size();
+    auto full_record = full || state->record_entries + change_count > full_entries;
+    std::vector<CheckpointEntry> entries;
+    if (full_record) {
+        for (auto& entry : state->blocks) {
+            auto& block = entry.second;
+            ForEachPageRun(block, [&](idx_t first, idx_t count, idx_t offset) {
+                entries.push_back(
+                    {entry.first, block.allocator, block.pages.size(), first, offset, count * SNAPSHOT_ALIGNMENT});
+            });
+        }
+    } else {
+        for (auto& write : writes) {
+            auto& block = state->blocks[write.block_id];
+            entries.push_back({write.block_id, block.allocator, block.pages.size(), write.first_page, write.offset,
+                               AlignSnapshotOffset(write.size + write.owned_size)});
+        }
+        for (auto id : removed) {
+            entries.push_back({id, CHECKPOINT_REMOVED, 0, 0, 0, 0});
+        }
+    }
+    CheckpointRecord record;
+    record.sequence = state->sequence + 1;
+    record.root = root->Get();
+    record.previous_offset = full_record ? 0 : state->records.back().first;
+    record.previous_size = full_record ? 0 : state->records.back().second;
+    record.entry_count = entries.size();
+    auto record_size = AlignSnapshotOffset(sizeof(record) + sizeof(CheckpointEntry) * entries.size());
+    auto record_offset = state->Allocate(record_size);
+    std::vector<char> record_data(record_size, 0);
+    std::memcpy(record_data.data(), &record, sizeof(record));
+    std::memcpy(record_data.data() + sizeof(record), entries.data(), sizeof(CheckpointEntry) * entries.size());
+    file.Write(record_data.data(), record_size, record_offset);
+    written += record_size;
+    if (full_record) {
+        superseded.insert(superseded.end(), state->records.begin(), state->records.end());
+        state->records.clear();
+        state->record_entries = 0;
+    }
+    state->records.emplace_back(record_offset, record_size);
+    state->record_entries += entries.size();
+    state->sequence = record.sequence;
+
+    // the header points to the new record only once the record and its pages are durable, the
+    // header is smaller than a disk sector, so it is written atomically
+    file.Sync();
+    CheckpointHeader header;
+    std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+    header.version = CHECKPOINT_VERSION;
+    header.allocator_count = static_cast<uint32_t>(allocators.size());
+    header.record_offset = record_offset;
+    header.record_size = record_size;
+    if (full) {
+        std::vector<SnapshotAllocator> allocator_entries;
+        for (auto allocator : allocators) {
+            allocator_entries.push_back({allocator->GetElementSize(), allocator->GetBlockSize(), 0});
+        }
+        file.Write(allocator_entries.data(), sizeof(SnapshotAllocator) * allocator_entries.size(), sizeof(header));
+        written += sizeof(SnapshotAllocator) * allocator_entries.size();
+    }
+    file.Write(&header, sizeof(header), 0);
+    written += sizeof(header);
+    file.Sync();
+    if (full && std::rename(temp_path.c_str(), path.c_str()) != 0) {
+        throw IOException("Could not rename " + temp_path + " to " + path + ": " + std::strerror(errno));
+    }
+
+    for (auto& range : superseded) {
+        state->Free(range.first, range.second);
+    }
+    for (auto allocator : allocators) {
+        allocator->ClearDirty();
+    }
+    checkpoint = std::move(state);
+    return written;
+}
+
+idx_t ART::LoadCheckpoint(const std::string& path, idx_t thread_count) {
+    if (mapping) {
+        throw InternalException("Cannot load a checkpoint into a mapped tree.");
+    }
+    if (thread_count == 0) {
+        thread_count = MaxValue<idx_t>(std::thread::hardware_concurrency(), 1);
+    }
+    ReclaimRetired();
+    auto allocators = GetSnapshotAllocators(*this);
+    CheckEmpty(*this, allocators, "LoadCheckpoint");
+
+    SnapshotFile file(path, O_RDONLY);
+    auto file_size = file.GetSize();
+    CheckpointHeader header;
+    if (file_size < SNAPSHOT_ALIGNMENT) {
+        throw IOException(path + " is not a checkpoint.");
+    }
+    file.Read(&header, sizeof(header), 0);
+    if (std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0) {
+        throw IOException(path + " is not a checkpoint.");
+    }
+    if (header.version != CHECKPOINT_VERSION) {
+        throw IOException(path + " has checkpoint version " + std::to_string(header.version) + ", expected " +
+                          std::to_string(CHECKPOINT_VERSION) + ".");
+    }
+    auto layouts = GetSnapshotLayouts(allocators);
+    if (header.allocator_count != layouts.size()) {
+        throw IOException(path + " was written with different node types.");
+    }
+    std::vector<SnapshotAllocator> allocator_entries(layouts.size());
+    file.Read(allocator_entries.data(), sizeof(SnapshotAllocator) * layouts.size(), sizeof(header));
+    for (idx_t i = 0; i < layouts.size(); i++) {
+        if (allocator_entries[i].element_size != layouts[i].first ||
+            allocator_entries[i].block_size != layouts[i].second) {
+            throw IOException(path + " was written with different node layouts.");
+        }
+    }
+
+    // the chain of root records, from the latest back to the last full record, then their
+    // entries from the full record on
+    auto state = std::make_unique<CheckpointState>();
+    state->path = path;
+    state->file_size = file_size;
+    std::vector<std::vector<CheckpointEntry>> record_entries;
+    uint64_t root_bits = 0;
+    auto offset = header.record_offset;
+    auto size = header.record_size;
+    while (true) {
+        if (offset < SNAPSHOT_ALIGNMENT || offset % SNAPSHOT_ALIGNMENT != 0 || size < sizeof(CheckpointRecord) ||
+            offset + size > file_size || state->records.size() > file_size / SNAPSHOT_ALIGNMENT) {
+            throw IOException(path + " is corrupt.");
+        }
+        CheckpointRecord record;
+        file.Read(&record, sizeof(record), offset);
+        if (record.entry_count > (size - sizeof(record)) / sizeof(CheckpointEntry)) {
+            throw IOException(path + " is corrupt.");
+        }
+        if (state->records.empty()) {
+            root_bits = record.root;
+            state->sequence = record.sequence;
+        }
+        std::vector<CheckpointEntry> entries(record.entry_count);
+        file.Read(entries.data(), sizeof(CheckpointEntry) * entries.size(), offset + sizeof(record));
+        state->records.insert(state->records.begin(), {offset, size});
+        record_entries.insert(record_entries.begin(), std::move(entries));
+        state->record_entries += record.entry_count;
+        if (record.previous_offset == 0) {
+            break;
+        }
+        offset = record.previous_offset;
+        size = record.previous_size;
+    }
+    for (auto& entries : record_entries) {
+        for (auto& entry : entries) {
+            if (entry.allocator == CHECKPOINT_REMOVED) {
+                state->blocks.erase(entry.block_id);
+                continue;
+            }
+            if (entry.allocator >= allocators.size() || entry.offset % SNAPSHOT_ALIGNMENT != 0 ||
+                entry.size % SNAPSHOT_ALIGNMENT != 0 || entry.offset + entry.size > file_size ||
+                entry.page_count * SNAPSHOT_ALIGNMENT < allocators[entry.allocator]->GetBlockSize() ||
+                entry.page_count > file_size / SNAPSHOT_ALIGNMENT ||
+                entry.first_page + entry.size / SNAPSHOT_ALIGNMENT > entry.page_count) {
+                throw IOException(path + " is corrupt.");
+            }
+            // a block that changes its allocator, or its size, is written as a whole
+            auto& block = state->blocks[entry.block_id];
+            if (block.allocator != entry.allocator) {
+                block.pages.clear();
+            }
+            block.allocator = entry.allocator;
+            block.pages.resize(entry.page_count, INVALID_INDEX);
+            for (idx_t i = 0; i < entry.size / SNAPSHOT_ALIGNMENT; i++) {
+                block.pages[entry.first_page + i] = entry.offset + i * SNAPSHOT_ALIGNMENT;
+            }
+        }
+    }
+
+    // every page is somewhere, the pages and records must not overlap, the space between them
+    // is free
+    std::vector<std::pair<idx_t, idx_t>> ranges(state->records.begin(), state->records.end());
+    for (auto& entry : state->blocks) {
+        for (auto page : entry.second.pages) {
+            if (page == INVALID_INDEX) {
+                throw IOException(path + " is corrupt.");
+            }
+        }
+        ForEachPageRun(entry.second, [&](idx_t, idx_t count, idx_t offset) {
+            ranges.emplace_back(offset, count * SNAPSHOT_ALIGNMENT);
+        });
+    }
+    std::sort(ranges.begin(), ranges.end());
+    idx_t end = SNAPSHOT_ALIGNMENT;
+    for (auto& range : ranges) {
+        if (range.first < end) {
+            throw IOException(path + " is corrupt.");
+        }
+        state->Free(end, range.first - end);
+        end = range.first + range.second;
+    }
+    state->Free(end, file_size - end);
+
+    auto& directory = *GetDirectory();
+    auto& leaf_allocator = GetAllocator(NType::LEAF);
+    try {
+        // the blocks take the ids they had when they were written
+        for (auto allocator : allocators) {
+            allocator->Reset();
+        }
+        struct BlockLoad {
+            BlockHeader* block;
+            const CheckpointBlock* pages;
+            //! The bytes of the values behind a leaf block
+            std::vector<data_t> owned;
+        };
+        std::vector<BlockLoad> loads;
+        for (idx_t i = 0; i < allocators.size(); i++) {
+            std::vector<idx_t> ids;
+            std::vector<const CheckpointBlock*> pages;
+            for (auto& entry : state->blocks) {
+                if (entry.second.allocator == i) {
+                    ids.push_back(entry.first);
+                    pages.push_back(&entry.second);
+                }
+            }
+            auto headers = allocators[i]->LoadBlocks(ids);
+            for (idx_t b = 0; b < headers.size(); b++) {
+                loads.push_back({headers[b], pages[b], {}});
+            }
+        }
+
+        // the runs of pages of every block that are adjacent in the file, into the block or into
+        // its values
+        std::vector<CheckpointRead> reads;
+        for (auto& load : loads) {
+            auto block_size = allocators[load.pages->allocator]->GetBlockSize();
+            load.owned.resize(load.pages->pages.size() * SNAPSHOT_ALIGNMENT - block_size);
+            ForEachPageRun(*load.pages, [&](idx_t first, idx_t count, idx_t offset) {
+                auto begin = first * SNAPSHOT_ALIGNMENT;
+                auto end = begin + count * SNAPSHOT_ALIGNMENT;
+                if (begin < block_size) {
+                    reads.push_back({reinterpret_cast<char*>(load.block) + begin, MinValue(end, block_size) - begin,
+                                     offset});
+                }
+                if (end > block_size) {
+                    auto owned_begin = MaxValue(begin, block_size);
+                    reads.push_back({reinterpret_cast<char*>(load.owned.data()) + owned_begin - block_size,
+                                     end - owned_begin, offset + owned_begin - begin});
+                }
+            });
+        }
+        std::sort(reads.begin(), reads.end(),
+                  [](const CheckpointRead& l, const CheckpointRead& r) { return l.offset < r.offset; });
+
+        // the threads read runs of reads that are adjacent in the file
+        std::vector<SnapshotRun> runs;
+        for (idx_t i = 0; i < reads.size(); i++) {
+            auto& previous = reads[i > 0 ? i - 1 : 0];
+            if (runs.empty() || runs.back().block_count == SNAPSHOT_IO_BLOCKS ||
+                reads[i].offset - runs.back().offset >= SNAPSHOT_IO_SIZE ||
+                reads[i].offset != previous.offset + previous.size) {
+                runs.push_back({i, 0, reads[i].offset});
+            }
+            runs.back().block_count++;
+        }
+        ParallelFor(thread_count, runs.size(), [&](idx_t run_idx) {
+            auto& run = runs[run_idx];
+            iovec iov[SNAPSHOT_IO_BLOCKS];
+            for (idx_t i = 0; i < run.block_count; i++) {
+                auto& read = reads[run.first_block + i];
+                iov[i] = {read.target, read.size};
+            }
+            file.Read(iov, static_cast<int>(run.block_count), run.offset);
+        });
+
+        // point the values to their bytes, once all slabs are in memory
+        ParallelFor(thread_count, loads.size(), [&](idx_t i) {
+            auto& load = loads[i];
+            if (allocators[load.pages->allocator] != &leaf_allocator) {
+                return;
+            }
+            auto block_size = leaf_allocator.GetBlockSize();
+            leaf_allocator.ForEachSlot(load.block, [&](char* slot) {
+                auto& value = reinterpret_cast<Leaf*>(slot)->value;
+                if (value.IsInlined()) {
+                    return;
+                }
+                auto location = ValueArena::GetLocation(value);
+                if (ValueArena::IsOwned(value)) {
+                    if (location < block_size || location - block_size + value.GetSize() > load.owned.size()) {
+                        throw IOException(path + " is corrupt.");
+                    }
+                    auto bytes = new data_t[value.GetSize()];
+                    std::memcpy(bytes, load.owned.data() + (location - block_size), value.GetSize());
+                    ValueArena::SetBytes(value, bytes, Value::OWNED);
+                    return;
+                }
+                IndexPointer bytes_slot;
+                bytes_slot.Set(location);
+                auto block = state->blocks.find(bytes_slot.GetBlockId());
+                if (block == state->blocks.end() || block->second.allocator < this->allocators.size() ||
+                    bytes_slot.GetOffset() + value.GetSize() > allocators[block->second.allocator]->GetBlockSize()) {
+                    throw IOException(path + " is corrupt.");
+                }
+                ValueArena::SetBytes(value,
+                                     reinterpret_cast<data_ptr_t>(directory.Get(bytes_slot.GetBlockId())) +
+                                         bytes_slot.GetOffset(),
+                                     Value::ARENA);
+            });
+        });
+
+        // the loaded blocks are those of the checkpoint, the blocks that FinalizeLoad adds are not
+        for (auto& entry : state->blocks) {
+            directory.ClearDirty(entry.first);
+        }
+        for (auto allocator : allocators) {
+            allocator->FinalizeLoad();
+        }
+    } catch (...) {
+        // leave an empty tree behind
+        for (auto allocator : allocators) {
+            allocator->Reset();
+            allocator->FinalizeLoad();
+        }
+        *root = Node();
+        throw;
+    }
+    root->Set(root_bits);
+    checkpoint = std::move(state);
+    return file_size;
+}
+
+}  // namespace duckart
@@ -7,15 +7,14 @@ template <>
 Value Value::CreateValue(string_t value) {
     auto str_len = value.GetSize();
 
-    auto len = str_len + 1;
-    auto data = new data_t[len];
-    std::memcpy(data, value.GetData(), str_len);
+    Value result(str_len + 1);
+    std::memcpy(result.GetData(), value.GetData(), str_len);
     
      // keys must not be prefixes of other keys https://db.in.tum.de/~leis/papers/ART.pdf  
      // https://github.com/duckdb/duckdb/blob/main/src/execution/index/art/art_key.cpp#L46  
-    data[str_len] = '\0';
+    result[str_len] = '\0';
 
-    return Value(data, len);
+    return result;
 }
 
 template <>
@@ -41,39 +40,34 @@ void Value::CreateValue(Value& val, string_t value) {
 }
 
 bool Value::operator==(const Value &k) const {
-	if (len != k.len) {
+	if (GetSize() != k.GetSize()) {
 		return false;
 	}
-	for (uint32_t i = 0; i < len; i++) {
-		if (data[i] != k.data[i]) {
-			return false;
-		}
-	}
-	return true;
+	return std::memcmp(GetData(), k.GetData(), GetSize()) == 0;
 }
 
 //
 template <>
 string_t Value::ExtractValue(Value &val){
-     if (val.len == 0 || val.data == nullptr) {
+     if (val.GetSize() == 0) {
             return string_t("");  // Return an empty string if the Value is empty
         }
 
         // Subtract 1 from len to exclude the null terminator
-        size_t str_len = val.len - 1;
+        size_t str_len = val.GetSize() - 1;
 
         if (str_len <= 11) {
             // If the string fits in the inlined storage
-            return string_t(reinterpret_cast<const char*>(val.data));
+            return string_t(reinterpret_cast<const char*>(val.GetData()));
         } else {
             // If the string needs to use pointer storage
             string_t result("");  // Create an empty string_t
             result.value.pointer.length = str_len;
-            memcpy(result.value.pointer.prefix, val.data, 4);
+            memcpy(result.value.pointer.prefix, val.GetData(), 4);
             
             // Allocate new memory for the string content
             result.value.pointer.ptr = new char[str_len + 1];
-            memcpy(result.value.pointer.ptr, val.data, str_len);
+            memcpy(result.value.pointer.ptr, val.GetData(), str_len);
             result.value.pointer.ptr[str_len] = '\0';  // Ensure null-termination
 
             return result;
@@ -0,0 +1,148 @@
+/*
+g++ -std=c++20 -O2 -I./include test_ARTKey_01.cpp  artkey.cpp  node.cpp art.cpp node4.cpp node16.cpp node48.cpp node256.cpp prefix.cpp fixed_size_allocator.cpp leaf.cpp  value.cpp -o test_ARTKey_01.exe
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <random>
+#include <vector>
+
+#include "art.hpp"
+#include "artkey.hpp"
+#include "common.hpp"
+#include "leaf.hpp"
+#include "logger.hpp"
+#include "node.hpp"
+
+using namespace duckart;
+// Global logger instance
+Logger g_logger("duckart.log", Logger::ERROR);
+
+// counts the heap allocations of the test
+static idx_t allocations = 0;
+
+void *operator new(size_t size) {
+    allocations++;
+    if (auto ptr = std::malloc(size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { std::free(ptr); }
+
+int main() {
+    // a key builds its bytes once, and a view does not allocate
+    auto before = allocations;
+    auto owned = ARTKey::CreateARTKey<uint64_t>(42);
+    if (allocations - before != 1 || owned.IsView()) {
+        std::cout << "CreateARTKey allocated " << allocations - before << " times" << std::endl;
+        return 1;
+    }
+    before = allocations;
+    StackARTKey<uint64_t> stack_key(42);
+    auto view_copy = stack_key.Get();
+    if (allocations != before || !view_copy.IsView() || view_copy.data != stack_key.Get().data ||
+        !(view_copy == owned)) {
+        std::cout << "stack key is wrong" << std::endl;
+        return 1;
+    }
+    auto owned_copy = owned;
+    if (owned_copy.IsView() || owned_copy.data == owned.data || !(owned_copy == owned)) {
+        std::cout << "copy of an owning key is wrong" << std::endl;
+        return 1;
+    }
+    ARTKey reused;
+    ARTKey::CreateARTKey<uint64_t>(reused, 1);
+    auto reused_data = reused.data;
+    ARTKey::CreateARTKey<uint64_t>(reused, 42);
+    if (reused.data != reused_data || !(reused == owned)) {
+        std::cout << "CreateARTKey did not reuse the key" << std::endl;
+        return 1;
+    }
+
+    // string keys in a caller buffer
+    string_t str("a string longer than twelve bytes");
+    std::vector<data_t> buffer(ARTKey::GetKeyLength(str));
+    if (!(ARTKey::CreateARTKey<string_t>(buffer.data(), str) == ARTKey::CreateARTKey<string_t>(str)) ||
+        !(ARTKey::CreateARTKey<const char *>(buffer.data(), "abc") == ARTKey::CreateARTKey("abc"))) {
+        std::cout << "string key in a buffer is wrong" << std::endl;
+        return 1;
+    }
+
+    // a batch of keys shares one buffer
+    const idx_t count = 100000;
+    std::mt19937_64 rng(42);
+    std::vector<uint64_t> values(count);
+    for (auto &v : values) {
+        v = rng();
+    }
+    std::vector<data_t> batch(count * sizeof(uint64_t));
+    std::vector<ARTKey> keys;
+    keys.reserve(count);
+    for (idx_t i = 0; i < count; i++) {
+        keys.push_back(ARTKey::CreateARTKey<uint64_t>(batch.data() + i * sizeof(uint64_t), values[i]));
+    }
+
+    ART art;
+    for (idx_t i = 0; i < count; i++) {
+        Node leaf;
+        Leaf::NewInlined(art, leaf, i);
+        art.Insert(*art.root, keys[i], leaf, 0);
+    }
+
+    // point lookups and searches with stack keys do not touch the heap
+    before = allocations;
+    idx_t found = 0;
+    for (idx_t i = 0; i < count; i++) {
+        idx_t row_id;
+        StackARTKey<uint64_t> key(values[i]);
+        found += art.LookupRowId(key, row_id) && row_id == i;
+        found += Leaf::GetRowId(art.Search(*art.root, key, 0)) == i;
+    }
+    if (found != 2 * count || allocations != before) {
+        std::cout << "lookups found " << found << " keys with " << allocations - before << " allocations"
+                  << std::endl;
+        return 1;
+    }
+
+    const idx_t rounds = 5;
+    auto start = std::chrono::steady_clock::now();
+    idx_t sum = 0;
+    for (idx_t r = 0; r < rounds; r++) {
+        for (auto v : values) {
+            idx_t row_id;
+            art.LookupRowId(ARTKey::CreateARTKey<uint64_t>(v), row_id);
+            sum += row_id;
+        }
+    }
+    auto owned_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    for (idx_t r = 0; r < rounds; r++) {
+        for (auto v : values) {
+            idx_t row_id;
+            art.LookupRowId(StackARTKey<uint64_t>(v), row_id);
+            sum += row_id;
+        }
+    }
+    auto stack_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "owned keys: " << owned_ns / (rounds * count) << " ns/op stack keys: "
+              << stack_ns / (rounds * count) << " ns/op (" << sum % 10 << ")" << std::endl;
+
+    // deletes with views
+    for (idx_t i = 0; i < count; i++) {
+        if (!art.Delete(*art.root, keys[i], 0)) {
+            std::cout << "delete of key " << i << " failed" << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "ARTKey test passed" << std::endl;
+    return 0;
+}
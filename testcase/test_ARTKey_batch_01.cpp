@@ -0,0 +1,153 @@
+/*
+g++ -std=c++20 -O2 -I./include test_ARTKey_batch_01.cpp  artkey.cpp  node.cpp art.cpp node4.cpp node16.cpp node48.cpp node256.cpp prefix.cpp fixed_size_allocator.cpp leaf.cpp  value.cpp key_batch.cpp -o test_ARTKey_batch_01.exe
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "art.hpp"
+#include "artkey.hpp"
+#include "common.hpp"
+#include "key_batch.hpp"
+#include "leaf.hpp"
+#include "logger.hpp"
+#include "node.hpp"
+
+using namespace duckart;
+// Global logger instance
+Logger g_logger("duckart.log", Logger::ERROR);
+
+template <class T>
+static bool CheckColumn(const std::vector<T> &values) {
+    ARTKeyBatch batch(values.size());
+    batch.AddColumn<T>(values.data());
+    auto &keys = batch.Encode();
+    for (idx_t i = 0; i < values.size(); i++) {
+        if (!(keys[i] == ARTKey::CreateARTKey<T>(values[i]))) {
+            std::cout << "key " << i << " of a column of " << sizeof(T) << "-byte values is wrong" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Keys of column vectors, checked against CreateARTKey and against the order of the rows
+int main() {
+    const idx_t count = 100003;
+    std::mt19937_64 rng(42);
+    std::vector<int32_t> int32s(count);
+    std::vector<int64_t> int64s(count);
+    std::vector<uint64_t> uint64s(count);
+    std::vector<uint32_t> uint32s(count);
+    std::vector<int16_t> int16s(count);
+    std::vector<std::string> strs(count);
+    for (idx_t i = 0; i < count; i++) {
+        int32s[i] = static_cast<int32_t>(rng());
+        int64s[i] = static_cast<int64_t>(rng());
+        uint64s[i] = rng();
+        uint32s[i] = static_cast<uint32_t>(rng());
+        int16s[i] = static_cast<int16_t>(rng());
+        // short and long strings, with shared prefixes
+        strs[i] = std::string(rng() % 20, 'a' + rng() % 3) + std::to_string(rng() % 100);
+    }
+    int32s[0] = INT32_MIN;
+    int32s[1] = INT32_MAX;
+    int32s[2] = -1;
+    int64s[0] = INT64_MIN;
+    int64s[1] = INT64_MAX;
+    if (!CheckColumn(int32s) || !CheckColumn(int64s) || !CheckColumn(uint64s) || !CheckColumn(uint32s) ||
+        !CheckColumn(int16s)) {
+        return 1;
+    }
+
+    std::vector<string_t> strings;
+    strings.reserve(count);
+    for (auto &s : strs) {
+        strings.emplace_back(s.c_str());
+    }
+
+    // composite keys compare like their rows
+    ARTKeyBatch batch(count);
+    batch.AddColumn<int32_t>(int32s.data());
+    batch.AddColumn(strings.data());
+    batch.AddColumn<int64_t>(int64s.data());
+    auto &keys = batch.Encode();
+    for (idx_t i = 0; i < count; i++) {
+        auto s = ARTKey::CreateARTKey<string_t>(strings[i]);
+        ARTKey expected(static_cast<uint32_t>(4 + s.len + 8));
+        Radix::EncodeData<int32_t>(expected.data, int32s[i]);
+        std::memcpy(expected.data + 4, s.data, s.len);
+        Radix::EncodeData<int64_t>(expected.data + 4 + s.len, int64s[i]);
+        if (!(keys[i] == expected)) {
+            std::cout << "composite key " << i << " is wrong" << std::endl;
+            return 1;
+        }
+    }
+    for (idx_t i = 0; i + 1 < count; i++) {
+        auto lhs = std::make_tuple(int32s[i], strs[i], int64s[i]);
+        auto rhs = std::make_tuple(int32s[i + 1], strs[i + 1], int64s[i + 1]);
+        if ((lhs > rhs) != (keys[i] > keys[i + 1])) {
+            std::cout << "composite keys " << i << " and " << i + 1 << " are out of order" << std::endl;
+            return 1;
+        }
+    }
+
+    // composite fixed-width keys take the strided path
+    batch.Reset(count);
+    batch.AddColumn<uint32_t>(uint32s.data());
+    batch.AddColumn<int64_t>(int64s.data());
+    batch.AddColumn<int16_t>(int16s.data());
+    auto &fixed = batch.Encode();
+    for (idx_t i = 0; i < count; i++) {
+        data_t expected[14];
+        Radix::EncodeData<uint32_t>(expected, uint32s[i]);
+        Radix::EncodeData<int64_t>(expected + 4, int64s[i]);
+        Radix::EncodeData<int16_t>(expected + 12, int16s[i]);
+        if (!(fixed[i] == ARTKey::View(expected, 14))) {
+            std::cout << "fixed-width composite key " << i << " is wrong" << std::endl;
+            return 1;
+        }
+    }
+
+    // the batch encoder against one key at a time, and against the probes of the keys
+    ART art;
+    for (idx_t i = 0; i < count; i++) {
+        Node leaf;
+        Leaf::NewInlined(art, leaf, i);
+        art.Insert(*art.root, ARTKey::CreateARTKey<int64_t>(int64s[i]), leaf, 0);
+    }
+    const idx_t rounds = 20;
+    idx_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (idx_t r = 0; r < rounds; r++) {
+        for (auto v : int64s) {
+            sum += ARTKey::CreateARTKey<int64_t>(v).data[7];
+        }
+    }
+    auto single_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    for (idx_t r = 0; r < rounds; r++) {
+        batch.Reset(count);
+        batch.AddColumn<int64_t>(int64s.data());
+        sum += batch.Encode()[r][7];
+    }
+    auto batch_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    for (auto &key : batch.Encode()) {
+        idx_t row_id;
+        art.LookupRowId(key, row_id);
+        sum += row_id;
+    }
+    auto probe_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "CreateARTKey: " << single_ns / (rounds * count) << " ns/key ARTKeyBatch: "
+              << batch_ns / (rounds * count) << " ns/key LookupRowId: " << probe_ns / count << " ns/key ("
+              << sum % 10 << ")" << std::endl;
+
+    std::cout << "key batch test passed" << std::endl;
+    return 0;
+}
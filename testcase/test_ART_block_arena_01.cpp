@@ -0,0 +1,116 @@
+/*
+g++ -std=c++20 -O2 -I./include test_ART_block_arena_01.cpp  artkey.cpp  node.cpp art.cpp node4.cpp node16.cpp node48.cpp node256.cpp prefix.cpp fixed_size_allocator.cpp leaf.cpp  value.cpp iterator.cpp row_id_set.cpp -o test_ART_block_arena_01.exe -lpthread
+./test_ART_block_arena_01.exe [key count]
+*/
+
+#include <unistd.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "art.hpp"
+#include "artkey.hpp"
+#include "common.hpp"
+#include "leaf.hpp"
+#include "logger.hpp"
+#include "value.hpp"
+
+using namespace duckart;
+// Global logger instance
+Logger g_logger("duckart.log", Logger::ERROR);
+
+//! Number of memory mappings of the process
+static idx_t CountMappings() {
+    std::ifstream maps("/proc/self/maps");
+    std::string line;
+    idx_t count = 0;
+    while (std::getline(maps, line)) {
+        count++;
+    }
+    return count;
+}
+
+//! Bytes of the process that are in memory
+static idx_t GetResidentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    idx_t size = 0, resident = 0;
+    statm >> size >> resident;
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+//! Bytes of the blocks of all node allocators
+static idx_t GetBlockBytes(const ART &art) {
+    idx_t bytes = 0;
+    for (auto &allocator : art.allocators) {
+        bytes += allocator->GetBlockCount() * allocator->GetBlockSize();
+    }
+    return bytes;
+}
+
+static void InsertAll(ART &art, const std::vector<uint64_t> &keys) {
+    for (auto n : keys) {
+        Node leaf;
+        Leaf::New(art, leaf, Value::CreateValue(n));
+        art.Insert(*art.root, ARTKey::CreateARTKey<uint64_t>(n), leaf, 0);
+    }
+}
+
+static void DeleteAll(ART &art, const std::vector<uint64_t> &keys) {
+    for (auto n : keys) {
+        art.Delete(*art.root, ARTKey::CreateARTKey<uint64_t>(n), 0);
+    }
+}
+
+// The blocks of a tree come from a few large arenas instead of a mapping each, released
+// blocks give their pages back to the OS, and new blocks reuse them
+int main(int argc, char **argv) {
+    const idx_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    std::mt19937_64 rng(42);
+    std::vector<uint64_t> keys(count);
+    for (auto &key : keys) {
+        key = rng();
+    }
+
+    ART art;
+    auto mappings = CountMappings();
+    InsertAll(art, keys);
+    auto block_bytes = GetBlockBytes(art);
+    auto full_mappings = CountMappings();
+    auto full_resident = GetResidentBytes();
+    // one arena per block size, and one more for every ARENA_SIZE bytes of blocks
+    if (full_mappings > mappings + art.allocators.size() + block_bytes / (64 << 20) + 8) {
+        std::cout << "the blocks take " << full_mappings - mappings << " mappings" << std::endl;
+        return 1;
+    }
+
+    DeleteAll(art, keys);
+    auto empty_resident = GetResidentBytes();
+    if (full_resident < empty_resident + block_bytes / 2) {
+        std::cout << "deleting all keys frees " << (full_resident - empty_resident) / 1024 << " KiB of "
+                  << block_bytes / 1024 << " KiB of blocks" << std::endl;
+        return 1;
+    }
+
+    InsertAll(art, keys);
+    for (idx_t i = 0; i < count; i += 101) {
+        auto value = art.Lookup(ARTKey::CreateARTKey<uint64_t>(keys[i]));
+        if (!value || !(*value == Value::CreateValue(keys[i]))) {
+            std::cout << "key " << i << " is wrong after reusing the blocks" << std::endl;
+            return 1;
+        }
+    }
+    if (CountMappings() > full_mappings) {
+        std::cout << "the reinserted keys take " << CountMappings() - full_mappings << " more mappings" << std::endl;
+        return 1;
+    }
+
+    std::cout << count << " keys, " << block_bytes / (1024 * 1024) << " MiB of blocks in "
+              << full_mappings - mappings << " more mappings, " << (full_resident - empty_resident) / (1024 * 1024)
+              << " MiB released" << std::endl;
+    std::cout << "block arena test passed" << std::endl;
+    return 0;
+}
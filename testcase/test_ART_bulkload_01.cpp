@@ -0,0 +1,92 @@
+/*
+g++ -std=c++20 -O2 -I./include test_ART_bulkload_01.cpp  artkey.cpp  node.cpp art.cpp node4.cpp node16.cpp node48.cpp node256.cpp prefix.cpp fixed_size_allocator.cpp leaf.cpp  value.cpp -o test_ART_bulkload_01.exe
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "art.hpp"
+#include "artkey.hpp"
+#include "common.hpp"
+#include "leaf.hpp"
+#include "logger.hpp"
+#include "node.hpp"
+#include "value.hpp"
+
+using namespace duckart;
+// Global logger instance
+Logger g_logger("duckart.log", Logger::ERROR);
+
+// Compares building a tree with BulkLoad to building it with one Insert per key
+int main() {
+    const idx_t count = 2000000;
+
+    std::mt19937_64 rng(42);
+    std::vector<uint64_t> numbers(count);
+    for (auto &n : numbers) {
+        n = rng();
+    }
+    std::sort(numbers.begin(), numbers.end());
+    numbers.erase(std::unique(numbers.begin(), numbers.end()), numbers.end());
+
+    std::vector<ARTKey> keys;
+    std::vector<Value> values;
+    keys.reserve(numbers.size());
+    values.reserve(numbers.size());
+    for (auto n : numbers) {
+        keys.push_back(ARTKey::CreateARTKey<uint64_t>(n));
+        values.push_back(Value::CreateValue(n));
+    }
+
+    // Insert in table order (random) and in key order
+    std::vector<idx_t> order(keys.size());
+    for (idx_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), rng);
+
+    auto start = std::chrono::steady_clock::now();
+    ART bulk_art;
+    bulk_art.BulkLoad(keys, values);
+    auto bulk_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    ART insert_art;
+    for (auto i : order) {
+        Node leaf;
+        Leaf::New(insert_art, leaf, values[i]);
+        insert_art.Insert(*insert_art.root, keys[i], leaf, 0);
+    }
+    auto insert_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    ART sorted_art;
+    for (idx_t i = 0; i < keys.size(); i++) {
+        Node leaf;
+        Leaf::New(sorted_art, leaf, values[i]);
+        sorted_art.Insert(*sorted_art.root, keys[i], leaf, 0);
+    }
+    auto sorted_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // both trees must hold the same keys and values
+    for (idx_t i = 0; i < keys.size(); i++) {
+        auto value = bulk_art.Lookup(keys[i]);
+        if (!value || !(*value == values[i]) || !insert_art.Lookup(keys[i])) {
+            std::cout << "key " << i << " is missing" << std::endl;
+            return 1;
+        }
+    }
+    for (int type = 2; type <= 5; type++) {
+        std::cout << "node type " << type << ": insert " << insert_art.GetAllocator(NType(type)).GetUsed()
+                  << ", bulk load " << bulk_art.GetAllocator(NType(type)).GetUsed() << std::endl;
+    }
+
+    std::cout << "keys: " << keys.size() << std::endl;
+    std::cout << "Insert (random order): " << insert_ms << " ms, " << keys.size() / insert_ms / 1000 << " M keys/s" << std::endl;
+    std::cout << "Insert (key order): " << sorted_ms << " ms, " << keys.size() / sorted_ms / 1000 << " M keys/s" << std::endl;
+    std::cout << "BulkLoad: " << bulk_ms << " ms, " << keys.size() / bulk_ms / 1000 << " M keys/s" << std::endl;
+    return 0;
+}
@@ -0,0 +1,274 @@
+/*
+g++ -std=c++20 -O2 -I./include test_ART_checkpoint_01.cpp  artkey.cpp  node.cpp art.cpp node4.cpp node16.cpp node48.cpp node256.cpp prefix.cpp fixed_size_allocator.cpp leaf.cpp  value.cpp iterator.cpp row_id_set.cpp snapshot.cpp -o test_ART_checkpoint_01.exe -lpthread
+./test_ART_checkpoint_01.exe [key count]
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "art.hpp"
+#include "artkey.hpp"
+#include "common.hpp"
+#include "exception.hpp"
+#include "iterator.hpp"
+#include "leaf.hpp"
+#include "logger.hpp"
+#include "value.hpp"
+
+using namespace duckart;
+// Global logger instance
+Logger g_logger("duckart.log", Logger::ERROR);
+
+static const char *CHECKPOINT_PATH = "test_ART_checkpoint_01.bin";
+
+static double ElapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+//! Mostly inlined values, every 64th value lives in the value arena, and every 4096th is larger
+//! than the arena slabs
+static Value MakeValue(uint64_t n, uint64_t version) {
+    if (n % 4096 == 0 || n % 64 == 0) {
+        Value value(n % 4096 == 0 ? 5000 : 100);
+        for (idx_t b = 0; b < value.GetSize(); b++) {
+            value[b] = static_cast<data_t>((n + version) >> (b % 8));
+        }
+        return value;
+    }
+    return Value::CreateValue(n + version);
+}
+
+//! Loads the checkpoint into a new tree, and compares it with the expected keys and values
+static bool CheckLoad(const std::unordered_map<uint64_t, uint64_t> &expected, idx_t &bytes) {
+    ART loaded;
+    bytes = loaded.LoadCheckpoint(CHECKPOINT_PATH);
+    idx_t count = 0;
+    ART::Iterator it(loaded);
+    for (auto valid = it.First(); valid; valid = it.Next()) {
+        count++;
+    }
+    if (count != expected.size()) {
+        std::cout << "the checkpoint holds " << count << " keys, expected " << expected.size() << std::endl;
+        return false;
+    }
+    for (auto &entry : expected) {
+        auto value = loaded.Lookup(ARTKey::CreateARTKey<uint64_t>(entry.first));
+        if (!value || !(*value == MakeValue(entry.first, entry.second))) {
+            std::cout << "key " << entry.first << " has the wrong value in the checkpoint" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static void Put(ART &art, uint64_t n, uint64_t version) {
+    Node leaf;
+    Leaf::New(art, leaf, MakeValue(n, version));
+    art.Insert(*art.root, ARTKey::CreateARTKey<uint64_t>(n), leaf, 0);
+}
+
+// The row ids of non-unique keys survive checkpoints, and a loaded tree checkpoints
+// incrementally into the file that it was loaded from
+static bool CheckRowIds() {
+    std::remove(CHECKPOINT_PATH);
+    {
+        ART art;
+        for (uint32_t k = 0; k < 100; k++) {
+            for (idx_t row_id = 0; row_id < k * 3; row_id++) {
+                art.AddRowId(ARTKey::CreateARTKey<uint32_t>(k), row_id * 7 + k);
+            }
+        }
+        art.Checkpoint(CHECKPOINT_PATH);
+    }
+    {
+        ART art;
+        art.LoadCheckpoint(CHECKPOINT_PATH);
+        art.AddRowId(ARTKey::CreateARTKey<uint32_t>(1000), 1);
+        // grows the array of key 5 in place, which only changes its slab
+        art.AddRowId(ARTKey::CreateARTKey<uint32_t>(5), 1000);
+        art.RemoveRowId(ARTKey::CreateARTKey<uint32_t>(99), 99 * 7 + 99);
+        art.Checkpoint(CHECKPOINT_PATH);
+    }
+    ART loaded;
+    loaded.LoadCheckpoint(CHECKPOINT_PATH);
+    for (uint32_t k = 0; k < 100; k++) {
+        std::vector<idx_t> expected;
+        for (idx_t row_id = 0; row_id < k * 3; row_id++) {
+            if (k != 99 || row_id != 99) {
+                expected.push_back(row_id * 7 + k);
+            }
+        }
+        if (k == 5) {
+            expected.push_back(1000);
+        }
+        idx_t pos = 0;
+        auto count = loaded.ScanRowIds(ARTKey::CreateARTKey<uint32_t>(k), [&](idx_t row_id) {
+            return pos < expected.size() && row_id == expected[pos++];
+        });
+        if (count != expected.size() || pos != expected.size()) {
+            std::cout << "the row ids of key " << k << " are wrong after the checkpoint" << std::endl;
+            return false;
+        }
+    }
+    idx_t row_id;
+    return loaded.LookupRowId(ARTKey::CreateARTKey<uint32_t>(1000), row_id) && row_id == 1;
+}
+
+// Reads do not dirty blocks, so a checkpoint after them writes only its root record, which takes
+// one page, and the header
+static bool CheckReadsStayClean() {
+    std::remove(CHECKPOINT_PATH);
+    ART art;
+    std::mt19937_64 rng(7);
+    std::vector<uint64_t> keys;
+    for (idx_t i = 0; i < 20000; i++) {
+        keys.push_back(rng());
+        Put(art, keys.back(), 0);
+    }
+    art.Checkpoint(CHECKPOINT_PATH);
+    for (auto k : keys) {
+        auto key = ARTKey::CreateARTKey<uint64_t>(k);
+        if (!art.Lookup(key) || art.Search(*art.root, key, 0).IsCleared()) {
+            std::cout << "key " << k << " is missing before the checkpoint" << std::endl;
+            return false;
+        }
+        // keys that share the prefix of k, but are not in the tree
+        art.Search(*art.root, ARTKey::CreateARTKey<uint64_t>(k ^ 1), 0);
+        art.Delete(*art.root, ARTKey::CreateARTKey<uint64_t>(k ^ 1), 0);
+    }
+    ART::Iterator it(art);
+    for (auto valid = it.First(); valid; valid = it.Next()) {
+    }
+    auto bytes = art.Checkpoint(CHECKPOINT_PATH);
+    if (bytes >= 2 * 4096) {
+        std::cout << "a checkpoint after reads writes " << bytes << " bytes" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Files that are not checkpoints are rejected, and mapped trees are not checkpointed
+static bool CheckErrors() {
+    auto file = std::fopen(CHECKPOINT_PATH, "wb");
+    for (int i = 0; i < 1000; i++) {
+        std::fputs("not a checkpoint ", file);
+    }
+    std::fclose(file);
+    ART art;
+    try {
+        art.LoadCheckpoint(CHECKPOINT_PATH);
+        std::cout << "a file without checkpoint header is loaded" << std::endl;
+        return false;
+    } catch (IOException &) {
+    }
+
+    Put(art, 1, 0);
+    art.Serialize(CHECKPOINT_PATH);
+    ART mapped;
+    mapped.Map(CHECKPOINT_PATH);
+    try {
+        mapped.Checkpoint(CHECKPOINT_PATH);
+        std::cout << "a mapped tree is checkpointed" << std::endl;
+        return false;
+    } catch (InternalException &) {
+    }
+    return true;
+}
+
+// Checkpoints after small batches of changes write a fraction of the tree, and each one loads
+// back as the tree it was taken from
+int main(int argc, char **argv) {
+    if (!CheckRowIds() || !CheckReadsStayClean() || !CheckErrors()) {
+        return 1;
+    }
+    std::remove(CHECKPOINT_PATH);
+
+    const idx_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    std::mt19937_64 rng(42);
+    std::unordered_map<uint64_t, uint64_t> expected;
+    std::vector<uint64_t> keys;
+    ART art;
+    while (keys.size() < count) {
+        auto n = rng();
+        if (expected.emplace(n, 0).second) {
+            keys.push_back(n);
+            Put(art, n, 0);
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    auto full_bytes = art.Checkpoint(CHECKPOINT_PATH);
+    auto full_ms = ElapsedMs(start);
+    idx_t file_bytes;
+    if (!CheckLoad(expected, file_bytes)) {
+        return 1;
+    }
+    std::cout << count << " keys, full checkpoint: " << full_bytes / (1024.0 * 1024.0) << " MiB, " << full_ms
+              << " ms" << std::endl;
+
+    // every round appends 1% new keys in key order, as time-ordered keys are, and updates and
+    // deletes 0.01% of the keys at random. Random changes dirty a few pages each (the leaf, the
+    // node above it, and the headers of their blocks), appended keys fill new blocks. So a round
+    // writes at most twice the share of the appended keys of the tree, and 6 pages per random
+    // change, besides the root record
+    const idx_t rounds = 6;
+    const idx_t appends = MaxValue<idx_t>(count / 100, 10);
+    const idx_t changes = MaxValue<idx_t>(count / 10000, 1);
+    const idx_t max_bytes = 2 * full_bytes * appends / count + 2 * changes * 6 * 4096 + 64 * 1024;
+    uint64_t next_key = ~uint64_t(0) - rounds * appends;
+    for (idx_t round = 1; round <= rounds; round++) {
+        for (idx_t i = 0; i < appends; i++, next_key++) {
+            if (expected.emplace(next_key, round).second) {
+                Put(art, next_key, round);
+            }
+        }
+        for (idx_t i = 0; i < changes; i++) {
+            auto k = keys[rng() % keys.size()];
+            if (expected.count(k)) {
+                expected[k] = round;
+                Put(art, k, round);
+            }
+            k = keys[rng() % keys.size()];
+            if (expected.erase(k)) {
+                art.Delete(*art.root, ARTKey::CreateARTKey<uint64_t>(k), 0);
+            }
+        }
+        start = std::chrono::steady_clock::now();
+        auto bytes = art.Checkpoint(CHECKPOINT_PATH);
+        auto ms = ElapsedMs(start);
+        if (!CheckLoad(expected, file_bytes)) {
+            return 1;
+        }
+        std::cout << "round " << round << ": " << appends + 2 * changes << " changes, checkpoint " << bytes / 1024.0 << " KiB ("
+                  << 100.0 * bytes / full_bytes << "% of the full checkpoint), " << ms << " ms, file "
+                  << file_bytes / (1024.0 * 1024.0) << " MiB" << std::endl;
+        if (bytes > max_bytes) {
+            std::cout << "the checkpoint writes more than the " << max_bytes / 1024.0 << " KiB that changed"
+                      << std::endl;
+            return 1;
+        }
+    }
+
+    // a tree loaded from the checkpoint continues it
+    {
+        ART loaded;
+        loaded.LoadCheckpoint(CHECKPOINT_PATH);
+        auto n = keys[0] | 1;
+        expected[n] = 100;
+        Put(loaded, n, 100);
+        auto bytes = loaded.Checkpoint(CHECKPOINT_PATH);
+        if (bytes > max_bytes || !CheckLoad(expected, file_bytes)) {
+            std::cout << "the loaded tree does not continue the checkpoint" << std::endl;
+            return 1;
+        }
+    }
+    std::remove(CHECKPOINT_PATH);
+    std::cout << "checkpoint test passed" << std::endl;
+    return 0;
+}
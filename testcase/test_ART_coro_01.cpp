@@ -0,0 +1,191 @@
+/*
+g++ -std=c++20 -O2 -I./include test_ART_coro_01.cpp  artkey.cpp  node.cpp art.cpp node4.cpp node16.cpp node48.cpp node256.cpp prefix.cpp fixed_size_allocator.cpp leaf.cpp  value.cpp row_id_set.cpp key_batch.cpp -o test_ART_coro_01.exe
+./test_ART_coro_01.exe [key count]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "art.hpp"
+#include "artkey.hpp"
+#include "common.hpp"
+#include "coro.hpp"
+#include "key_batch.hpp"
+#include "leaf.hpp"
+#include "logger.hpp"
+#include "node.hpp"
+#include "value.hpp"
+
+using namespace duckart;
+// Global logger instance
+Logger g_logger("duckart.log", Logger::ERROR);
+
+// Other memory-bound work: sums count random elements of values, with a prefetch ahead of
+// every read
+static CoroTask SumRandom(const std::vector<uint64_t> &values, uint64_t seed, idx_t count, uint64_t &sum) {
+    sum = 0;
+    auto pos = seed % values.size();
+    for (idx_t i = 0; i < count; i++) {
+        co_await Prefetch{&values[pos]};
+        sum += values[pos];
+        pos = (pos * 6364136223846793005ULL + 1442695040888963407ULL) % values.size();
+    }
+}
+
+// LookupTask against Lookup and LookupRowId on trees of string keys, with Leaf values,
+// prefix chains and row id sets, interleaved with other tasks on one scheduler
+static bool CheckStrings() {
+    std::mt19937_64 rng(7);
+    std::vector<std::string> strs;
+    for (idx_t i = 0; i < 20000; i++) {
+        strs.push_back(std::string(rng() % 40, 'a' + rng() % 2) + std::to_string(rng() % 1000));
+    }
+    ART values;
+    ART row_ids;
+    for (idx_t i = 0; i < strs.size(); i++) {
+        auto key = ARTKey::CreateARTKey(strs[i].c_str());
+        if (i % 2 == 0) {
+            Node leaf;
+            Leaf::New(values, leaf, Value::CreateValue<uint64_t>(i));
+            values.Insert(*values.root, key, leaf, 0);
+        }
+        row_ids.AddRowId(key, i);
+        if (i % 3 == 0) {
+            row_ids.AddRowId(key, i + 1);
+        }
+    }
+    std::vector<ARTKey> keys;
+    for (auto &s : strs) {
+        keys.push_back(ARTKey::CreateARTKey(s.c_str()));
+        keys.push_back(ARTKey::CreateARTKey((s + "x").c_str()));
+    }
+
+    std::vector<uint64_t> array(1 << 20);
+    for (idx_t i = 0; i < array.size(); i++) {
+        array[i] = i;
+    }
+    const idx_t slots = 8;
+    std::vector<Node> value_leaves(keys.size());
+    std::vector<Node> row_id_leaves(keys.size());
+    std::vector<uint64_t> sums(keys.size());
+    idx_t next = 0;
+    CoroScheduler scheduler(slots);
+    scheduler.Run([&](idx_t, CoroTask &task) {
+        // two lookups for every other task
+        if (next >= 3 * keys.size()) {
+            return false;
+        }
+        auto i = next / 3;
+        switch (next++ % 3) {
+            case 0:
+                task = values.LookupTask(keys[i], value_leaves[i]);
+                break;
+            case 1:
+                task = row_ids.LookupTask(keys[i], row_id_leaves[i]);
+                break;
+            default:
+                task = SumRandom(array, i, 10, sums[i]);
+                break;
+        }
+        return true;
+    });
+
+    for (idx_t i = 0; i < keys.size(); i++) {
+        auto value = Leaf::HasValue(value_leaves[i])
+                         ? &values.GetAllocator(NType::LEAF).Get<const Leaf>(value_leaves[i])->value
+                         : nullptr;
+        idx_t row_id;
+        auto has_row_id = row_ids.LookupRowId(keys[i], row_id);
+        auto &leaf = row_id_leaves[i];
+        auto inlined = leaf.getTag() == NType::LEAF_INLINED && !leaf.IsCleared() && !leaf.IsGate();
+        auto row_id_count = row_ids.ScanRowIds(keys[i], [](idx_t) { return true; });
+        if (value != values.Lookup(keys[i]) || inlined != has_row_id || (inlined && Leaf::GetRowId(leaf) != row_id) ||
+            (row_id_count > 1) != leaf.IsGate()) {
+            std::cout << "lookup task of string key " << i << " is wrong" << std::endl;
+            return false;
+        }
+    }
+    for (idx_t i = 0; i < keys.size(); i++) {
+        uint64_t expected = 0;
+        auto pos = i % array.size();
+        for (idx_t j = 0; j < 10; j++) {
+            expected += array[pos];
+            pos = (pos * 6364136223846793005ULL + 1442695040888963407ULL) % array.size();
+        }
+        if (sums[i] != expected) {
+            std::cout << "interleaved task " << i << " is wrong" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Probes of a tree far larger than the last-level cache: one key at a time, hand-coded
+// batches, and coroutines
+int main(int argc, char **argv) {
+    if (!CheckStrings()) {
+        return 1;
+    }
+
+    const idx_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 8000000;
+    const idx_t vector_size = 2048;
+    std::mt19937_64 rng(42);
+    std::vector<uint64_t> values(count);
+    for (auto &v : values) {
+        v = rng();
+    }
+    ART art;
+    for (idx_t i = 0; i < count; i++) {
+        Node leaf;
+        Leaf::NewInlined(art, leaf, i);
+        art.Insert(*art.root, StackARTKey<uint64_t>(values[i]), leaf, 0);
+    }
+    std::vector<uint64_t> probes(values);
+    for (idx_t i = 0; i < count / 4; i++) {
+        probes.push_back(rng());
+    }
+    std::shuffle(probes.begin(), probes.end(), rng);
+    ARTKeyBatch batch(probes.size());
+    batch.AddColumn<uint64_t>(probes.data());
+    auto &keys = batch.Encode();
+
+    std::vector<idx_t> single(keys.size());
+    auto start = std::chrono::steady_clock::now();
+    for (idx_t i = 0; i < keys.size(); i++) {
+        if (!art.LookupRowId(keys[i], single[i])) {
+            single[i] = INVALID_INDEX;
+        }
+    }
+    auto single_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<idx_t> batched(keys.size());
+    start = std::chrono::steady_clock::now();
+    for (idx_t i = 0; i < keys.size(); i += vector_size) {
+        art.LookupRowIdBatch(keys.data() + i, MinValue(vector_size, keys.size() - i), batched.data() + i);
+    }
+    auto batch_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<idx_t> coro(keys.size());
+    idx_t found = 0;
+    start = std::chrono::steady_clock::now();
+    for (idx_t i = 0; i < keys.size(); i += vector_size) {
+        found += art.LookupRowIdCoro(keys.data() + i, MinValue(vector_size, keys.size() - i), coro.data() + i);
+    }
+    auto coro_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    if (batched != single || coro != single || found != count) {
+        std::cout << "coroutine lookups differ from single lookups" << std::endl;
+        return 1;
+    }
+    std::cout << count << " keys, LookupRowId: " << single_ns / keys.size()
+              << " ns/op LookupRowIdBatch: " << batch_ns / keys.size() << " ns/op LookupRowIdCoro: "
+              << coro_ns / keys.size() << " ns/op" << std::endl;
+
+    std::cout << "coroutine lookup test passed" << std::endl;
+    return 0;
+}
@@ -42,7 +42,7 @@ int main() {
     Value value1 =  Value::CreateValue(test_uint32);
     Leaf& leaf = Leaf::New(art, ref_leaf, value1);
 
-    node = art.root.get();
+    node = *art.root;
     std::cout << "before insert: Node type:" << static_cast<int>(node.getTag())
               << std::endl;
 
@@ -0,0 +1,144 @@
+/*
+g++ -std=c++20 -O2 -I./include test_ART_index_pointer_01.cpp  artkey.cpp  node.cpp art.cpp node4.cpp node16.cpp node48.cpp node256.cpp prefix.cpp fixed_size_allocator.cpp leaf.cpp  value.cpp iterator.cpp row_id_set.cpp -o test_ART_index_pointer_01.exe -lpthread
+./test_ART_index_pointer_01.exe [key count]
+*/
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "art.hpp"
+#include "artkey.hpp"
+#include "common.hpp"
+#include "fixed_size_allocator.hpp"
+#include "index_pointer.hpp"
+#include "leaf.hpp"
+#include "logger.hpp"
+#include "node.hpp"
+#include "node4.hpp"
+#include "value.hpp"
+
+using namespace duckart;
+// Global logger instance
+Logger g_logger("duckart.log", Logger::ERROR);
+
+// The block id, offset, tag and gate bit of a pointer do not overlap
+static bool CheckLayout() {
+    IndexPointer ptr(IndexPointer::MAX_BLOCK_ID, IndexPointer::MAX_OFFSET, NType::NODE_256);
+    ptr.SetGate(true);
+    if (ptr.GetBlockId() != IndexPointer::MAX_BLOCK_ID || ptr.GetOffset() != IndexPointer::MAX_OFFSET ||
+        ptr.getTag() != NType::NODE_256 || !ptr.IsGate()) {
+        std::cout << "the fields of a pointer overlap" << std::endl;
+        return false;
+    }
+    // tags beyond those of NType fit, for new node types
+    auto tag = static_cast<NType>(IndexPointer::MAX_TAG);
+    IndexPointer wide(IndexPointer::MAX_BLOCK_ID, IndexPointer::MAX_OFFSET, tag);
+    if (IndexPointer::MAX_TAG < 255 || wide.GetBlockId() != IndexPointer::MAX_BLOCK_ID ||
+        wide.GetOffset() != IndexPointer::MAX_OFFSET || wide.getTag() != tag || wide.IsGate()) {
+        std::cout << "the tag overlaps the other fields" << std::endl;
+        return false;
+    }
+    IndexPointer other(IndexPointer::MAX_BLOCK_ID, IndexPointer::MAX_OFFSET, NType::NODE_4);
+    if (!ptr.SameSlot(other) || ptr.SameSlot(IndexPointer(1, IndexPointer::MAX_OFFSET, NType::NODE_256))) {
+        std::cout << "SameSlot compares more than the slot" << std::endl;
+        return false;
+    }
+    Node leaf;
+    leaf.SetPayload(IndexPointer::MAX_PAYLOAD, NType::LEAF_INLINED);
+    if (leaf.GetPayload() != IndexPointer::MAX_PAYLOAD || leaf.getTag() != NType::LEAF_INLINED) {
+        std::cout << "the payload does not survive the pointer" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Every allocator of a tree resolves the pointers of every other one
+static bool CheckSharedDirectory() {
+    ART art;
+    Node node;
+    auto &n4 = Node4::New(art, node);
+    if (art.GetAllocator(NType::LEAF).Get<Node4>(node) != &n4 ||
+        art.GetPrefixAllocator(PREFIX_SEGMENT_CLASSES - 1).Get<Node4>(node) != &n4) {
+        std::cout << "the allocators of a tree do not share the block directory" << std::endl;
+        return false;
+    }
+    Node::Free(art, node);
+    return true;
+}
+
+static bool CheckLookups(const ART &art, const std::vector<ARTKey> &keys, const std::vector<Value> &values,
+                         idx_t begin) {
+    for (idx_t i = begin; i < keys.size(); i++) {
+        auto value = art.Lookup(keys[i]);
+        if (!value || !(*value == values[i])) {
+            std::cout << "key " << i << " is missing" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// The subtrees of ParallelBuild keep their block ids when the tree adopts them, and the pointers
+// that Vacuum rewrites resolve to the moved nodes
+int main(int argc, char **argv) {
+    if (!CheckLayout() || !CheckSharedDirectory()) {
+        return 1;
+    }
+
+    const idx_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    std::mt19937_64 rng(42);
+    std::unordered_set<uint64_t> seen;
+    std::vector<ARTKey> keys;
+    std::vector<Value> values;
+    while (keys.size() < count) {
+        auto n = rng();
+        if (seen.insert(n).second) {
+            keys.push_back(ARTKey::CreateARTKey<uint64_t>(n));
+            values.push_back(Value::CreateValue(n));
+        }
+    }
+
+    ART art;
+    art.ParallelBuild(keys, values, 4);
+    if (!CheckLookups(art, keys, values, 0)) {
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (auto &key : keys) {
+        if (!art.Lookup(key)) {
+            return 1;
+        }
+    }
+    auto lookup_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    // delete most keys, so that vacuum moves nodes out of sparse blocks
+    for (idx_t i = 0; i < count * 3 / 4; i++) {
+        art.Delete(*art.root, keys[i], 0);
+    }
+    auto blocks = art.GetAllocator(NType::LEAF).GetBlockCount();
+    while (!art.Vacuum(10000)) {
+    }
+    if (art.GetAllocator(NType::LEAF).GetBlockCount() >= blocks) {
+        std::cout << "vacuum releases no blocks" << std::endl;
+        return 1;
+    }
+    if (!CheckLookups(art, keys, values, count * 3 / 4)) {
+        return 1;
+    }
+    for (idx_t i = 0; i < count * 3 / 4; i += 97) {
+        if (art.Lookup(keys[i])) {
+            std::cout << "deleted key " << i << " is found" << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << count << " keys, Lookup: " << lookup_ns / count << " ns/op, "
+              << art.GetDirectory()->GetIdCount() << " block ids" << std::endl;
+    std::cout << "index pointer test passed" << std::endl;
+    return 0;
+}
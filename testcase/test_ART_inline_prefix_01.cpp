@@ -0,0 +1,146 @@
+/*
+g++ -std=c++20 -O2 -I./include test_ART_inline_prefix_01.cpp  artkey.cpp  node.cpp art.cpp node4.cpp node16.cpp node48.cpp node256.cpp prefix.cpp fixed_size_allocator.cpp leaf.cpp  value.cpp iterator.cpp row_id_set.cpp -o test_ART_inline_prefix_01.exe
+./test_ART_inline_prefix_01.exe [key count]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "art.hpp"
+#include "artkey.hpp"
+#include "common.hpp"
+#include "iterator.hpp"
+#include "leaf.hpp"
+#include "logger.hpp"
+#include "node.hpp"
+#include "node4.hpp"
+#include "value.hpp"
+
+using namespace duckart;
+// Global logger instance
+Logger g_logger("duckart.log", Logger::ERROR);
+
+// Lookups, Search and a full scan against the expected keys
+static bool Check(ART &art, const std::map<std::string, idx_t> &expected, const std::vector<std::string> &all) {
+    for (auto &s : all) {
+        auto key = ARTKey::CreateARTKey(s.c_str());
+        auto it = expected.find(s);
+        idx_t row_id;
+        auto found = art.LookupRowId(key, row_id);
+        auto searched = art.Search(*art.root, key, 0);
+        if (found != (it != expected.end()) || (found && row_id != it->second) ||
+            (searched.getTag() == NType::LEAF_INLINED) != found) {
+            std::cout << "lookup of " << s << " is wrong" << std::endl;
+            return false;
+        }
+    }
+    ART::Iterator it(art);
+    auto pos = expected.begin();
+    for (auto valid = it.First(); valid; valid = it.Next(), pos++) {
+        if (pos == expected.end()) {
+            std::cout << "scan continues behind the last key" << std::endl;
+            return false;
+        }
+        auto key = ARTKey::CreateARTKey(pos->first.c_str());
+        auto &current = it.GetKey();
+        if (current.Size() != key.len || std::memcmp(current.Data(), key.data, key.len) != 0 ||
+            it.GetRowId() != pos->second) {
+            std::cout << "scan is wrong at " << pos->first << std::endl;
+            return false;
+        }
+    }
+    if (pos != expected.end()) {
+        std::cout << "scan ends before " << pos->first << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Keys with shared stems of every length around INLINE_PREFIX_SIZE, so that inner nodes
+// have inline prefixes and prefix chains, and splits and merges move prefixes between both
+static bool CheckPrefixLengths() {
+    std::mt19937_64 rng(3);
+    std::vector<std::string> all;
+    for (idx_t i = 0; i < 30000; i++) {
+        auto stem = std::string(rng() % (3 * INLINE_PREFIX_SIZE), 'a' + rng() % 2);
+        all.push_back(stem + std::string(1, 'c' + rng() % 3) + std::string(rng() % 25, 'e') + std::to_string(rng() % 50));
+    }
+    std::sort(all.begin(), all.end());
+    all.erase(std::unique(all.begin(), all.end()), all.end());
+    std::shuffle(all.begin(), all.end(), rng);
+
+    ART art;
+    std::map<std::string, idx_t> expected;
+    for (idx_t i = 0; i < all.size(); i++) {
+        Node leaf;
+        Leaf::NewInlined(art, leaf, i);
+        art.Insert(*art.root, ARTKey::CreateARTKey(all[i].c_str()), leaf, 0);
+        expected[all[i]] = i;
+    }
+    if (!Check(art, expected, all)) {
+        return false;
+    }
+
+    // deleting compresses Node4s into their children, which concatenates the prefixes
+    std::shuffle(all.begin(), all.end(), rng);
+    for (idx_t i = 0; i < all.size(); i++) {
+        art.Delete(*art.root, ARTKey::CreateARTKey(all[i].c_str()), 0);
+        expected.erase(all[i]);
+        if (i % (all.size() / 8) == 0 && !Check(art, expected, all)) {
+            return false;
+        }
+    }
+    if (!Check(art, expected, all)) {
+        return false;
+    }
+    return art.GetAllocator(NType::PREFIX).GetUsed() == 0;
+}
+
+// Lookups in a tree of 64-bit keys whose every other byte is zero, such that every inner
+// node below the root has a one-byte prefix
+int main(int argc, char **argv) {
+    if (sizeof(Node4) != 64) {
+        std::cout << "a Node4 does not fit into a cache line" << std::endl;
+        return 1;
+    }
+    if (!CheckPrefixLengths()) {
+        return 1;
+    }
+
+    const idx_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 4000000;
+    std::mt19937_64 rng(42);
+    std::vector<uint64_t> values(count);
+    for (auto &v : values) {
+        v = rng() & 0xFF00FF00FF00FFFFULL;
+    }
+    ART art;
+    for (idx_t i = 0; i < count; i++) {
+        Node leaf;
+        Leaf::NewInlined(art, leaf, i);
+        art.Insert(*art.root, StackARTKey<uint64_t>(values[i]), leaf, 0);
+    }
+    std::shuffle(values.begin(), values.end(), rng);
+    idx_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (auto v : values) {
+        idx_t row_id;
+        found += art.LookupRowId(StackARTKey<uint64_t>(v), row_id);
+    }
+    auto lookup_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    if (found != count) {
+        std::cout << "lookups found " << found << " of " << count << " keys" << std::endl;
+        return 1;
+    }
+    std::cout << count << " keys, LookupRowId: " << lookup_ns / count << " ns/op, "
+              << art.GetAllocator(NType::PREFIX).GetUsed() << " prefix nodes" << std::endl;
+
+    std::cout << "inline prefix test passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,161 @@
+/*
+g++ -std=c++20 -O2 -I./include test_ART_inlined_leaf_01.cpp  artkey.cpp  node.cpp art.cpp node4.cpp node16.cpp node48.cpp node256.cpp prefix.cpp fixed_size_allocator.cpp leaf.cpp  value.cpp iterator.cpp -o test_ART_inlined_leaf_01.exe
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "art.hpp"
+#include "artkey.hpp"
+#include "common.hpp"
+#include "iterator.hpp"
+#include "leaf.hpp"
+#include "logger.hpp"
+#include "node.hpp"
+#include "value.hpp"
+
+using namespace duckart;
+// Global logger instance
+Logger g_logger("duckart.log", Logger::ERROR);
+
+static void InsertRowId(ART &art, uint64_t k, idx_t row_id) {
+    Node leaf;
+    Leaf::NewInlined(art, leaf, row_id);
+    art.Insert(*art.root, ARTKey::CreateARTKey<uint64_t>(k), leaf, 0);
+}
+
+static idx_t UsedSlots(const ART &art) {
+    idx_t used = 0;
+    for (auto &allocator : art.allocators) {
+        used += allocator->GetUsed();
+    }
+    return used;
+}
+
+// Unique integer keys that map to row ids, in inlined leaves and in Leaf slots
+int main() {
+    const idx_t count = 200000;
+
+    std::mt19937_64 rng(42);
+    std::vector<uint64_t> keys(count);
+    for (auto &k : keys) {
+        // a narrow range, so that keys share prefixes and end at every depth
+        k = rng() % (count * 4);
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    std::shuffle(keys.begin(), keys.end(), rng);
+
+    ART inlined;
+    ART leaves;
+    for (idx_t i = 0; i < keys.size(); i++) {
+        InsertRowId(inlined, keys[i], i);
+        Node leaf;
+        Leaf::New(leaves, leaf, Value::CreateValue<uint64_t>(i));
+        leaves.Insert(*leaves.root, ARTKey::CreateARTKey<uint64_t>(keys[i]), leaf, 0);
+    }
+    if (inlined.GetAllocator(NType::LEAF).GetUsed() != 0) {
+        std::cout << "inlined leaves allocated Leaf slots" << std::endl;
+        return 1;
+    }
+    std::cout << "slots: " << UsedSlots(inlined) << " with inlined leaves, " << UsedSlots(leaves)
+              << " with Leaf slots" << std::endl;
+
+    // every key finds its row id, in Lookup, Search and the iterator
+    for (idx_t i = 0; i < keys.size(); i++) {
+        auto key = ARTKey::CreateARTKey<uint64_t>(keys[i]);
+        idx_t row_id;
+        if (!inlined.LookupRowId(key, row_id) || row_id != i || inlined.Lookup(key)) {
+            std::cout << "lookup of key " << keys[i] << " failed" << std::endl;
+            return 1;
+        }
+        auto leaf = inlined.Search(*inlined.root, key, 0);
+        if (leaf.getTag() != NType::LEAF_INLINED || Leaf::GetRowId(leaf) != i) {
+            std::cout << "search of key " << keys[i] << " failed" << std::endl;
+            return 1;
+        }
+    }
+    idx_t row_id;
+    if (inlined.LookupRowId(ARTKey::CreateARTKey<uint64_t>(count * 4), row_id)) {
+        std::cout << "lookup of a missing key succeeded" << std::endl;
+        return 1;
+    }
+    auto sorted = keys;
+    std::sort(sorted.begin(), sorted.end());
+    ART::Iterator it(inlined);
+    idx_t pos = 0;
+    for (auto valid = it.First(); valid; valid = it.Next(), pos++) {
+        if (pos >= sorted.size() || !(it.GetKey().ToARTKey() == ARTKey::CreateARTKey<uint64_t>(sorted[pos])) ||
+            keys[it.GetRowId()] != sorted[pos]) {
+            std::cout << "iterator is wrong at position " << pos << std::endl;
+            return 1;
+        }
+    }
+    if (pos != sorted.size()) {
+        std::cout << "iterator visited " << pos << " of " << sorted.size() << " keys" << std::endl;
+        return 1;
+    }
+
+    // the lookup skips the Leaf slot and its value
+    const idx_t rounds = 5;
+    auto start = std::chrono::steady_clock::now();
+    idx_t sum = 0;
+    for (idx_t r = 0; r < rounds; r++) {
+        for (auto k : keys) {
+            inlined.LookupRowId(ARTKey::CreateARTKey<uint64_t>(k), row_id);
+            sum += row_id;
+        }
+    }
+    auto inlined_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    for (idx_t r = 0; r < rounds; r++) {
+        for (auto k : keys) {
+            sum += Value::ExtractValue<uint64_t>(const_cast<Value &>(*leaves.Lookup(ARTKey::CreateARTKey<uint64_t>(k))));
+        }
+    }
+    auto leaves_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "LookupRowId: " << inlined_ns / (rounds * keys.size()) << " ns/op Lookup: "
+              << leaves_ns / (rounds * keys.size()) << " ns/op (" << sum % 10 << ")" << std::endl;
+
+    // updates replace the row id, and a Leaf can replace an inlined leaf
+    InsertRowId(inlined, keys[0], 0);
+    InsertRowId(inlined, keys[1], 12345);
+    Node leaf;
+    Leaf::New(inlined, leaf, Value::CreateValue<uint64_t>(7));
+    inlined.Insert(*inlined.root, ARTKey::CreateARTKey<uint64_t>(keys[2]), leaf, 0);
+    if (!inlined.LookupRowId(ARTKey::CreateARTKey<uint64_t>(keys[0]), row_id) || row_id != 0 ||
+        !inlined.LookupRowId(ARTKey::CreateARTKey<uint64_t>(keys[1]), row_id) || row_id != 12345 ||
+        Value::ExtractValue<uint64_t>(const_cast<Value &>(*inlined.Lookup(ARTKey::CreateARTKey<uint64_t>(keys[2])))) != 7) {
+        std::cout << "update failed" << std::endl;
+        return 1;
+    }
+
+    // deletes of every other key collapse nodes into prefix chains ahead of inlined leaves
+    for (idx_t i = 0; i < keys.size(); i += 2) {
+        if (!inlined.Delete(*inlined.root, ARTKey::CreateARTKey<uint64_t>(keys[i]), 0)) {
+            std::cout << "delete of key " << keys[i] << " failed" << std::endl;
+            return 1;
+        }
+    }
+    inlined.Vacuum();
+    for (idx_t i = 3; i < keys.size(); i++) {
+        auto found = inlined.LookupRowId(ARTKey::CreateARTKey<uint64_t>(keys[i]), row_id);
+        if (found != (i % 2 == 1) || (found && row_id != i)) {
+            std::cout << "lookup after delete of key " << keys[i] << " failed" << std::endl;
+            return 1;
+        }
+    }
+    for (idx_t i = 1; i < keys.size(); i += 2) {
+        inlined.Delete(*inlined.root, ARTKey::CreateARTKey<uint64_t>(keys[i]), 0);
+    }
+    if (UsedSlots(inlined) != 0) {
+        std::cout << UsedSlots(inlined) << " slots left after deleting all keys" << std::endl;
+        return 1;
+    }
+
+    std::cout << "inlined leaf test passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,92 @@
+/*
+g++ -std=c++20 -I./include test_ART_iterator_01.cpp  artkey.cpp  node.cpp art.cpp node4.cpp node16.cpp node48.cpp node256.cpp prefix.cpp fixed_size_allocator.cpp leaf.cpp  value.cpp iterator.cpp -o test_ART_iterator_01.exe
+*/
+
+#include <iostream>
+#include <vector>
+
+#include "art.hpp"
+#include "artkey.hpp"
+#include "common.hpp"
+#include "iterator.hpp"
+#include "leaf.hpp"
+#include "logger.hpp"
+#include "node.hpp"
+#include "value.hpp"
+
+using namespace duckart;
+// Global logger instance
+Logger g_logger("duckart.log", Logger::ERROR);
+
+int main() {
+    ART art;
+    Node &root = *art.root;
+
+    ART::Iterator it(art);
+    if (it.First() || it.LowerBound(ARTKey::CreateARTKey<uint32_t>(0))) {
+        std::cout << "empty tree has a key" << std::endl;
+        return 1;
+    }
+
+    // every third key in [0, 3000), spread over Node4 to Node256
+    for (uint32_t i = 0; i < 3000; i += 3) {
+        Node leaf;
+        Leaf::New(art, leaf, Value::CreateValue(i));
+        art.Insert(root, ARTKey::CreateARTKey<uint32_t>(i), leaf, 0);
+    }
+
+    // forward and backward iteration
+    uint32_t expected = 0;
+    for (bool ok = it.First(); ok; ok = it.Next()) {
+        auto value = Value::ExtractValue<uint32_t>(const_cast<Value &>(it.GetValue()));
+        auto key = it.GetKey().ToARTKey();
+        if (value != expected || !(key == ARTKey::CreateARTKey<uint32_t>(expected))) {
+            std::cout << "forward iteration: expected " << expected << ", got " << value << std::endl;
+            return 1;
+        }
+        expected += 3;
+    }
+    if (expected != 3000) {
+        std::cout << "forward iteration stopped at " << expected << std::endl;
+        return 1;
+    }
+    for (bool ok = it.Last(); ok; ok = it.Prev()) {
+        expected -= 3;
+        if (Value::ExtractValue<uint32_t>(const_cast<Value &>(it.GetValue())) != expected) {
+            std::cout << "backward iteration: expected " << expected << std::endl;
+            return 1;
+        }
+    }
+
+    // bounds
+    for (uint32_t i = 0; i < 3005; i++) {
+        auto key = ARTKey::CreateARTKey<uint32_t>(i);
+        uint32_t lower = (i + 2) / 3 * 3;
+        uint32_t upper = (i / 3 + 1) * 3;
+        bool ok = it.LowerBound(key);
+        if (ok != (lower < 3000) || (ok && Value::ExtractValue<uint32_t>(const_cast<Value &>(it.GetValue())) != lower)) {
+            std::cout << "LowerBound(" << i << ") failed" << std::endl;
+            return 1;
+        }
+        ok = it.UpperBound(key);
+        if (ok != (upper < 3000) || (ok && Value::ExtractValue<uint32_t>(const_cast<Value &>(it.GetValue())) != upper)) {
+            std::cout << "UpperBound(" << i << ") failed" << std::endl;
+            return 1;
+        }
+    }
+
+    // range scan over [100, 200]
+    std::vector<uint32_t> result;
+    auto count = it.Scan(ARTKey::CreateARTKey<uint32_t>(100), ARTKey::CreateARTKey<uint32_t>(200),
+                         [&](const IteratorKey &, const Value &value) {
+                             result.push_back(Value::ExtractValue<uint32_t>(const_cast<Value &>(value)));
+                             return true;
+                         });
+    if (count != 33 || result.size() != 33 || result.front() != 102 || result.back() != 198) {
+        std::cout << "Scan returned " << count << " keys" << std::endl;
+        return 1;
+    }
+
+    std::cout << "iterator test passed" << std::endl;
+    return 0;
+}
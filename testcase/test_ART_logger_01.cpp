@@ -0,0 +1,105 @@
+/*
+g++ -std=c++20 -O2 -I./include test_ART_logger_01.cpp -o test_ART_logger_01.exe -lpthread
+./test_ART_logger_01.exe [lines per thread]
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logger.hpp"
+
+// Global logger instance
+Logger g_logger("duckart.log", Logger::ERROR);
+
+static const char *LOG_PATH = "test_ART_logger_01.log";
+static const size_t THREADS = 4;
+
+//! Logs the lines "thread <thread> line <i>" for i in [0, count)
+static void LogLines(Logger &logger, size_t thread, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        logger.info("thread " + std::to_string(thread) + " line " + std::to_string(i), __FILE__, __FUNCTION__,
+                    __LINE__);
+    }
+}
+
+//! Checks that the file holds lines lines of each of the first THREADS threads, and 10 of each
+//! of the rounds * THREADS threads after them, each thread's in the order it logged them
+static bool CheckFile(size_t lines, size_t rounds) {
+    std::ifstream file(LOG_PATH);
+    std::vector<size_t> next(THREADS * (rounds + 1), 0);
+    std::string line;
+    while (std::getline(file, line)) {
+        auto pos = line.find("()] thread ");
+        size_t thread, i;
+        if (pos == std::string::npos ||
+            std::sscanf(line.c_str() + pos, "()] thread %zu line %zu", &thread, &i) != 2 || thread >= next.size()) {
+            std::cout << "unexpected line: " << line << std::endl;
+            return false;
+        }
+        if (i != next[thread]) {
+            std::cout << "line out of order: " << line << std::endl;
+            return false;
+        }
+        next[thread]++;
+    }
+    for (size_t t = 0; t < next.size(); t++) {
+        auto expected = t < THREADS ? lines : 10;
+        if (next[t] != expected) {
+            std::cout << "thread " << t << " has " << next[t] << " lines, expected " << expected << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// An ASYNC logger writes the lines of all threads, each thread's in order, once they flush and
+// once the logger is destroyed, and the threads that exited hand their rings to the next ones
+int main(int argc, char **argv) {
+    const size_t lines = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 20000;
+    const size_t rounds = 50;
+    std::remove(LOG_PATH);
+    {
+        Logger logger(LOG_PATH, Logger::INFO, Logger::ASYNC);
+        // more lines than fit into a ring, flushed by every thread
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < THREADS; t++) {
+            threads.emplace_back([&, t]() {
+                LogLines(logger, t, lines);
+                logger.flush();
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+        if (!CheckFile(lines, 0)) {
+            return 1;
+        }
+
+        // short-lived threads, each round takes over the rings of the previous one
+        for (size_t round = 1; round <= rounds; round++) {
+            threads.clear();
+            for (size_t t = 0; t < THREADS; t++) {
+                threads.emplace_back([&, round, t]() { LogLines(logger, round * THREADS + t, 10); });
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+        }
+        if (logger.getRingCount() > THREADS) {
+            std::cout << logger.getRingCount() << " rings for " << THREADS << " threads at a time" << std::endl;
+            return 1;
+        }
+    }
+    // the destructor wrote the lines that were not flushed
+    if (!CheckFile(lines, rounds)) {
+        return 1;
+    }
+    std::remove(LOG_PATH);
+    std::cout << "logger test passed" << std::endl;
+    return 0;
+}
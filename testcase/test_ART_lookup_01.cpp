@@ -0,0 +1,84 @@
+/*
+g++ -std=c++20 -O2 -I./include test_ART_lookup_01.cpp  artkey.cpp  node.cpp art.cpp node4.cpp node16.cpp node48.cpp node256.cpp prefix.cpp fixed_size_allocator.cpp leaf.cpp  value.cpp -o test_ART_lookup_01.exe
+*/
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "art.hpp"
+#include "artkey.hpp"
+#include "common.hpp"
+#include "leaf.hpp"
+#include "logger.hpp"
+#include "node.hpp"
+#include "value.hpp"
+
+using namespace duckart;
+// Global logger instance
+Logger g_logger("duckart.log", Logger::ERROR);
+
+// Compares the recursive Search with the read-only Lookup on the same tree
+int main() {
+    const idx_t count = 1000000;
+    const idx_t rounds = 5;
+
+    ART art;
+    Node &root = *art.root;
+
+    std::mt19937_64 rng(42);
+    std::vector<uint64_t> values(count);
+    for (auto &v : values) {
+        v = rng();
+    }
+    for (auto v : values) {
+        Node leaf;
+        Leaf::New(art, leaf, Value::CreateValue(v));
+        art.Insert(root, ARTKey::CreateARTKey<uint64_t>(v), leaf, 0);
+    }
+
+    // probe in random order, half of the probes miss
+    std::vector<ARTKey> probes;
+    probes.reserve(count);
+    for (idx_t i = 0; i < count; i++) {
+        auto v = (i % 2 == 0) ? values[rng() % count] : rng();
+        probes.push_back(ARTKey::CreateARTKey<uint64_t>(v));
+    }
+
+    // verify that both return the same results
+    for (auto &key : probes) {
+        auto node = art.Search(root, key, 0);
+        auto value = art.Lookup(key);
+        if ((node.getTag() == NType::LEAF) != (value != nullptr)) {
+            std::cout << "Search and Lookup disagree" << std::endl;
+            return 1;
+        }
+        if (value && &Node::RefMutable<Leaf>(art, node, NType::LEAF).value != value) {
+            std::cout << "Search and Lookup return different leaves" << std::endl;
+            return 1;
+        }
+    }
+
+    idx_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (idx_t r = 0; r < rounds; r++) {
+        for (auto &key : probes) {
+            found += art.Search(root, key, 0).getTag() == NType::LEAF;
+        }
+    }
+    auto search_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (idx_t r = 0; r < rounds; r++) {
+        for (auto &key : probes) {
+            found += art.Lookup(key) != nullptr;
+        }
+    }
+    auto lookup_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "found: " << found << std::endl;
+    std::cout << "Search: " << search_ns / (rounds * count) << " ns/op" << std::endl;
+    std::cout << "Lookup: " << lookup_ns / (rounds * count) << " ns/op" << std::endl;
+    return 0;
+}
@@ -0,0 +1,142 @@
+/*
+g++ -std=c++20 -O2 -I./include test_ART_lookup_batch_01.cpp  artkey.cpp  node.cpp art.cpp node4.cpp node16.cpp node48.cpp node256.cpp prefix.cpp fixed_size_allocator.cpp leaf.cpp  value.cpp row_id_set.cpp key_batch.cpp -o test_ART_lookup_batch_01.exe
+./test_ART_lookup_batch_01.exe [key count]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "art.hpp"
+#include "artkey.hpp"
+#include "common.hpp"
+#include "key_batch.hpp"
+#include "leaf.hpp"
+#include "logger.hpp"
+#include "node.hpp"
+#include "value.hpp"
+
+using namespace duckart;
+// Global logger instance
+Logger g_logger("duckart.log", Logger::ERROR);
+
+// LookupBatch against Lookup on a tree of string keys with Leaf values, prefix chains of
+// inner nodes and leaves, and row id sets
+static bool CheckStrings() {
+    std::mt19937_64 rng(7);
+    std::vector<std::string> strs;
+    for (idx_t i = 0; i < 20000; i++) {
+        strs.push_back(std::string(rng() % 40, 'a' + rng() % 2) + std::to_string(rng() % 1000));
+    }
+
+    ART values;
+    ART row_ids;
+    for (idx_t i = 0; i < strs.size(); i++) {
+        auto key = ARTKey::CreateARTKey(strs[i].c_str());
+        if (i % 2 == 0) {
+            Node leaf;
+            Leaf::New(values, leaf, Value::CreateValue<uint64_t>(i));
+            values.Insert(*values.root, key, leaf, 0);
+        }
+        // every third key has more than one row id
+        row_ids.AddRowId(key, i);
+        if (i % 3 == 0) {
+            row_ids.AddRowId(key, i + 1);
+        }
+    }
+
+    // present and missing keys, in a batch that is not a multiple of the group size
+    std::vector<ARTKey> keys;
+    for (auto &s : strs) {
+        keys.push_back(ARTKey::CreateARTKey(s.c_str()));
+        keys.push_back(ARTKey::CreateARTKey((s + "x").c_str()));
+    }
+    keys.push_back(ARTKey::CreateARTKey(""));
+    std::vector<const Value *> found_values(keys.size());
+    std::vector<idx_t> found_row_ids(keys.size());
+    values.LookupBatch(keys.data(), keys.size(), found_values.data());
+    auto found = row_ids.LookupRowIdBatch(keys.data(), keys.size(), found_row_ids.data());
+    idx_t expected_found = 0;
+    for (idx_t i = 0; i < keys.size(); i++) {
+        idx_t row_id;
+        auto has_row_id = row_ids.LookupRowId(keys[i], row_id);
+        expected_found += has_row_id;
+        if (found_values[i] != values.Lookup(keys[i]) || (found_row_ids[i] != INVALID_INDEX) != has_row_id ||
+            (has_row_id && found_row_ids[i] != row_id)) {
+            std::cout << "batch lookup of string key " << i << " is wrong" << std::endl;
+            return false;
+        }
+    }
+    if (found != expected_found) {
+        std::cout << "batch lookup found " << found << " of " << expected_found << " keys" << std::endl;
+        return false;
+    }
+
+    ART empty;
+    const Value *value;
+    empty.LookupBatch(keys.data(), 1, &value);
+    return value == nullptr;
+}
+
+// Probes of a tree far larger than the last-level cache, one key at a time and in batches
+int main(int argc, char **argv) {
+    if (!CheckStrings()) {
+        return 1;
+    }
+
+    const idx_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 8000000;
+    const idx_t vector_size = 2048;
+    std::mt19937_64 rng(42);
+    std::vector<uint64_t> values(count);
+    for (auto &v : values) {
+        v = rng();
+    }
+    ART art;
+    for (idx_t i = 0; i < count; i++) {
+        Node leaf;
+        Leaf::NewInlined(art, leaf, i);
+        art.Insert(*art.root, StackARTKey<uint64_t>(values[i]), leaf, 0);
+    }
+
+    // the probe side: the keys in random order, and as many missing keys
+    std::vector<uint64_t> probes(values);
+    for (idx_t i = 0; i < count / 4; i++) {
+        probes.push_back(rng());
+    }
+    std::shuffle(probes.begin(), probes.end(), rng);
+    ARTKeyBatch batch(probes.size());
+    batch.AddColumn<uint64_t>(probes.data());
+    auto &keys = batch.Encode();
+
+    std::vector<idx_t> single(keys.size());
+    auto start = std::chrono::steady_clock::now();
+    for (idx_t i = 0; i < keys.size(); i++) {
+        if (!art.LookupRowId(keys[i], single[i])) {
+            single[i] = INVALID_INDEX;
+        }
+    }
+    auto single_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<idx_t> batched(keys.size());
+    idx_t found = 0;
+    start = std::chrono::steady_clock::now();
+    for (idx_t i = 0; i < keys.size(); i += vector_size) {
+        found += art.LookupRowIdBatch(keys.data() + i, MinValue(vector_size, keys.size() - i), batched.data() + i);
+    }
+    auto batch_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    if (batched != single || found != count) {
+        std::cout << "batch lookups differ from single lookups" << std::endl;
+        return 1;
+    }
+    std::cout << count << " keys, LookupRowId: " << single_ns / keys.size()
+              << " ns/op LookupRowIdBatch: " << batch_ns / keys.size() << " ns/op (" << single_ns / batch_ns
+              << "x)" << std::endl;
+
+    std::cout << "lookup batch test passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,178 @@
+/*
+g++ -std=c++20 -O2 -I./include test_ART_mmap_01.cpp  artkey.cpp  node.cpp art.cpp node4.cpp node16.cpp node48.cpp node256.cpp prefix.cpp fixed_size_allocator.cpp leaf.cpp  value.cpp iterator.cpp row_id_set.cpp snapshot.cpp -o test_ART_mmap_01.exe -lpthread
+./test_ART_mmap_01.exe [key count]
+*/
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "art.hpp"
+#include "artkey.hpp"
+#include "common.hpp"
+#include "exception.hpp"
+#include "iterator.hpp"
+#include "leaf.hpp"
+#include "logger.hpp"
+#include "value.hpp"
+
+using namespace duckart;
+// Global logger instance
+Logger g_logger("duckart.log", Logger::ERROR);
+
+static const char *SNAPSHOT_PATH = "test_ART_mmap_01.bin";
+
+static double ElapsedUs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+//! Mostly inlined values, every 64th value lives in the value arena, and every 4096th is larger
+//! than the arena slabs
+static Value MakeValue(idx_t i, uint64_t n) {
+    if (i % 4096 == 0 || i % 64 == 0) {
+        Value value(i % 4096 == 0 ? 5000 : 100);
+        for (idx_t b = 0; b < value.GetSize(); b++) {
+            value[b] = static_cast<data_t>(n >> (b % 8));
+        }
+        return value;
+    }
+    return Value::CreateValue(n);
+}
+
+//! Drops the file from the page cache, so that the next accesses to its pages read the disk
+static void EvictFile(const char *path) {
+    auto fd = open(path, O_RDONLY);
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+static void GetFaults(idx_t &major, idx_t &minor) {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    major = usage.ru_majflt;
+    minor = usage.ru_minflt;
+}
+
+//! Looks up count random keys in the mapped tree, and reports the time and the page faults
+static bool MeasureLookups(const ART &art, const std::vector<ARTKey> &keys, const std::vector<Value> &values,
+                           idx_t count, const char *label) {
+    std::mt19937_64 rng(7);
+    idx_t major_before, minor_before, major_after, minor_after;
+    GetFaults(major_before, minor_before);
+    auto start = std::chrono::steady_clock::now();
+    for (idx_t i = 0; i < count; i++) {
+        auto k = rng() % keys.size();
+        auto value = art.Lookup(keys[k]);
+        if (!value || !(*value == values[k])) {
+            std::cout << "key " << k << " is missing in the mapped tree" << std::endl;
+            return false;
+        }
+    }
+    auto us = ElapsedUs(start);
+    GetFaults(major_after, minor_after);
+    auto major = major_after - major_before;
+    auto minor = minor_after - minor_before;
+    std::cout << label << ": " << count << " lookups, " << us * 1000 / count << " ns/op, " << major
+              << " major faults, " << minor << " minor faults";
+    if (major + minor > 0) {
+        std::cout << ", " << us / (major + minor) << " us per fault";
+    }
+    std::cout << std::endl;
+    return true;
+}
+
+// A mapped snapshot serves lookups and scans right away, and refuses modifications
+int main(int argc, char **argv) {
+    const idx_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    std::mt19937_64 rng(42);
+    std::unordered_set<uint64_t> seen;
+    std::vector<ARTKey> keys;
+    std::vector<Value> values;
+    while (keys.size() < count) {
+        auto n = rng();
+        if (seen.insert(n).second) {
+            keys.push_back(ARTKey::CreateARTKey<uint64_t>(n));
+            values.push_back(MakeValue(keys.size() - 1, n));
+        }
+    }
+    {
+        ART art;
+        art.ParallelBuild(keys, values);
+        art.Serialize(SNAPSHOT_PATH);
+    }
+    EvictFile(SNAPSHOT_PATH);
+
+    // cold: every page is read from the disk on its first access
+    ART art;
+    auto start = std::chrono::steady_clock::now();
+    auto bytes = art.Map(SNAPSHOT_PATH);
+    auto map_us = ElapsedUs(start);
+    if (!art.IsMapped() || !MeasureLookups(art, keys, values, 10000, "cold") ||
+        !MeasureLookups(art, keys, values, 10000, "warm")) {
+        return 1;
+    }
+
+    // every key and value is there, in key order
+    std::vector<idx_t> order(count);
+    for (idx_t i = 0; i < count; i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](idx_t l, idx_t r) { return keys[r] > keys[l]; });
+    ART::Iterator it(art);
+    idx_t visited = 0;
+    for (auto valid = it.First(); valid; valid = it.Next()) {
+        if (!(it.GetValue() == values[order[visited]])) {
+            std::cout << "the iterator visits key " << visited << " with a wrong value" << std::endl;
+            return 1;
+        }
+        visited++;
+    }
+    auto scanned = it.Scan(keys[order[count / 4]], keys[order[count / 2]],
+                           [](const IteratorKey &, const Value &) { return true; });
+    if (visited != count || scanned != count / 2 - count / 4 + 1) {
+        std::cout << "the iterator visits " << visited << " keys, the range scan " << scanned << std::endl;
+        return 1;
+    }
+    std::vector<const Value *> found(count);
+    art.LookupBatch(keys.data(), count, found.data());
+    for (idx_t i = 0; i < count; i++) {
+        if (!found[i] || !(*found[i] == values[i])) {
+            std::cout << "LookupBatch misses key " << i << std::endl;
+            return 1;
+        }
+    }
+
+    // a second tree maps the same file, the two share its pages
+    {
+        ART other;
+        other.Map(SNAPSHOT_PATH, true);
+        if (!MeasureLookups(other, keys, values, 10000, "populated")) {
+            return 1;
+        }
+    }
+
+    try {
+        art.Delete(*art.root, keys[0], 0);
+        std::cout << "a mapped tree is modified" << std::endl;
+        return 1;
+    } catch (InternalException &) {
+    }
+    if (!art.Lookup(keys[0])) {
+        return 1;
+    }
+    std::remove(SNAPSHOT_PATH);
+
+    std::cout << count << " keys, " << bytes / (1024.0 * 1024.0) << " MiB, Map: " << map_us << " us" << std::endl;
+    std::cout << "mmap test passed" << std::endl;
+    return 0;
+}
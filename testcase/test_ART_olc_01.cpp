@@ -0,0 +1,224 @@
+/*
+g++ -std=c++20 -O2 -I./include test_ART_olc_01.cpp  artkey.cpp  node.cpp art.cpp node4.cpp node16.cpp node48.cpp node256.cpp prefix.cpp fixed_size_allocator.cpp leaf.cpp  value.cpp olc.cpp -o test_ART_olc_01.exe -lpthread
+*/
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "art.hpp"
+#include "artkey.hpp"
+#include "common.hpp"
+#include "epoch.hpp"
+#include "logger.hpp"
+#include "value.hpp"
+#include "value_arena.hpp"
+
+using namespace duckart;
+// Global logger instance
+Logger g_logger("duckart.log", Logger::ERROR);
+
+// YCSB-style throughput of the concurrent operations: the tree is loaded with count keys,
+// then every thread runs ops operations of the workload on uniformly random keys
+struct Workload {
+    const char *name;
+    //! percentage of lookups, the rest are updates (inserts of existing keys)
+    idx_t read_percent;
+};
+
+//! Every 16th key has a value in the value arena
+static Value MakeValue(uint64_t k) {
+    if (k % 16 != 0) {
+        return Value::CreateValue(k);
+    }
+    Value value(40);
+    for (idx_t b = 0; b < value.GetSize(); b++) {
+        value[b] = static_cast<data_t>(k >> (b % 8));
+    }
+    return value;
+}
+
+// Threads insert, delete and look up keys of the same ranges, so that nodes grow, shrink and
+// compress under each other. Every thread owns every thread_count-th key and knows which of
+// its keys are in the tree, and once all keys are deleted the allocators hold no slots
+static bool CheckMixed(idx_t thread_count, idx_t ops) {
+    // dense keys share their inner nodes, scattered keys form Node4s with long prefixes
+    const idx_t key_count = 1 << 16;
+    std::vector<uint64_t> keys(2 * key_count);
+    for (idx_t i = 0; i < key_count; i++) {
+        keys[2 * i] = i;
+        keys[2 * i + 1] = (uint64_t(i + 1) << 40) | ((i * 0x9E3779B97F4A7C15ULL) & 0xFFFFFFFFFFULL);
+    }
+
+    ART art(true);
+    std::atomic<bool> failed{false};
+    std::vector<std::thread> threads;
+    for (idx_t t = 0; t < thread_count; t++) {
+        threads.emplace_back([&, t] {
+            std::mt19937_64 rng(t + 100);
+            std::vector<bool> present(keys.size());
+            Value value;
+            for (idx_t op = 0; op < ops && !failed; op++) {
+                auto i = (rng() % (keys.size() / thread_count)) * thread_count + t;
+                auto key = ARTKey::CreateARTKey<uint64_t>(keys[i]);
+                switch (rng() % 3) {
+                    case 0:
+                        if (art.ConcurrentInsert(key, MakeValue(keys[i])) == present[i]) {
+                            std::cout << "insert of key " << keys[i] << " disagrees with the tree" << std::endl;
+                            failed = true;
+                        }
+                        present[i] = true;
+                        break;
+                    case 1:
+                        if (art.ConcurrentDelete(key) != present[i]) {
+                            std::cout << "delete of key " << keys[i] << " disagrees with the tree" << std::endl;
+                            failed = true;
+                        }
+                        present[i] = false;
+                        break;
+                    default:
+                        if (art.ConcurrentLookup(key, value) != present[i] ||
+                            (present[i] && !(value == MakeValue(keys[i])))) {
+                            std::cout << "lookup of key " << keys[i] << " disagrees with the tree" << std::endl;
+                            failed = true;
+                        }
+                        // the keys of the other threads are there or not, with the right value
+                        auto other = keys[rng() % keys.size()];
+                        if (art.ConcurrentLookup(ARTKey::CreateARTKey<uint64_t>(other), value) &&
+                            !(value == MakeValue(other))) {
+                            std::cout << "key " << other << " has the wrong value" << std::endl;
+                            failed = true;
+                        }
+                }
+            }
+            for (idx_t i = t; i < keys.size(); i += thread_count) {
+                if (art.ConcurrentDelete(ARTKey::CreateARTKey<uint64_t>(keys[i])) != present[i]) {
+                    std::cout << "final delete of key " << keys[i] << " disagrees with the tree" << std::endl;
+                    failed = true;
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    if (failed) {
+        return false;
+    }
+
+    art.ReclaimRetired();
+    for (auto &allocator : art.allocators) {
+        allocator->FlushThreadCaches();
+        if (allocator->GetUsed() != 0) {
+            std::cout << "an allocator holds " << allocator->GetUsed() << " slots after all deletes" << std::endl;
+            return false;
+        }
+    }
+    for (auto &allocator : art.GetValueArena().GetAllocators()) {
+        allocator->FlushThreadCaches();
+    }
+    if ((!art.root->IsCleared() && art.root->getTag() != NType::NODE_DUMMY) || art.GetValueArena().GetUsedBytes() != 0) {
+        std::cout << "the tree is not empty after all deletes" << std::endl;
+        return false;
+    }
+    auto stats = art.GetEpochManager().GetStats();
+    std::cout << "mixed: " << thread_count << " threads, " << stats.retired << " retired nodes" << std::endl;
+    return true;
+}
+
+int main() {
+    if (!CheckMixed(1, 200000) || !CheckMixed(MaxValue<idx_t>(4, std::thread::hardware_concurrency()), 200000)) {
+        return 1;
+    }
+
+    const idx_t count = 1000000;
+    const idx_t ops = 1000000;
+    const Workload workloads[] = {{"A (50% read, 50% update)", 50}, {"B (95% read, 5% update)", 95}, {"C (100% read)", 100}};
+    const idx_t thread_counts[] = {1, 2, 4, 8};
+
+    ART art(true);
+    std::mt19937_64 rng(42);
+    std::vector<uint64_t> keys(count);
+    for (auto &k : keys) {
+        k = rng();
+    }
+
+    // the load phase inserts disjoint key ranges from all threads
+    auto load_threads = MaxValue<idx_t>(1, std::thread::hardware_concurrency());
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (idx_t t = 0; t < load_threads; t++) {
+        threads.emplace_back([&, t] {
+            for (idx_t i = t; i < count; i += load_threads) {
+                art.ConcurrentInsert(ARTKey::CreateARTKey<uint64_t>(keys[i]), Value::CreateValue(keys[i]));
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    auto load_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "load: " << load_threads << " threads, " << count / load_s / 1e6 << " M ops/s" << std::endl;
+
+    for (auto &workload : workloads) {
+        for (auto thread_count : thread_counts) {
+            threads.clear();
+            start = std::chrono::steady_clock::now();
+            for (idx_t t = 0; t < thread_count; t++) {
+                threads.emplace_back([&, t] {
+                    std::mt19937_64 thread_rng(t);
+                    Value value;
+                    for (idx_t i = 0; i < ops; i++) {
+                        auto k = keys[thread_rng() % count];
+                        auto key = ARTKey::CreateARTKey<uint64_t>(k);
+                        if (thread_rng() % 100 < workload.read_percent) {
+                            if (!art.ConcurrentLookup(key, value) || Value::ExtractValue<uint64_t>(value) != k) {
+                                std::cout << "lookup failed" << std::endl;
+                                std::exit(1);
+                            }
+                        } else {
+                            art.ConcurrentInsert(key, Value::CreateValue(k));
+                        }
+                    }
+                });
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+            auto s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << workload.name << ", " << thread_count << " threads: "
+                      << thread_count * ops / s / 1e6 << " M ops/s" << std::endl;
+        }
+    }
+
+    // the replaced leaves went through the limbo lists of the epoch manager
+    auto stats = art.GetEpochManager().GetStats();
+    std::cout << "retired: " << stats.retired << ", reclaimed: " << stats.reclaimed
+              << ", epoch advances: " << stats.advances << std::endl;
+    std::cout << "retire: " << stats.retire_ns / MaxValue<idx_t>(1, stats.retired) << " ns avg, "
+              << stats.max_retire_ns / 1e3 << " us max" << std::endl;
+    std::cout << "reclaim delay: " << stats.reclaim_delay_ns / MaxValue<idx_t>(1, stats.reclaimed) / 1e3
+              << " us avg, " << stats.max_reclaim_delay_ns / 1e3 << " us max" << std::endl;
+    // the threads of every phase take over the epoch states of the threads that exited before
+    auto max_threads = MaxValue<idx_t>(load_threads, thread_counts[3]) + 1;
+    if (art.GetEpochManager().GetThreadCount() > max_threads) {
+        std::cout << art.GetEpochManager().GetThreadCount() << " epoch states for at most " << max_threads
+                  << " threads at a time" << std::endl;
+        return 1;
+    }
+
+    // the allocations of the concurrent inserts go through the per-thread slot caches
+    const std::pair<const char *, NType> types[] = {
+        {"Leaf", NType::LEAF}, {"Prefix", NType::PREFIX}, {"Node4", NType::NODE_4}, {"Node16", NType::NODE_16}};
+    for (auto &type : types) {
+        auto cache = art.GetAllocator(type.second).GetThreadCacheStats();
+        std::cout << type.first << " cache: " << cache.allocations << " allocations ("
+                  << 100.0 * cache.allocation_hits / MaxValue<idx_t>(1, cache.allocations) << "% hits), "
+                  << cache.frees << " frees (" << 100.0 * cache.free_hits / MaxValue<idx_t>(1, cache.frees)
+                  << "% hits)" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,63 @@
+/*
+g++ -std=c++20 -O2 -I./include test_ART_parallel_build_01.cpp  artkey.cpp  node.cpp art.cpp node4.cpp node16.cpp node48.cpp node256.cpp prefix.cpp fixed_size_allocator.cpp leaf.cpp  value.cpp -o test_ART_parallel_build_01.exe -lpthread
+*/
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "art.hpp"
+#include "artkey.hpp"
+#include "common.hpp"
+#include "logger.hpp"
+#include "node.hpp"
+#include "value.hpp"
+
+using namespace duckart;
+// Global logger instance
+Logger g_logger("duckart.log", Logger::ERROR);
+
+// Measures ParallelBuild on unsorted keys with an increasing number of threads
+int main() {
+    const idx_t count = 4000000;
+
+    std::mt19937_64 rng(42);
+    std::unordered_set<uint64_t> seen;
+    std::vector<ARTKey> keys;
+    std::vector<Value> values;
+    keys.reserve(count);
+    values.reserve(count);
+    while (keys.size() < count) {
+        auto n = rng();
+        if (seen.insert(n).second) {
+            keys.push_back(ARTKey::CreateARTKey<uint64_t>(n));
+            values.push_back(Value::CreateValue(n));
+        }
+    }
+
+    double single_ms = 0;
+    idx_t max_threads = MaxValue<idx_t>(std::thread::hardware_concurrency(), 1);
+    for (idx_t threads = 1; threads <= max_threads; threads *= 2) {
+        auto start = std::chrono::steady_clock::now();
+        ART art;
+        art.ParallelBuild(keys, values, threads);
+        auto ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (threads == 1) {
+            single_ms = ms;
+        }
+
+        for (idx_t i = 0; i < count; i += 997) {
+            auto value = art.Lookup(keys[i]);
+            if (!value || !(*value == values[i])) {
+                std::cout << "key " << i << " is missing" << std::endl;
+                return 1;
+            }
+        }
+        std::cout << "threads: " << threads << ", " << ms << " ms, " << count / ms / 1000 << " M keys/s, speedup "
+                  << single_ms / ms << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,214 @@
+/*
+g++ -std=c++20 -O2 -I./include test_ART_prefix_segments_01.cpp  artkey.cpp  node.cpp art.cpp node4.cpp node16.cpp node48.cpp node256.cpp prefix.cpp fixed_size_allocator.cpp leaf.cpp  value.cpp iterator.cpp row_id_set.cpp -o test_ART_prefix_segments_01.exe
+./test_ART_prefix_segments_01.exe [key count]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "art.hpp"
+#include "artkey.hpp"
+#include "common.hpp"
+#include "iterator.hpp"
+#include "leaf.hpp"
+#include "logger.hpp"
+#include "node.hpp"
+#include "node4.hpp"
+#include "prefix.hpp"
+#include "value.hpp"
+
+using namespace duckart;
+// Global logger instance
+Logger g_logger("duckart.log", Logger::ERROR);
+
+static idx_t UsedSegments(const ART &art) {
+    idx_t used = 0;
+    for (uint8_t size_class = 0; size_class < PREFIX_SEGMENT_CLASSES; size_class++) {
+        used += art.GetPrefixAllocator(size_class).GetUsed();
+    }
+    return used;
+}
+
+// URL-like keys of 60 to 300 bytes with long shared stems
+static std::string RandomUrl(std::mt19937_64 &rng) {
+    static const char *hosts[] = {"https://www.example.com/", "https://static.cdn.example.org/assets/",
+                                  "http://intranet.corp.local/projects/"};
+    std::string s = hosts[rng() % 3];
+    auto parts = 2 + rng() % 10;
+    for (idx_t p = 0; p < parts; p++) {
+        s += "section-" + std::to_string(rng() % (p < 2 ? 10 : 1000)) + "/";
+    }
+    return s + "index.html?session=" + std::to_string(rng() % 100000);
+}
+
+// Lookups, Search and a full scan against the expected keys
+static bool Check(ART &art, const std::map<std::string, idx_t> &expected, const std::vector<std::string> &all) {
+    for (auto &s : all) {
+        auto key = ARTKey::CreateARTKey(s.c_str());
+        auto it = expected.find(s);
+        idx_t row_id;
+        auto found = art.LookupRowId(key, row_id);
+        auto searched = art.Search(*art.root, key, 0);
+        if (found != (it != expected.end()) || (found && row_id != it->second) ||
+            (searched.getTag() == NType::LEAF_INLINED) != found) {
+            std::cout << "lookup of " << s << " is wrong" << std::endl;
+            return false;
+        }
+    }
+    ART::Iterator it(art);
+    auto pos = expected.begin();
+    for (auto valid = it.First(); valid; valid = it.Next(), pos++) {
+        if (pos == expected.end()) {
+            std::cout << "scan continues behind the last key" << std::endl;
+            return false;
+        }
+        auto key = ARTKey::CreateARTKey(pos->first.c_str());
+        auto &current = it.GetKey();
+        if (current.Size() != key.len || std::memcmp(current.Data(), key.data, key.len) != 0 ||
+            it.GetRowId() != pos->second) {
+            std::cout << "scan is wrong at " << pos->first << std::endl;
+            return false;
+        }
+    }
+    if (pos != expected.end()) {
+        std::cout << "scan ends before " << pos->first << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// A key takes one segment up to the largest segment capacity, and a chain of full segments
+// beyond it
+static bool CheckSegmentCount() {
+    const auto capacity = Prefix::Capacity(PREFIX_SEGMENT_CLASSES - 1);
+    for (idx_t len : {idx_t(1), idx_t(PREFIX_SIZE), idx_t(100), capacity - 1, capacity, 3 * capacity + 5}) {
+        ART art;
+        auto s = std::string(len - 1, 'u');
+        Node leaf;
+        Leaf::NewInlined(art, leaf, 0);
+        art.Insert(*art.root, ARTKey::CreateARTKey(s.c_str()), leaf, 0);
+        // the key ends in a null byte
+        auto expected = (len + capacity - 1) / capacity;
+        if (UsedSegments(art) != expected) {
+            std::cout << "a key of " << len << " bytes takes " << UsedSegments(art) << " prefix segments"
+                      << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// A leaf that a new key splits off keeps its segment, which only drops the bytes that the new
+// Node4 covers
+static bool CheckLeafSplit() {
+    ART art;
+    auto first = std::string(50, 'p') + "a" + std::string(100, 's');
+    auto second = std::string(50, 'p') + "b" + std::string(100, 's');
+    Node leaf;
+    Leaf::NewInlined(art, leaf, 0);
+    art.Insert(*art.root, ARTKey::CreateARTKey(first.c_str()), leaf, 0);
+    auto segment = *art.root;
+    Leaf::NewInlined(art, leaf, 1);
+    art.Insert(*art.root, ARTKey::CreateARTKey(second.c_str()), leaf, 0);
+
+    if (art.root->getTag() != NType::NODE_4) {
+        std::cout << "the split of a leaf does not create a Node4" << std::endl;
+        return false;
+    }
+    auto child = art.GetAllocator(NType::NODE_4).Get<const Node4>(*art.root)->GetChild('a');
+    if (!child.SameSlot(segment) ||
+        art.GetAllocator(NType::PREFIX).Get<const Prefix>(child)->count != first.size() - 50) {
+        std::cout << "the split of a leaf moves its key bytes" << std::endl;
+        return false;
+    }
+    idx_t row_id;
+    return art.LookupRowId(ARTKey::CreateARTKey(first.c_str()), row_id) && row_id == 0 &&
+           art.LookupRowId(ARTKey::CreateARTKey(second.c_str()), row_id) && row_id == 1;
+}
+
+// Inserts split long segments, deletes merge them again, and vacuum moves segments of every
+// size class
+static bool CheckUrls() {
+    std::mt19937_64 rng(5);
+    std::vector<std::string> all;
+    for (idx_t i = 0; i < 20000; i++) {
+        all.push_back(RandomUrl(rng));
+    }
+    std::sort(all.begin(), all.end());
+    all.erase(std::unique(all.begin(), all.end()), all.end());
+    std::shuffle(all.begin(), all.end(), rng);
+
+    ART art;
+    std::map<std::string, idx_t> expected;
+    for (idx_t i = 0; i < all.size(); i++) {
+        Node leaf;
+        Leaf::NewInlined(art, leaf, i);
+        art.Insert(*art.root, ARTKey::CreateARTKey(all[i].c_str()), leaf, 0);
+        expected[all[i]] = i;
+    }
+    if (!Check(art, expected, all)) {
+        return false;
+    }
+
+    std::shuffle(all.begin(), all.end(), rng);
+    for (idx_t i = 0; i < all.size(); i++) {
+        art.Delete(*art.root, ARTKey::CreateARTKey(all[i].c_str()), 0);
+        expected.erase(all[i]);
+        if (i % (all.size() / 4) == 0) {
+            while (!art.Vacuum(1000)) {
+            }
+            if (!Check(art, expected, all)) {
+                return false;
+            }
+        }
+    }
+    return Check(art, expected, all) && UsedSegments(art) == 0;
+}
+
+// Lookups in a tree of URL-like keys
+int main(int argc, char **argv) {
+    if (!CheckSegmentCount() || !CheckLeafSplit() || !CheckUrls()) {
+        return 1;
+    }
+
+    const idx_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    std::mt19937_64 rng(42);
+    std::vector<std::string> strs;
+    for (idx_t i = 0; i < count; i++) {
+        strs.push_back(RandomUrl(rng) + std::to_string(i));
+    }
+    std::vector<ARTKey> keys;
+    for (auto &s : strs) {
+        keys.push_back(ARTKey::CreateARTKey(s.c_str()));
+    }
+    ART art;
+    for (idx_t i = 0; i < count; i++) {
+        Node leaf;
+        Leaf::NewInlined(art, leaf, i);
+        art.Insert(*art.root, keys[i], leaf, 0);
+    }
+    std::shuffle(keys.begin(), keys.end(), rng);
+    idx_t found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (auto &key : keys) {
+        idx_t row_id;
+        found += art.LookupRowId(key, row_id);
+    }
+    auto lookup_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    if (found != count) {
+        std::cout << "lookups found " << found << " of " << count << " keys" << std::endl;
+        return 1;
+    }
+    std::cout << count << " keys, LookupRowId: " << lookup_ns / count << " ns/op, " << UsedSegments(art)
+              << " prefix segments" << std::endl;
+
+    std::cout << "prefix segment test passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,123 @@
+/*
+g++ -std=c++20 -O2 -I./include test_ART_row_ids_01.cpp  artkey.cpp  node.cpp art.cpp node4.cpp node16.cpp node48.cpp node256.cpp prefix.cpp fixed_size_allocator.cpp leaf.cpp  value.cpp iterator.cpp row_id_set.cpp -o test_ART_row_ids_01.exe
+*/
+
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "art.hpp"
+#include "artkey.hpp"
+#include "common.hpp"
+#include "iterator.hpp"
+#include "logger.hpp"
+#include "value_arena.hpp"
+
+using namespace duckart;
+// Global logger instance
+Logger g_logger("duckart.log", Logger::ERROR);
+
+static std::vector<idx_t> Scan(const ART &art, uint32_t k) {
+    std::vector<idx_t> row_ids;
+    art.ScanRowIds(ARTKey::CreateARTKey<uint32_t>(k), [&](idx_t row_id) {
+        row_ids.push_back(row_id);
+        return true;
+    });
+    return row_ids;
+}
+
+static idx_t UsedSlots(const ART &art) {
+    idx_t used = 0;
+    for (auto &allocator : art.allocators) {
+        used += allocator->GetUsed();
+    }
+    return used;
+}
+
+// A secondary index on a low-cardinality column: the keys have from one to thousands of
+// row ids, which grow and shrink through inlined leaves, arrays and nested trees
+int main() {
+    const uint32_t key_count = 64;
+    const idx_t ops = 200000;
+
+    ART art;
+    std::map<uint32_t, std::set<idx_t>> expected;
+    std::mt19937_64 rng(42);
+    for (idx_t op = 0; op < ops; op++) {
+        // skewed keys, so that some keys have many row ids and others only a few
+        auto k = static_cast<uint32_t>(rng() % key_count * (rng() % key_count) / key_count);
+        auto row_id = rng() % (k < 4 ? 4096 : 32);
+        auto key = ARTKey::CreateARTKey<uint32_t>(k);
+        if (rng() % 3 != 0) {
+            auto added = expected[k].insert(row_id).second;
+            if (art.AddRowId(key, row_id) != added) {
+                std::cout << "add of row id " << row_id << " to key " << k << " is wrong" << std::endl;
+                return 1;
+            }
+        } else {
+            auto removed = expected[k].erase(row_id) > 0;
+            if (art.RemoveRowId(key, row_id) != removed) {
+                std::cout << "remove of row id " << row_id << " from key " << k << " is wrong" << std::endl;
+                return 1;
+            }
+        }
+
+        if (op % 1000 == 0) {
+            for (auto &entry : expected) {
+                auto row_ids = Scan(art, entry.first);
+                if (row_ids != std::vector<idx_t>(entry.second.begin(), entry.second.end())) {
+                    std::cout << "row ids of key " << entry.first << " are wrong" << std::endl;
+                    return 1;
+                }
+            }
+        }
+    }
+
+    // the iterator visits the keys in order, with the row ids of each key
+    ART::Iterator it(art);
+    auto entry = expected.begin();
+    for (auto valid = it.First(); valid; valid = it.Next()) {
+        while (entry != expected.end() && entry->second.empty()) {
+            entry++;
+        }
+        std::vector<idx_t> row_ids;
+        it.ScanRowIds([&](idx_t row_id) {
+            row_ids.push_back(row_id);
+            return true;
+        });
+        if (entry == expected.end() || !(it.GetKey().ToARTKey() == ARTKey::CreateARTKey<uint32_t>(entry->first)) ||
+            row_ids != std::vector<idx_t>(entry->second.begin(), entry->second.end())) {
+            std::cout << "iterator is wrong" << std::endl;
+            return 1;
+        }
+        entry++;
+    }
+
+    // a scan stops when the callback returns false
+    idx_t visited = art.ScanRowIds(ARTKey::CreateARTKey<uint32_t>(0), [](idx_t) { return false; });
+    if (visited != (expected[0].empty() ? 0 : 1)) {
+        std::cout << "scan did not stop" << std::endl;
+        return 1;
+    }
+
+    art.Vacuum();
+    std::cout << "keys: " << expected.size() << ", row ids of key 0: " << Scan(art, 0).size()
+              << ", slots: " << UsedSlots(art) << std::endl;
+    for (auto &e : expected) {
+        for (auto row_id : e.second) {
+            if (!art.RemoveRowId(ARTKey::CreateARTKey<uint32_t>(e.first), row_id)) {
+                std::cout << "final remove failed" << std::endl;
+                return 1;
+            }
+        }
+    }
+    if (UsedSlots(art) != 0 || art.GetValueArena().GetUsedBytes() != 0) {
+        std::cout << UsedSlots(art) << " slots left after removing all row ids" << std::endl;
+        return 1;
+    }
+
+    std::cout << "row id test passed" << std::endl;
+    return 0;
+}
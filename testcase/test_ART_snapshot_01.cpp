@@ -0,0 +1,183 @@
+/*
+g++ -std=c++20 -O2 -I./include test_ART_snapshot_01.cpp  artkey.cpp  node.cpp art.cpp node4.cpp node16.cpp node48.cpp node256.cpp prefix.cpp fixed_size_allocator.cpp leaf.cpp  value.cpp iterator.cpp row_id_set.cpp snapshot.cpp -o test_ART_snapshot_01.exe -lpthread
+./test_ART_snapshot_01.exe [key count]
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "art.hpp"
+#include "artkey.hpp"
+#include "common.hpp"
+#include "exception.hpp"
+#include "leaf.hpp"
+#include "logger.hpp"
+#include "value.hpp"
+
+using namespace duckart;
+// Global logger instance
+Logger g_logger("duckart.log", Logger::ERROR);
+
+static const char *SNAPSHOT_PATH = "test_ART_snapshot_01.bin";
+
+static double ElapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+//! Mostly inlined values, every 64th value lives in the value arena, and every 4096th is larger
+//! than the arena slabs
+static Value MakeValue(idx_t i, uint64_t n) {
+    if (i % 4096 == 0) {
+        Value value(5000);
+        for (idx_t b = 0; b < value.GetSize(); b++) {
+            value[b] = static_cast<data_t>(n + b);
+        }
+        return value;
+    }
+    if (i % 64 == 0) {
+        Value value(100);
+        for (idx_t b = 0; b < value.GetSize(); b++) {
+            value[b] = static_cast<data_t>(n >> (b % 8));
+        }
+        return value;
+    }
+    return Value::CreateValue(n);
+}
+
+static bool CheckLookups(const ART &art, const std::vector<ARTKey> &keys, const std::vector<Value> &values) {
+    for (idx_t i = 0; i < keys.size(); i++) {
+        auto value = art.Lookup(keys[i]);
+        if (!value || !(*value == values[i])) {
+            std::cout << "key " << i << " is missing after the load" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// The row ids of non-unique keys, with arrays in the value arena and nested trees, survive
+// a snapshot
+static bool CheckRowIds() {
+    ART art;
+    for (uint32_t k = 0; k < 100; k++) {
+        for (idx_t row_id = 0; row_id < k * 3; row_id++) {
+            art.AddRowId(ARTKey::CreateARTKey<uint32_t>(k), row_id * 7 + k);
+        }
+    }
+    art.Serialize(SNAPSHOT_PATH, 2);
+
+    ART loaded;
+    loaded.Deserialize(SNAPSHOT_PATH, 2);
+    for (uint32_t k = 0; k < 100; k++) {
+        idx_t expected = 0;
+        auto count = loaded.ScanRowIds(ARTKey::CreateARTKey<uint32_t>(k), [&](idx_t row_id) {
+            return row_id == expected++ * 7 + k;
+        });
+        if (count != k * 3 || expected != k * 3) {
+            std::cout << "the row ids of key " << k << " are wrong after the load" << std::endl;
+            return false;
+        }
+    }
+    // the loaded tree keeps working
+    loaded.AddRowId(ARTKey::CreateARTKey<uint32_t>(1000), 1);
+    loaded.RemoveRowId(ARTKey::CreateARTKey<uint32_t>(99), 99 * 7 + 99);
+    idx_t row_id;
+    return loaded.LookupRowId(ARTKey::CreateARTKey<uint32_t>(1000), row_id) && row_id == 1;
+}
+
+// Files that are not snapshots, and trees that are not empty, are rejected
+static bool CheckErrors() {
+    auto file = std::fopen(SNAPSHOT_PATH, "wb");
+    std::fputs("not a snapshot, but long enough for a snapshot header", file);
+    std::fclose(file);
+    ART art;
+    try {
+        art.Deserialize(SNAPSHOT_PATH);
+        std::cout << "a file without snapshot header is loaded" << std::endl;
+        return false;
+    } catch (IOException &) {
+    }
+
+    Node leaf;
+    Leaf::New(art, leaf, Value::CreateValue<uint64_t>(1));
+    art.Insert(*art.root, ARTKey::CreateARTKey<uint64_t>(1), leaf, 0);
+    art.Serialize(SNAPSHOT_PATH);
+    try {
+        art.Deserialize(SNAPSHOT_PATH);
+        std::cout << "a snapshot is loaded into a tree with keys" << std::endl;
+        return false;
+    } catch (InternalException &) {
+    }
+    return art.Lookup(ARTKey::CreateARTKey<uint64_t>(1)) != nullptr;
+}
+
+// Loading a snapshot of count keys beats rebuilding the tree with Insert
+int main(int argc, char **argv) {
+    if (!CheckRowIds() || !CheckErrors()) {
+        return 1;
+    }
+
+    const idx_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    std::mt19937_64 rng(42);
+    std::unordered_set<uint64_t> seen;
+    std::vector<ARTKey> keys;
+    std::vector<Value> values;
+    while (keys.size() < count) {
+        auto n = rng();
+        if (seen.insert(n).second) {
+            keys.push_back(ARTKey::CreateARTKey<uint64_t>(n));
+            values.push_back(MakeValue(keys.size() - 1, n));
+        }
+    }
+
+    ART art;
+    auto start = std::chrono::steady_clock::now();
+    for (idx_t i = 0; i < count; i++) {
+        Node leaf;
+        Leaf::New(art, leaf, values[i]);
+        art.Insert(*art.root, keys[i], leaf, 0);
+    }
+    auto build_ms = ElapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    auto bytes = art.Serialize(SNAPSHOT_PATH);
+    auto write_ms = ElapsedMs(start);
+
+    ART loaded;
+    start = std::chrono::steady_clock::now();
+    if (loaded.Deserialize(SNAPSHOT_PATH) != bytes) {
+        std::cout << "the snapshot has the wrong size" << std::endl;
+        return 1;
+    }
+    auto read_ms = ElapsedMs(start);
+    if (!CheckLookups(loaded, keys, values)) {
+        return 1;
+    }
+
+    // the allocators of the loaded tree account for all slots, so deletes free everything
+    for (idx_t i = 0; i < count; i++) {
+        if (!loaded.Delete(*loaded.root, keys[i], 0)) {
+            std::cout << "key " << i << " cannot be deleted after the load" << std::endl;
+            return 1;
+        }
+    }
+    for (auto &allocator : loaded.allocators) {
+        if (allocator->GetUsed() != 0) {
+            std::cout << "the loaded tree leaks slots" << std::endl;
+            return 1;
+        }
+    }
+    std::remove(SNAPSHOT_PATH);
+
+    auto mb = bytes / (1024.0 * 1024.0);
+    std::cout << count << " keys, " << mb << " MiB, Insert: " << build_ms << " ms, Serialize: " << write_ms
+              << " ms (" << mb / write_ms * 1000 << " MiB/s), Deserialize: " << read_ms << " ms ("
+              << mb / read_ms * 1000 << " MiB/s), " << build_ms / read_ms << "x faster than Insert" << std::endl;
+    std::cout << "snapshot test passed" << std::endl;
+    return 0;
+}
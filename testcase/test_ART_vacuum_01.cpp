@@ -0,0 +1,152 @@
+/*
+g++ -std=c++20 -O2 -I./include test_ART_vacuum_01.cpp  artkey.cpp  node.cpp art.cpp node4.cpp node16.cpp node48.cpp node256.cpp prefix.cpp fixed_size_allocator.cpp leaf.cpp  value.cpp iterator.cpp row_id_set.cpp -o test_ART_vacuum_01.exe -lpthread
+./test_ART_vacuum_01.exe [key count]
+*/
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "art.hpp"
+#include "artkey.hpp"
+#include "common.hpp"
+#include "iterator.hpp"
+#include "leaf.hpp"
+#include "logger.hpp"
+#include "value.hpp"
+
+using namespace duckart;
+// Global logger instance
+Logger g_logger("duckart.log", Logger::ERROR);
+
+//! Mostly inlined values, every 64th value lives in the value arena
+static Value MakeValue(uint64_t n) {
+    if (n % 64 == 0) {
+        Value value(100);
+        for (idx_t b = 0; b < value.GetSize(); b++) {
+            value[b] = static_cast<data_t>(n >> (b % 8));
+        }
+        return value;
+    }
+    return Value::CreateValue(n);
+}
+
+static void Put(ART &art, uint64_t n) {
+    Node leaf;
+    Leaf::New(art, leaf, MakeValue(n));
+    art.Insert(*art.root, ARTKey::CreateARTKey<uint64_t>(n), leaf, 0);
+}
+
+//! Number of slots in the blocks of all node allocators
+static idx_t GetCapacity(const ART &art) {
+    idx_t capacity = 0;
+    for (auto &allocator : art.allocators) {
+        capacity += allocator->GetCapacity();
+    }
+    return capacity;
+}
+
+static bool CheckKeys(const ART &art, const std::unordered_map<uint64_t, bool> &keys) {
+    idx_t expected = 0;
+    for (auto &entry : keys) {
+        auto value = art.Lookup(ARTKey::CreateARTKey<uint64_t>(entry.first));
+        if (entry.second && (!value || !(*value == MakeValue(entry.first)))) {
+            std::cout << "key " << entry.first << " is missing after the vacuum" << std::endl;
+            return false;
+        }
+        if (!entry.second && value) {
+            std::cout << "deleted key " << entry.first << " is found after the vacuum" << std::endl;
+            return false;
+        }
+        expected += entry.second;
+    }
+    idx_t count = 0;
+    ART::Iterator it(art);
+    for (auto valid = it.First(); valid; valid = it.Next()) {
+        count++;
+    }
+    if (count != expected) {
+        std::cout << "the iterator visits " << count << " keys, expected " << expected << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Vacuum releases the blocks that deletes left sparse, in steps that inserts and deletes
+// interleave with, and the tree keeps all its keys
+int main(int argc, char **argv) {
+    const idx_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200000;
+    std::mt19937_64 rng(42);
+    //! Whether each key that was ever inserted is still in the tree
+    std::unordered_map<uint64_t, bool> keys;
+    std::vector<uint64_t> order;
+    ART art;
+    while (order.size() < count) {
+        auto n = rng();
+        if (keys.emplace(n, true).second) {
+            order.push_back(n);
+            Put(art, n);
+        }
+    }
+
+    // delete four out of five keys, so that every block is sparse
+    for (idx_t i = 0; i < count; i++) {
+        if (i % 5 != 0) {
+            art.Delete(*art.root, ARTKey::CreateARTKey<uint64_t>(order[i]), 0);
+            keys[order[i]] = false;
+        }
+    }
+    auto capacity = GetCapacity(art);
+
+    idx_t steps = 0;
+    for (; !art.Vacuum(1000); steps++) {
+        // new keys go into blocks that are not vacuumed, deleted keys may be in either
+        for (idx_t i = 0; i < 10; i++) {
+            auto n = rng();
+            if (keys.emplace(n, true).second) {
+                Put(art, n);
+            }
+            auto k = order[rng() % count];
+            if (keys[k]) {
+                art.Delete(*art.root, ARTKey::CreateARTKey<uint64_t>(k), 0);
+                keys[k] = false;
+            }
+        }
+    }
+    for (auto &allocator : art.allocators) {
+        if (allocator->IsVacuuming()) {
+            std::cout << "an allocator is still vacuuming" << std::endl;
+            return 1;
+        }
+    }
+    if (steps == 0 || GetCapacity(art) >= capacity * 3 / 4) {
+        std::cout << "vacuum only shrinks the capacity from " << capacity << " to " << GetCapacity(art) << " slots in "
+                  << steps << " steps" << std::endl;
+        return 1;
+    }
+    if (!CheckKeys(art, keys)) {
+        return 1;
+    }
+    auto vacuumed = GetCapacity(art);
+
+    // the tree works as before
+    for (auto &entry : keys) {
+        if (entry.second) {
+            art.Delete(*art.root, ARTKey::CreateARTKey<uint64_t>(entry.first), 0);
+            entry.second = false;
+        } else if (entry.first % 2 == 0) {
+            Put(art, entry.first);
+            entry.second = true;
+        }
+    }
+    if (!CheckKeys(art, keys)) {
+        return 1;
+    }
+
+    std::cout << count << " keys, capacity " << capacity << " slots before the vacuum, " << vacuumed
+              << " after " << steps << " steps" << std::endl;
+    std::cout << "vacuum test passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,115 @@
+/*
+g++ -std=c++20 -I./include test_ART_value_01.cpp  artkey.cpp  node.cpp art.cpp node4.cpp node16.cpp node48.cpp node256.cpp prefix.cpp fixed_size_allocator.cpp leaf.cpp  value.cpp -o test_ART_value_01.exe
+*/
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "art.hpp"
+#include "artkey.hpp"
+#include "common.hpp"
+#include "leaf.hpp"
+#include "logger.hpp"
+#include "node.hpp"
+#include "value.hpp"
+#include "value_arena.hpp"
+
+using namespace duckart;
+// Global logger instance
+Logger g_logger("duckart.log", Logger::ERROR);
+
+static Value MakeValue(uint32_t len, uint8_t seed) {
+    Value value(len);
+    for (uint32_t i = 0; i < len; i++) {
+        value[i] = static_cast<uint8_t>(seed + i);
+    }
+    return value;
+}
+
+static bool Insert(ART &art, uint32_t k, const Value &value) {
+    Node leaf;
+    Leaf::New(art, leaf, value);
+    return art.Insert(*art.root, ARTKey::CreateARTKey<uint32_t>(k), leaf, 0);
+}
+
+int main() {
+    // small values are inlined, so creating and copying them does not allocate
+    auto small = Value::CreateValue<uint64_t>(42);
+    auto copy = small;
+    if (!small.IsInlined() || !copy.IsInlined() || Value::ExtractValue<uint64_t>(copy) != 42) {
+        std::cout << "8-byte value is not inlined" << std::endl;
+        return 1;
+    }
+    auto str = Value::CreateValue("a string that does not fit inline");
+    if (str.IsInlined() || std::string(Value::ExtractValue<string_t>(str).GetData()) != "a string that does not fit inline") {
+        std::cout << "string value roundtrip failed" << std::endl;
+        return 1;
+    }
+
+    // values of every size class, and one larger than the largest class
+    ART art;
+    const std::vector<uint32_t> sizes = {0, 1, 8, 12, 13, 16, 17, 100, 1000, 4096, 5000};
+    for (uint32_t k = 0; k < sizes.size(); k++) {
+        Insert(art, k, MakeValue(sizes[k], k));
+    }
+    auto arena_bytes = art.GetValueArena().GetUsedBytes();
+    for (uint32_t k = 0; k < sizes.size(); k++) {
+        auto value = art.Lookup(ARTKey::CreateARTKey<uint32_t>(k));
+        if (!value || !(*value == MakeValue(sizes[k], k))) {
+            std::cout << "value of size " << sizes[k] << " is wrong" << std::endl;
+            return 1;
+        }
+    }
+
+    // updates within the same size class reuse the bytes of the leaf value
+    for (uint32_t k = 0; k < sizes.size(); k++) {
+        auto before = art.Lookup(ARTKey::CreateARTKey<uint32_t>(k))->GetData();
+        Insert(art, k, MakeValue(sizes[k], k + 100));
+        auto value = art.Lookup(ARTKey::CreateARTKey<uint32_t>(k));
+        if (value->GetData() != before || !(*value == MakeValue(sizes[k], k + 100))) {
+            std::cout << "update of size " << sizes[k] << " reallocated" << std::endl;
+            return 1;
+        }
+    }
+    if (art.GetValueArena().GetUsedBytes() != arena_bytes) {
+        std::cout << "updates changed the arena size" << std::endl;
+        return 1;
+    }
+
+    // an update into another size class moves the value
+    Insert(art, 6, MakeValue(200, 7));
+    if (!(*art.Lookup(ARTKey::CreateARTKey<uint32_t>(6)) == MakeValue(200, 7))) {
+        std::cout << "update into another size class failed" << std::endl;
+        return 1;
+    }
+
+    // updates between inlined, arena and owned values, in both directions
+    const std::vector<std::vector<uint32_t>> updates = {{4, 14}, {14, 4}, {14, 5000}, {5000, 14}, {5000, 8}};
+    for (uint32_t u = 0; u < updates.size(); u++) {
+        auto k = static_cast<uint32_t>(100 + u);
+        Insert(art, k, MakeValue(updates[u][0], u));
+        Insert(art, k, MakeValue(updates[u][1], u + 50));
+        auto value = art.Lookup(ARTKey::CreateARTKey<uint32_t>(k));
+        if (!value || !(*value == MakeValue(updates[u][1], u + 50)) ||
+            value->IsInlined() != (updates[u][1] <= Value::INLINE_SIZE)) {
+            std::cout << "update from size " << updates[u][0] << " to " << updates[u][1] << " is wrong" << std::endl;
+            return 1;
+        }
+    }
+
+    // deletes return the bytes to the arena
+    for (uint32_t k = 0; k < sizes.size(); k++) {
+        art.Delete(*art.root, ARTKey::CreateARTKey<uint32_t>(k), 0);
+    }
+    for (uint32_t u = 0; u < updates.size(); u++) {
+        art.Delete(*art.root, ARTKey::CreateARTKey<uint32_t>(100 + u), 0);
+    }
+    if (art.GetValueArena().GetUsedBytes() != 0) {
+        std::cout << "arena holds " << art.GetValueArena().GetUsedBytes() << " bytes after deleting all keys" << std::endl;
+        return 1;
+    }
+
+    std::cout << "value test passed" << std::endl;
+    return 0;
+}